@@ -2,12 +2,14 @@
 
 
 #include "../../wordgame_common.h"
+#include "../../wordgame_dictionary.h"
 #include <iostream>
 #include <windows.h>
 #include <tchar.h>
 #include <functional>
 #include <sstream>
 #include <map>
+#include <vector>
 
 
 /*
@@ -17,26 +19,34 @@
 */
 
 
-TCHAR eventName[2 * ARRAY_SIZE + 2];
 int32_t gameId = -1;	// game id, initially uninitialized
 
-GameState* gameState;
-Dictionary* dictionary;
+const GameState* gameState;	// board published by the server (seqlock, read with gameStateRead)
+const DictionaryHeader* dictionary;	// compiled dictionary image, bot mode only
+const DictionaryDirectory* dictionaryDirectory;	// current dictionary generation, published by the server
+uint32_t dictionaryGeneration = 0;	// generation of the mapped image
+const PlayerNameTable* playerNames;	// player names by ID, published by the server
+const LeaderboardPage* leaderboardPage;	// top players and every score, published by the server
 
 /* threads */
 HANDLE cliThread = INVALID_HANDLE_VALUE;
 HANDLE updateThread = INVALID_HANDLE_VALUE;
 HANDLE pipeThread = INVALID_HANDLE_VALUE;
+HANDLE eventsThread = INVALID_HANDLE_VALUE;
 
 /* pipes */
 HANDLE pipeHandle = INVALID_HANDLE_VALUE;
 HANDLE serverHandle = INVALID_HANDLE_VALUE;
 
-/* shared memory access semaphore */
-HANDLE semaphoreHandle = INVALID_HANDLE_VALUE;
+/* tick signals (one per tick parity, shared by all clients) */
+HANDLE tickHandles[2] = { INVALID_HANDLE_VALUE, INVALID_HANDLE_VALUE };
+uint32_t seenTick = 0;	// last tick read from shared memory
+volatile uint32_t boardEpoch = 0;	// epoch of the board last shown, sent with guesses (0: none yet)
 
-/* my update signal */
-HANDLE updateHandle = INVALID_HANDLE_VALUE;
+/* event ring signals (one per head parity, shared by all clients) */
+HANDLE eventHandles[2] = { INVALID_HANDLE_VALUE, INVALID_HANDLE_VALUE };
+const EventRing* eventRing;	// events for every player, written once by the server
+uint64_t eventCursor = 0;	// next event to read from the ring
 
 /* global quit */
 HANDLE quitHandle = INVALID_HANDLE_VALUE;
@@ -44,8 +54,22 @@ HANDLE quitHandle = INVALID_HANDLE_VALUE;
 /* file mapping handle */
 HANDLE fileMappingHandle = INVALID_HANDLE_VALUE;
 
-/* dictionary mapping handle */
+/* dictionary mapping handles */
 HANDLE dictMappingHandle = INVALID_HANDLE_VALUE;
+HANDLE dirMappingHandle = INVALID_HANDLE_VALUE;
+
+/* player name table mapping handle */
+HANDLE namesMappingHandle = INVALID_HANDLE_VALUE;
+
+/* leaderboard page mapping handle */
+HANDLE pageMappingHandle = INVALID_HANDLE_VALUE;
+
+/* event ring mapping handle */
+HANDLE eventsMappingHandle = INVALID_HANDLE_VALUE;
+
+/* last leaderboard received (LIST), resent only when its version changes */
+uint32_t listVersion = 0;
+std::wstring listText;
 
 /* Bot mode parameters */
 
@@ -60,7 +84,7 @@ bool warnServer = true;
 
 */
 
-void displayGameState(const TCHAR* array, int t);
+void displayGameState(const Letter* array, int t);
 
 Packet transact(Packet& p)	// encapsulates a single packet transaction
 {
@@ -105,26 +129,128 @@ Packet transact(Packet& p)	// encapsulates a single packet transaction
 	return res;
 }
 
+bool fetchList()	// LIST transaction: updates listText unless the server has nothing newer
+{
+	Packet p = { 0 };
+	Packet res = { 0 };
+	p.code = LIST;
+	p.id = gameId;
+	p.list.version = listVersion;
+
+	HANDLE pipeHandle = CreateFile(
+		serverPipeName,
+		GENERIC_READ | GENERIC_WRITE,
+		0,
+		NULL,
+		OPEN_EXISTING,
+		0,
+		NULL
+	);
+
+	if (pipeHandle == INVALID_HANDLE_VALUE) {
+#ifdef DEBUG
+		std::cout << __func__ << " ";
+		_tprintf(L"CreateFile %d\n", GetLastError());
+#endif
+		return false;
+	}
+
+	if (!WriteFile(pipeHandle, &p, sizeof(Packet), NULL, NULL) || !ReadFile(pipeHandle, &res, sizeof(Packet), NULL, NULL) || res.code != LIST) {
+#ifdef DEBUG
+		std::cout << __func__ << " ";
+		_tprintf(L"WriteFile/ReadFile %d\n", GetLastError());
+#endif
+		CloseHandle(pipeHandle);
+		return false;
+	}
+
+	// New version: the text follows the reply
+	if (res.list.length > 0) {
+		std::wstring text(res.list.length, L'\0');
+		DWORD size = res.list.length * sizeof(TCHAR);
+		DWORD got = 0, n;
+
+		while (got < size && ReadFile(pipeHandle, (char*)&text[0] + got, size - got, &n, NULL) && n > 0) {
+			got += n;
+		}
+
+		if (got < size) {
+			CloseHandle(pipeHandle);
+			return false;
+		}
+
+		listText.swap(text);
+		listVersion = res.list.version;
+	}
+
+	CloseHandle(pipeHandle);
+	return true;
+}
+
+std::wstring playerNameOf(int32_t id)	// name of the player a broadcast refers to
+{
+	TCHAR name[NAME_SIZE];
+
+	if (playerNames != NULL && playerNameLookup(playerNames, id, name)) {
+		return name;
+	}
+
+	return L"Jogador #" + std::to_wstring(id);	// slot already reused by someone else
+}
+
 void initCmds(std::map<std::wstring, cmd>& cmds)
 {
 	const HANDLE thisQuitHandle = quitHandle;
 
 	cmds[std::wstring(L":pont")] = [](const TCHAR* args){
+			int32_t score = leaderboardPageScore(leaderboardPage, gameId);	// read locally, no pipe round trip
+			std::wcout << L"Pontuao: " << (score < 0 ? 0 : score) << L"\n";
+		};
+	
+	cmds[std::wstring(L":posicao")] = [](const TCHAR* args) {
 			Packet p = { 0 };
-			p.code = SCORE;
+			p.code = RANK;
 			p.id = gameId;
 
 			p = transact(p);
-			std::wcout << L"Pontuao: " << p.id << L"\n";
+
+			if (p.code != RANK || p.id <= 0) {
+				std::wcout << L"Posio desconhecida\n";
+				return;
+			}
+
+			std::wcout << L"Posio: " << p.id << L" de " << p.rank.players << L" (pontuao " << p.rank.score;
+
+			if (p.id > 1) {
+				std::wcout << L", faltam " << p.rank.next << L" pontos para subir";
+			}
+
+			std::wcout << L")\n";
 		};
-	
+
 	cmds[std::wstring(L":lista")] = [](const TCHAR* args) {
-		Packet p = { 0 };
-		p.code = LIST;
-		p.id = gameId;
+		LeaderboardTop top;
+		leaderboardPageTop(leaderboardPage, top);	// read locally, no pipe round trip
 
-		p = transact(p);
-		std::wcout << L"Lista: " << p.buffer << L"\n";
+		std::wcout << L"Lista (verso " << top.version << L"):\n";
+
+		for (uint32_t i = 0; i < top.count; ++i) {
+			top.entries[i].name[NAME_SIZE - 1] = L'\0';
+			std::wcout << L"Nome: " << top.entries[i].name << L" Pontuao: " << top.entries[i].score << L"\n";
+		}
+
+		if (top.players > top.count) {
+			std::wcout << L"... e mais " << top.players - top.count << L" jogadores (:todos para a lista completa)\n";
+		}
+		};
+
+	cmds[std::wstring(L":todos")] = [](const TCHAR* args) {
+		if (!fetchList()) {
+			std::wcout << L"Lista indisponvel\n";
+			return;
+		}
+
+		std::wcout << L"Lista (verso " << listVersion << L"):\n" << listText;
 		};
 
 }
@@ -134,7 +260,14 @@ bool guessWord(const TCHAR* word)
 	Packet packet = { 0 };
 	packet.code = GUESS;
 	CopyMemory(&packet.id, &gameId, 4);
-	_tcscpy_s(packet.buffer, BUFFER_SIZE - 5, word);
+
+	packet.guess.epoch = boardEpoch;	// a guess at a board solved since is rejected unchecked
+
+	// Only letters travel; anything else could never score, so it is not sent
+	if (!lettersFromText(word, packet.guess.letters, GUESS_SIZE)) {
+		std::wcout << L"Palavra invlida\n";
+		return true;
+	}
 
 	if ((serverHandle = CreateFile(
 		serverPipeName,
@@ -175,13 +308,77 @@ bool guessWord(const TCHAR* word)
 	return true;
 }
 
+/**
+ * Map the dictionary image of the current generation, if not mapped yet
+ * The server publishes each reloaded dictionary under a new name; the old image
+ * stays valid while mapped, so a bot keeps guessing from it until this succeeds
+ *
+ * @return true if the current image is mapped
+ */
+bool mapDictionary()
+{
+	uint32_t generation = (uint32_t)dictionaryDirectory->generation;
+	TCHAR name[DICTIONARY_NAME_SIZE];
+
+	if (generation == dictionaryGeneration) {
+		return true;
+	}
+
+	dictionaryImageName(name, DICTIONARY_NAME_SIZE, generation);
+
+	HANDLE mapping = OpenFileMapping(FILE_MAP_READ, FALSE, name);
+
+	if (mapping == NULL) {		// already replaced again, retry with the next generation
+#ifdef DEBUG
+		std::cout << __func__ << " ";
+		_tprintf(L"OpenFileMapping %d\n", GetLastError());
+#endif
+		return false;
+	}
+
+	const DictionaryHeader* image = (const DictionaryHeader*)MapViewOfFile(
+		mapping,										// Handle to map object
+		FILE_MAP_READ,									// Read-only, shared with the server
+		0, 0,											// Offset
+		0);												// Whole image
+
+	// Validated against what the view really holds, not the size its header claims
+	MEMORY_BASIC_INFORMATION view = { 0 };
+
+	if (image == NULL || VirtualQuery(image, &view, sizeof(view)) == 0 || !dictionaryValid(image, view.RegionSize)) {
+		printf("Invalid dictionary image\n");
+
+		if (image != NULL) {
+			UnmapViewOfFile(image);
+		}
+
+		CloseHandle(mapping);
+		return false;
+	}
+
+	if (dictionary != NULL) {
+		UnmapViewOfFile(dictionary);
+		CloseHandle(dictMappingHandle);
+	}
+
+	dictionary = image;
+	dictMappingHandle = mapping;
+	dictionaryGeneration = generation;
+	return true;
+}
+
 /* thread procedures */
 
 void* botThreadProc(void* arg) {
 
 	Packet p = { 0 };
+	p.code = GUESS;
 	p.id = gameId;
-	int32_t idx = 0;
+	uint32_t idx = 0;
+	uint8_t counts[LETTER_COUNT];
+	GameState board = { 0 };	// kept up to date with the changes since the last guess
+	TCHAR text[GUESS_SIZE];
+	std::vector<uint32_t> candidates;	// words the current board can form
 
 	srand(time(NULL));	// reset prng seed
 	
@@ -193,11 +390,37 @@ void* botThreadProc(void* arg) {
 			break;
 		}
 
-		idx = rand() % MAX_WORDS;									// randomly select index
+		// Follow dictionary reloads; keep the old image if the new one cannot be mapped
+		if (!mapDictionary() && dictionary == NULL) {
+			continue;
+		}
 
-		std::wcout << L"\n" << dictionary->words[idx] << L"\n";
+		// Count the letters on the board
+		gameStateUpdate(gameState, board);
+		memset(counts, 0, sizeof(counts));
 
-		_tcscpy_s(p.buffer, BUFFER_SIZE, dictionary->words[idx]);	// send selected word
+		for (uint32_t i = 0; i < board.t; ++i) {
+			if (board.array[i] < LETTER_COUNT) {
+				counts[board.array[i]] += 1;
+			}
+		}
+
+		// Only words the board can form (DAWG walk limited by the letter counts)
+		candidates.clear();
+		dawgWalk(dictionary, counts, [&candidates](uint32_t w) { candidates.push_back(w); });
+
+		if (candidates.empty()) {									// nothing to guess
+			continue;
+		}
+
+		idx = candidates[((uint32_t)rand() << 15 | (uint32_t)rand()) % candidates.size()];	// randomly select a candidate (rand() is only 15 bits)
+
+		const Letter* word = dictionaryWord(dictionary, idx);
+		lettersToText(word, text, GUESS_SIZE);
+		std::wcout << L"\n" << text << L"\n";
+
+		for (int i = 0; i < GUESS_SIZE && (p.guess.letters[i] = word[i]) != LETTER_NONE; ++i);	// send selected word
+		p.guess.epoch = board.epoch;
 		
 		transact(p);												// discard reply
 	}
@@ -242,6 +465,12 @@ void* cliThreadProc(void* arg)
 		else if (input == L":lista") {
 			cmds[input](NULL);
 		}
+		else if (input == L":todos") {
+			cmds[input](NULL);
+		}
+		else if (input == L":posicao") {
+			cmds[input](NULL);
+		}
 	}
 
 	return NULL;
@@ -256,34 +485,21 @@ void* listenUpdateThreadProcBot(void* args)
 
 	while (WaitForSingleObject(quitHandle, 0) != WAIT_OBJECT_0) {
 
-		waitReturn = WaitForSingleObject(updateHandle, 100);
+		waitReturn = WaitForSingleObject(tickHandles[(seenTick + 1) & 1], 100);	// event of the next tick
 
 		if (waitReturn == WAIT_TIMEOUT) {
 			continue;
 		}
 
 		if (waitReturn == WAIT_FAILED) {
-			_tprintf(TEXT("WaitForSingle updateHandle %d\n"), GetLastError());
-			SetEvent(quitHandle);
-			return NULL;
-		}
-
-#ifdef DEBUG
-		std::cout << "Waiting for semaphore..." << std::endl;
-#endif
-
-		// If we got to this point, then the update event was signalled by the server process
-
-		waitReturn = WaitForSingleObject(semaphoreHandle, INFINITE);
-
-		if (waitReturn == WAIT_FAILED) {
-			_tprintf(TEXT("WaitForSingle semaphoreHandle %d\n"), GetLastError());
+			_tprintf(TEXT("WaitForSingle tickHandle %d\n"), GetLastError());
 			SetEvent(quitHandle);
 			return NULL;
 		}
 
+		// If we got to this point, then a tick was published by the server process
 
-		ReleaseSemaphore(semaphoreHandle, 1, NULL);
+		seenTick = gameState->tick;	// ticks missed while busy are skipped, not replayed
 	}
 
 
@@ -297,49 +513,135 @@ void* listenUpdateThreadProcBot(void* args)
 void* listenUpdateThreadProc(void* args)
 {
 	int32_t waitReturn;
+	GameState board = { 0 };	// board as last shown, updated with the changes logged since
 	char buffer[BUFFER_SIZE];
 
 	std::cout << "\nListening..." << std::endl;
 
 	while (WaitForSingleObject(quitHandle, 0) != WAIT_OBJECT_0) {
 
-		waitReturn = WaitForSingleObject(updateHandle, 100);
+		waitReturn = WaitForSingleObject(tickHandles[(seenTick + 1) & 1], 100);	// event of the next tick
 
 		if (waitReturn == WAIT_TIMEOUT) {
 			continue;
 		}
 
 		if (waitReturn == WAIT_FAILED) {
-			_tprintf(TEXT("WaitForSingle updateHandle %d\n"), GetLastError());
+			_tprintf(TEXT("WaitForSingle tickHandle %d\n"), GetLastError());
 			SetEvent(quitHandle);
 			return NULL;
 		}
 
+		// If we got to this point, then a tick was published by the server process
+
+		// Lock free (retried if the server wrote meanwhile); whole board only if changes were missed
+		int changes = gameStateUpdate(gameState, board);
+
 #ifdef DEBUG
-		std::cout << "Waiting for semaphore..." << std::endl;
+		if (changes < 0) {
+			std::cout << "Board copied whole" << std::endl;
+		}
+		else {
+			std::cout << "Board changes applied: " << changes << std::endl;
+		}
 #endif
 
-		// If we got to this point, then the update event was signalled by the server process
+		seenTick = board.tick;	// ticks missed while busy are applied from the change log
+		boardEpoch = board.epoch;
 
-		waitReturn = WaitForSingleObject(semaphoreHandle, INFINITE);
+		displayGameState(board.array, board.t);
+	}
 
-		if (waitReturn == WAIT_FAILED) {
-			_tprintf(TEXT("WaitForSingle semaphoreHandle %d\n"), GetLastError());
-			SetEvent(quitHandle);
-			return NULL;
+
+#ifdef DEBUG
+	std::cout << "Thread " << __func__ << " exiting..." << std::endl;
+#endif
+
+	return NULL;
+}
+
+bool readPacket(Packet& packet, OVERLAPPED& overlapped)	// next packet on the server's connection, false once it is closed (or on quit)
+{
+	DWORD got = 0, n = 0;
+
+	while (got < sizeof(Packet)) {
+		if (!ReadFile(pipeHandle, (char*)&packet + got, sizeof(Packet) - got, NULL, &overlapped)) {
+			if (GetLastError() != ERROR_IO_PENDING) {
+				return false;	// server closed the connection
+			}
+
+			while (WaitForSingleObject(overlapped.hEvent, 1000) == WAIT_TIMEOUT) {
+				if (WaitForSingleObject(quitHandle, 0) == WAIT_OBJECT_0) {
+					CancelIo(pipeHandle);
+					GetOverlappedResult(pipeHandle, &overlapped, &n, TRUE);
+					return false;
+				}
+			}
 		}
 
-		displayGameState(gameState->array, gameState->t);
+		if (!GetOverlappedResult(pipeHandle, &overlapped, &n, TRUE) || n == 0) {
+			return false;
+		}
 
-		ReleaseSemaphore(semaphoreHandle, 1, NULL);
+		got += n;
 	}
 
+	return true;
+}
+
+bool handleEvent(const Packet& inputPacket)	// event from the server (ring or pipe), false once told to leave
+{
+	_tprintf_s(L"Packet received: (%d, %d)\n", inputPacket.code, inputPacket.id);
 
 #ifdef DEBUG
-	std::cout << "Thread " << __func__ << " exiting..." << std::endl;
+	_tprintf((const TCHAR*)L"Message received: %d : %d\n", inputPacket.code, inputPacket.id);
 #endif
 
-	return NULL;
+	switch (inputPacket.code)
+	{
+		case PLAYER_LOGIN:
+			/* a new player has joined */
+			std::wcout << playerNameOf(inputPacket.id) << L" juntou-se ao jogo\n";
+			break;
+
+		case PLAYER_LOGOUT:
+			/* someone left */
+			std::wcout << playerNameOf(inputPacket.id) << L" saiu\n";
+			break;
+
+		case GUESS:
+			/* someone guessed a word */
+			std::wcout << playerNameOf(inputPacket.id) << " advinhou uma palavra.\n";
+			break;
+
+		case MVP:
+			/* someone is on top of the leaderboard */
+			std::wcout << playerNameOf(inputPacket.id) << L" passou  frente com " << inputPacket.standing.score << L" pontos\n";
+			break;
+
+		case TOP_RANK:
+			/* someone entered the top of the leaderboard */
+			std::wcout << playerNameOf(inputPacket.id) << L" entrou no top " << LEADERBOARD_TOP << L" (posio " << inputPacket.standing.rank << L", " << inputPacket.standing.score << L" pontos)\n";
+			break;
+
+		case LOGOUT:
+			/* leave flag */
+			std::wcout << "Foi kickado pelo servidor\n";
+
+			SetEvent(quitHandle);
+
+			/* warnServer flag*/
+			warnServer = false;
+
+			return false;
+
+
+		default:
+			std::cout << "\nUnexpected packet flag received: " << inputPacket.code << std::endl;
+			break;
+		}
+
+	return true;
 }
 
 void* listenPipeThreadProc(void* args)
@@ -388,73 +690,70 @@ void* listenPipeThreadProc(void* args)
 			}
 		}
 	
-		if ((ReadFile(pipeHandle, &inputPacket, sizeof(inputPacket), NULL, NULL)) == 0) {
-			std::cout << __func__;
-			_tprintf(TEXT(" ReadFile %d"), GetLastError());
-			SetEvent(quitHandle);
-			break;
-
+		/* The server keeps the connection: read packets until it closes it */
+		while (readPacket(inputPacket, overlapped)) {
+			if (!handleEvent(inputPacket)) {
+				CloseHandle(pipeHandle);
+				CloseHandle(overlapped.hEvent);
+				return NULL;
+			}
 		}
 
-		_tprintf_s(L"Packet received: (%d, %d, %s)\n", inputPacket.code, inputPacket.id, inputPacket.buffer);
-
-
-		FlushFileBuffers(pipeHandle);
-		DisconnectNamedPipe(pipeHandle);
+		DisconnectNamedPipe(pipeHandle);	// closed by the server: wait for it to connect again
+	}
 
 #ifdef DEBUG
-		_tprintf((const TCHAR*)L"Message received: %d : %s\n", inputPacket.code, inputPacket.buffer);
+	std::cout << "Thread " << __func__ << " exiting..." << std::endl;
 #endif
 
-		switch (inputPacket.code)
-		{
-			case PLAYER_LOGIN:
-				/* a new player has joined */
-				std::wcout << inputPacket.buffer << L" juntou-se ao jogo\n";
-				break;
-
-			case PLAYER_LOGOUT:
-				/* someone left */
-				std::wcout << inputPacket.buffer << L" saiu\n";
-				break;
+	CloseHandle(pipeHandle);
+	CloseHandle(overlapped.hEvent);
+	return NULL;
+}
 
-			case GUESS:
-				/* someone guessed a word */
-				std::wcout << inputPacket.buffer << " advinhou uma palavra.\n";
-				break;
+void* listenEventsThreadProc(void* args)
+{
+	EventSlot event;
+	int32_t waitReturn;
 
-			case MVP:
-				/* someone is on top of the leaderboard */
-				std::wcout << inputPacket.buffer << L" passou  frente com " << inputPacket.id << L" pontuao";
-				break;
+	while (WaitForSingleObject(quitHandle, 0) != WAIT_OBJECT_0) {
 
-			case LOGOUT:
-				/* leave flag */
-				std::wcout << "Foi kickado pelo servidor\n";
+		/* Read every event written since the last one, at our own cursor */
+		for (;;) {
+			EventRingRead r = eventRingRead(eventRing, eventCursor, event);
 
-				SetEvent(quitHandle);
+			if (r == EVENT_PENDING) {
+				break;
+			}
 
-				CloseHandle(pipeHandle);
-				CloseHandle(overlapped.hEvent);
+			if (r == EVENT_OVERRUN) {
+				/* too far behind: the ring was overwritten, go on from the latest events */
+				uint64_t head = (uint64_t)eventRing->head;
+				std::wcout << L"Perdeu " << head - eventCursor << L" eventos\n";
+				eventCursor = head;
+				continue;
+			}
 
-				/* warnServer flag*/
-				warnServer = false;
+			eventCursor += 1;
 
+			if (event.except != gameId && !handleEvent(event.packet)) {
 				return NULL;
+			}
+		}
 
+		waitReturn = WaitForSingleObject(eventHandles[(eventCursor + 1) & 1], 100);	// event of the next write
 
-			default:
-				std::cout << "\nUnexpected packet flag received: " << inputPacket.code << std::endl;
-				break;
-			}
+		if (waitReturn == WAIT_FAILED) {
+			_tprintf(TEXT("WaitForSingle eventHandle %d\n"), GetLastError());
+			SetEvent(quitHandle);
+			return NULL;
+		}
 	}
 
 #ifdef DEBUG
 	std::cout << "Thread " << __func__ << " exiting..." << std::endl;
 #endif
 
-	CloseHandle(pipeHandle);
-	CloseHandle(overlapped.hEvent);
 	return NULL;
 }
 
@@ -464,7 +763,7 @@ bool loginToServer(const TCHAR* playerName) {
 	Login_Return_Type response;
 	int32_t errorCode;
 	packet.code = LOGIN;
-	_tcscpy_s(packet.buffer, BUFFER_SIZE, playerName);
+	_tcscpy_s(packet.buffer, NAME_SIZE, playerName);
 
 	if ((serverHandle = CreateFile(
 		serverPipeName,
@@ -526,14 +825,14 @@ bool loginToServer(const TCHAR* playerName) {
 	}
 }
 
-void displayGameState(const TCHAR* array, int t)
+void displayGameState(const Letter* array, int t)
 {
 	for (int i = 0; i < t; ++i) {
-		if (array[i] == 0) {
+		if (array[i] >= LETTER_COUNT) {
 			std::wcout << L" _ ";
 		}
 		else {
-			std::wcout << L" " << array[i] << L" ";
+			std::wcout << L" " << letterToChar(array[i]) << L" ";
 		}
 	}
 
@@ -556,6 +855,19 @@ bool initializeThreads()
 		return false;
 	}
 
+	if ((eventsThread = CreateThread(
+		NULL,
+		0,
+		(LPTHREAD_START_ROUTINE)listenEventsThreadProc,
+		NULL,
+		0,
+		NULL)) == NULL)
+	{
+		_tprintf(TEXT("CreateThread events %d"), GetLastError());
+		SetEvent(quitHandle);
+		return false;
+	}
+
 
 	/* If botmode, select botThreadPRoc as main word-guessing routine, else start cli routine */
 	
@@ -602,8 +914,8 @@ bool initializeEventSemaphorePipeSharedMemory(const TCHAR* playerName)
 		PIPE_ACCESS_DUPLEX | PIPE_TYPE_BYTE | FILE_FLAG_OVERLAPPED,
 		PIPE_WAIT,
 		PIPE_UNLIMITED_INSTANCES,
-		2* BUFFER_SIZE * sizeof(TCHAR),
-		2* BUFFER_SIZE * sizeof(TCHAR),
+		CLIENT_PIPE_BUFFER,		// the server keeps its connection and writes without waiting
+		CLIENT_PIPE_BUFFER,
 		0,
 		NULL)) == INVALID_HANDLE_VALUE)
 	{
@@ -611,18 +923,28 @@ bool initializeEventSemaphorePipeSharedMemory(const TCHAR* playerName)
 		return false;
 	}
 
-	/* Initialize event name for updates */
-	_stprintf_s(eventName, TEXT("%s%s%s"), TEXT("Local\\"), playerName, TEXT("_update"));
+	/* Open the tick events the server sets when it publishes the board */
+	for (int i = 0; i < 2; ++i) {
+		if ((tickHandles[i] = OpenEvent(
+			SYNCHRONIZE,
+			FALSE,
+			tickEventNames[i])) == NULL)
+		{
+			_tprintf(TEXT("OpenEvent %d"), GetLastError());
+			return false;
+		}
+	}
 
-	/* Create update event for synchronization */
-	if ((updateHandle = CreateEvent(
-		NULL,
-		FALSE,
-		FALSE,
-		eventName)) == NULL)
-	{
-		_tprintf(TEXT("CreateEvent %d"), GetLastError());
-		return false;
+	/* Open the event ring signals the server sets when it writes an event */
+	for (int i = 0; i < 2; ++i) {
+		if ((eventHandles[i] = OpenEvent(
+			SYNCHRONIZE,
+			FALSE,
+			eventSignalNames[i])) == NULL)
+		{
+			_tprintf(TEXT("OpenEvent %d"), GetLastError());
+			return false;
+		}
 	}
 
 	/* Initialize quit handle for graceful shutdown */
@@ -636,19 +958,9 @@ bool initializeEventSemaphorePipeSharedMemory(const TCHAR* playerName)
 		return false;
 	}
 
-	/* Open shared memory access semaphore */
-	if ((semaphoreHandle = OpenSemaphore(
-		SEMAPHORE_ALL_ACCESS,
-		FALSE,
-		updatedSemaphoreName
-	)) == NULL) {
-		_tprintf(TEXT("OpenSemaphore %d"), GetLastError());
-		return false;
-	}
-
-	/* Open shared memory mapping */
+	/* Open shared memory mapping (read only: the board is copied without a lock) */
 	fileMappingHandle = OpenFileMapping(
-		FILE_MAP_ALL_ACCESS,
+		FILE_MAP_READ,
 		FALSE,
 		sharedMemoryName
 	);
@@ -658,41 +970,117 @@ bool initializeEventSemaphorePipeSharedMemory(const TCHAR* playerName)
 		return false;
 	}
 
-	gameState = (GameState*)MapViewOfFile(
+	gameState = (const GameState*)MapViewOfFile(
 		fileMappingHandle,				// Handle to map object
-		FILE_MAP_ALL_ACCESS,			// Read/write permission
+		FILE_MAP_READ,					// Read-only
 		0, 0,							// Offset
-		BUFFER_SIZE);
+		sizeof(GameState));
 
 	if (gameState == NULL) {
 		printf("MapViewOfFile failed (%d)\n", GetLastError());
 		return false;
 	}
 
+	/* Open event ring (read from the head on: events before the login are not ours) */
+	eventsMappingHandle = OpenFileMapping(
+		FILE_MAP_READ,
+		FALSE,
+		eventRingName
+	);
+
+	if (eventsMappingHandle == NULL) {
+		printf("OpenFileMapping events failed (%d)\n", GetLastError());
+		return false;
+	}
+
+	eventRing = (const EventRing*)MapViewOfFile(
+		eventsMappingHandle,			// Handle to map object
+		FILE_MAP_READ,					// Read-only
+		0, 0,							// Offset
+		sizeof(EventRing));
+
+	if (eventRing == NULL) {
+		printf("MapViewOfFile events failed (%d)\n", GetLastError());
+		return false;
+	}
+
+	eventCursor = (uint64_t)eventRing->head;
+
+	/* Open player name table (broadcasts carry player IDs) */
+	namesMappingHandle = OpenFileMapping(
+		FILE_MAP_READ,
+		FALSE,
+		playerNamesName
+	);
+
+	if (namesMappingHandle == NULL) {
+		printf("OpenFileMapping names failed (%d)\n", GetLastError());
+		return false;
+	}
+
+	playerNames = (const PlayerNameTable*)MapViewOfFile(
+		namesMappingHandle,				// Handle to map object
+		FILE_MAP_READ,					// Read-only
+		0, 0,							// Offset
+		0);								// Whole table (its size depends on the server capacity)
+
+	if (playerNames == NULL) {
+		printf("MapViewOfFile names failed (%d)\n", GetLastError());
+		return false;
+	}
+
+	/* Open leaderboard page (:lista and :pont read it locally) */
+	pageMappingHandle = OpenFileMapping(
+		FILE_MAP_READ,
+		FALSE,
+		leaderboardPageName
+	);
+
+	if (pageMappingHandle == NULL) {
+		printf("OpenFileMapping leaderboard failed (%d)\n", GetLastError());
+		return false;
+	}
+
+	leaderboardPage = (const LeaderboardPage*)MapViewOfFile(
+		pageMappingHandle,				// Handle to map object
+		FILE_MAP_READ,					// Read-only
+		0, 0,							// Offset
+		0);								// Whole page (its size depends on the server capacity)
+
+	if (leaderboardPage == NULL) {
+		printf("MapViewOfFile leaderboard failed (%d)\n", GetLastError());
+		return false;
+	}
+
 	/* Open dictionary shared memory, if bot mode */
 	
 	if (botMode) {
-		dictMappingHandle = OpenFileMapping(
-			FILE_MAP_ALL_ACCESS,
+		dirMappingHandle = OpenFileMapping(
+			FILE_MAP_READ,
 			FALSE,
 			dictionaryName
 		);
 
-		if (dictMappingHandle == NULL) {
+		if (dirMappingHandle == NULL) {
 			printf("OpenFileMapping dictionary failed (%d)\n", GetLastError());
 			return false;
 		}
 
-		dictionary = (Dictionary*)MapViewOfFile(
-			dictMappingHandle,								// Handle to map object
-			FILE_MAP_ALL_ACCESS,							// Read/write permission
+		dictionaryDirectory = (const DictionaryDirectory*)MapViewOfFile(
+			dirMappingHandle,								// Handle to map object
+			FILE_MAP_READ,									// Read-only
 			0, 0,											// Offset
-			0);												// Dictionary length in bytes
+			sizeof(DictionaryDirectory));
 
-		if (dictionary == NULL) {
+		if (dictionaryDirectory == NULL) {
 			printf("MapViewOfFile dictionary failed (%d)\n", GetLastError());
 			return false;
 		}
+
+		if (!mapDictionary()) {
+			printf("Could not map dictionary\n");
+			return false;
+		}
 	}
 
 
@@ -44,6 +44,7 @@ int _tmain(int argc, TCHAR* argv[])
 	// Wait for all threads to complete
 	if(threaded) {
 		WaitForSingleObject(pipeThread, INFINITE);
+		WaitForSingleObject(eventsThread, INFINITE);
 		WaitForSingleObject(updateThread, INFINITE);
 		TerminateThread(cliThread, INFINITE);
 	}
@@ -55,11 +56,11 @@ int _tmain(int argc, TCHAR* argv[])
 	
 	/*	 // Cleanup
 	safeClose(pipeHandle);
-	safeClose(semaphoreHandle);
-	safeClose(updateHandle);	
+	safeClose(tickHandles[0]);
+	safeClose(tickHandles[1]);
 	safeClose(serverHandle);
-	safeClose(semaphoreHandle);
-	safeClose(updateHandle);
+	safeClose(tickHandles[0]);
+	safeClose(tickHandles[1]);
 	safeClose(quitHandle);
 	safeClose(fileMappingHandle);
 	*/
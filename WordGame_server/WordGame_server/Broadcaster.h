@@ -0,0 +1,318 @@
+#pragma once
+
+#ifndef _BROADCASTER_H_
+#define _BROADCASTER_H_
+
+#include "..\..\wordgame_common.h"
+#include "ClientConnection.h"
+#include <algorithm>
+#include <vector>
+
+/*
+    Broadcaster: delivers the packets for one player (exit orders) over its pipe, off the
+    game logic's critical path. Events for every player do not come here: they are written
+    once to the shared event ring (see EventRing), where each client reads at its own cursor
+    and a lapped client finds out itself, so there is no per-client queue for them here.
+    A packet is posted once into a ring shared by all clients; each client has a cursor in
+    the ring, so its queue is the packets between its cursor and the head. I/O threads take
+    a client with packets waiting, copy a batch of them and write it in one go, so a client
+    that does not read only delays itself (and only up to BROADCAST_TIMEOUT per write).
+*/
+
+#define BROADCAST_RING 4096         // packets kept in the ring (a client further behind loses them)
+#define BROADCAST_BATCH 16          // packets written at once (fits CLIENT_PIPE_BUFFER)
+#define BROADCAST_THREADS 2         // I/O threads
+#define BROADCAST_TIMEOUT 100       // milliseconds a write may take before the client counts as stalled
+
+/**
+ * Packet in the ring
+ */
+struct BroadcastEvent {
+    Packet packet;
+    int32_t target;     // Player the packet is for
+};
+
+/**
+ * Client known to the broadcaster (from login until its last packet is written after logout)
+ */
+struct BroadcastClient {
+    int32_t id;
+    TCHAR pipe_name[2 * ARRAY_SIZE + 2];
+    ClientConnection connection;
+    uint64_t cursor;                    // Next ring sequence to look at
+    uint64_t end;                       // Deliver up to here, then close (UINT64_MAX while in the game)
+    bool busy;                          // An I/O thread is writing to it
+};
+
+/**
+ * Delivery of the packets for one player, with a queue per client
+ */
+class Broadcaster {
+private:
+    CRITICAL_SECTION lock;                  // ring, head, clients
+    std::vector<BroadcastEvent> ring;
+    uint64_t head;                          // sequence of the next packet
+    std::vector<BroadcastClient*> clients;
+    size_t next_client;                     // where the I/O threads look first (round robin)
+    std::vector<HANDLE> threads;
+    HANDLE posted;                          // packets waiting (auto reset)
+    volatile LONG stopping;
+
+    /**
+     * Take the next batch for a client (with the lock held)
+     *
+     * @return Packets copied into batch
+     */
+    uint32_t takeBatch(BroadcastClient& c, Packet* batch) {
+        uint64_t limit = head < c.end ? head : c.end;
+        uint32_t n = 0;
+
+        while (n < BROADCAST_BATCH && c.cursor < limit) {
+            const BroadcastEvent& e = ring[c.cursor++ % BROADCAST_RING];
+
+            if (e.target == c.id) {
+                batch[n++] = e.packet;
+            }
+        }
+
+        return n;
+    }
+
+    /**
+     * Check if a client has something for an I/O thread (with the lock held)
+     */
+    bool pending(const BroadcastClient& c) const {
+        uint64_t limit = head < c.end ? head : c.end;
+        return !c.busy && (c.cursor < limit || c.cursor >= c.end);
+    }
+
+    /**
+     * Find a client with work and claim it (with the lock held)
+     *
+     * @param more Set if another client has work too (another I/O thread should be woken)
+     * @return Client, NULL if none has packets waiting
+     */
+    BroadcastClient* claim(bool& more) {
+        more = false;
+
+        for (size_t i = 0; i < clients.size(); ++i) {
+            size_t at = (next_client + i) % clients.size();
+            BroadcastClient* c = clients[at];
+
+            if (c->busy) {
+                continue;
+            }
+
+            // Packets overwritten in the ring before this client got them are lost
+            if (head - c->cursor > BROADCAST_RING) {
+                c->cursor = head - BROADCAST_RING;
+            }
+
+            if (pending(*c)) {
+                c->busy = true;
+                next_client = (at + 1) % clients.size();
+
+                for (size_t j = 1; i + j < clients.size() && !more; ++j) {
+                    more = pending(*clients[(at + j) % clients.size()]);
+                }
+
+                return c;
+            }
+        }
+
+        return NULL;
+    }
+
+    /**
+     * Deliver packets until there is nothing left to do
+     */
+    void drain() {
+        Packet batch[BROADCAST_BATCH];
+
+        for (;;) {
+            uint32_t n = 0;
+            bool more;
+
+            EnterCriticalSection(&lock);
+            BroadcastClient* c = claim(more);
+
+            if (c != NULL) {
+                n = takeBatch(*c, batch);
+            }
+            LeaveCriticalSection(&lock);
+
+            // One post wakes one thread: pass it on, so a stalled write does not hold the rest
+            if (more) {
+                SetEvent(posted);
+            }
+
+            if (c == NULL) {
+                return;
+            }
+
+            if (n > 0) {
+                c->connection.send(c->pipe_name, batch, n, BROADCAST_TIMEOUT);  // a failed or stalled write loses the batch
+            }
+
+            EnterCriticalSection(&lock);
+            c->busy = false;
+
+            // Player gone and everything up to its logout written: forget it
+            if (c->cursor >= c->end) {
+                clients.erase(std::find(clients.begin(), clients.end(), c));
+                c->connection.close();
+                delete c;
+            }
+            LeaveCriticalSection(&lock);
+        }
+    }
+
+    static void* ioThread(void* param) {
+        Broadcaster* b = (Broadcaster*)param;
+
+        while (!b->stopping) {
+            WaitForSingleObject(b->posted, 50);
+            b->drain();
+        }
+
+        return NULL;
+    }
+
+public:
+    Broadcaster() : ring(BROADCAST_RING), head(0), next_client(0), posted(NULL), stopping(0) {
+        InitializeCriticalSection(&lock);
+    };
+
+    ~Broadcaster() {
+        stop();
+
+        for (BroadcastClient* c : clients) {
+            c->connection.close();
+            delete c;
+        }
+
+        DeleteCriticalSection(&lock);
+    }
+
+    /**
+     * Start the I/O threads
+     *
+     * @param threads Number of I/O threads
+     * @return true on success, false otherwise
+     */
+    bool start(uint32_t threads) {
+        if ((posted = CreateEvent(NULL, FALSE, FALSE, NULL)) == NULL) {
+            _tprintf(TEXT("CreateEvent %d"), GetLastError());
+            return false;
+        }
+
+        for (uint32_t i = 0; i < threads; ++i) {
+            HANDLE t = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)ioThread, this, 0, NULL);
+
+            if (t == NULL) {
+                _tprintf(TEXT("CreateThread %d"), GetLastError());
+                return false;
+            }
+
+            this->threads.push_back(t);
+        }
+
+        return true;
+    }
+
+    /**
+     * Write what is waiting (for at most a second) and stop the I/O threads
+     */
+    void stop() {
+        if (posted == NULL) {
+            return;
+        }
+
+        ULONGLONG deadline = GetTickCount64() + 1000;
+        bool waiting = true;
+
+        while (waiting && GetTickCount64() < deadline) {
+            EnterCriticalSection(&lock);
+            waiting = false;
+
+            for (BroadcastClient* c : clients) {
+                waiting = waiting || c->busy || c->cursor < (head < c->end ? head : c->end);
+            }
+            LeaveCriticalSection(&lock);
+
+            if (waiting) {
+                SetEvent(posted);
+                Sleep(10);
+            }
+        }
+
+        InterlockedExchange(&stopping, 1);
+
+        for (HANDLE t : threads) {
+            WaitForSingleObject(t, INFINITE);
+            CloseHandle(t);
+        }
+
+        threads.clear();
+        CloseHandle(posted);
+        posted = NULL;
+    }
+
+    /**
+     * Start delivering packets to a player
+     */
+    void attach(int32_t id, const TCHAR* pipe_name) {
+        BroadcastClient* c = new BroadcastClient();
+        c->id = id;
+        _tcscpy_s(c->pipe_name, pipe_name);
+        c->end = UINT64_MAX;
+        c->busy = false;
+
+        EnterCriticalSection(&lock);
+        c->cursor = head;
+        clients.push_back(c);
+        LeaveCriticalSection(&lock);
+    }
+
+    /**
+     * Stop delivering packets to a player once those already posted are written
+     */
+    void detach(int32_t id) {
+        EnterCriticalSection(&lock);
+
+        for (BroadcastClient* c : clients) {
+            if (c->id == id && c->end == UINT64_MAX) {
+                c->end = head;
+            }
+        }
+        LeaveCriticalSection(&lock);
+
+        SetEvent(posted);
+    }
+
+    /**
+     * Post a packet for one player (never waits for its client)
+     *
+     * @param p Packet
+     * @param target Player the packet is for
+     */
+    void post(const Packet& p, int32_t target) {
+        EnterCriticalSection(&lock);
+        BroadcastEvent& e = ring[head % BROADCAST_RING];
+        e.packet = p;
+        e.target = target;
+        head += 1;
+        LeaveCriticalSection(&lock);
+
+        SetEvent(posted);
+    }
+
+    /**
+     * Check if the I/O threads are running
+     */
+    bool running() const {
+        return !threads.empty();
+    }
+};
+
+#endif
@@ -0,0 +1,134 @@
+#pragma once
+
+#ifndef _CLIENTCONNECTION_H_
+#define _CLIENTCONNECTION_H_
+
+#include "..\..\wordgame_common.h"
+#include <iostream>
+#include <windows.h>
+#include <tchar.h>
+
+/**
+ * Long lived connection to a client's named pipe
+ * Opened at the first packet for the player and kept until the player leaves, so an event
+ * costs one write instead of open, write, wait for the client and close. The client reads
+ * packets from the connection until the server closes it, then waits for a new one.
+ * A failed write closes the connection and the packets are retried once on a new one;
+ * a write that does not finish in time (stalled client) closes it without a retry.
+ * Not thread safe: used by one thread at a time.
+ */
+class ClientConnection {
+    HANDLE pipe;
+    HANDLE written;     // signaled when an overlapped write ends (manual reset)
+
+    /**
+     * Connect to the client's pipe
+     */
+    bool open(const TCHAR* pipe_name) {
+        pipe = CreateFile(pipe_name, GENERIC_WRITE, 0, NULL, OPEN_EXISTING, FILE_FLAG_OVERLAPPED, NULL);
+
+        if (pipe == INVALID_HANDLE_VALUE) {
+#ifdef DEBUG
+            std::cout << __func__ << " ";
+            _tprintf(L"CreateFile %d\n", GetLastError());
+#endif
+            return false;
+        }
+
+        if (written == NULL && (written = CreateEvent(NULL, TRUE, FALSE, NULL)) == NULL) {
+            _tprintf(TEXT("CreateEvent %d"), GetLastError());
+            close();
+            return false;
+        }
+
+        return true;
+    }
+
+    /**
+     * Write to the open connection
+     *
+     * @param stalled Set if the write did not end in time
+     */
+    bool write(const void* data, DWORD size, DWORD timeout, bool& stalled) {
+        OVERLAPPED ol = { 0 };
+        DWORD done = 0;
+        ol.hEvent = written;
+
+        if (!WriteFile(pipe, data, size, NULL, &ol)) {
+            if (GetLastError() != ERROR_IO_PENDING) {
+                return false;
+            }
+
+            if (WaitForSingleObject(written, timeout) != WAIT_OBJECT_0) {
+                CancelIo(pipe);
+                GetOverlappedResult(pipe, &ol, &done, TRUE);
+                stalled = true;     // part of a packet may have gone: the stream is unusable
+                return false;
+            }
+        }
+
+        return GetOverlappedResult(pipe, &ol, &done, FALSE) && done == size;
+    }
+
+public:
+    ClientConnection() : pipe(INVALID_HANDLE_VALUE), written(NULL) {};
+
+    /**
+     * Send packets in one write, connecting (or reconnecting) first if needed
+     *
+     * @param pipe_name Client's pipe
+     * @param p Packets to send
+     * @param count Number of packets
+     * @param timeout Milliseconds the write may wait for the client to read (INFINITE to wait)
+     * @return true if written, false if the client cannot be reached or stalled
+     */
+    bool send(const TCHAR* pipe_name, const Packet* p, uint32_t count = 1, DWORD timeout = INFINITE) {
+        for (int attempt = 0; attempt < 2; ++attempt) {
+            bool stalled = false;
+
+            if (pipe == INVALID_HANDLE_VALUE && !open(pipe_name)) {
+                return false;
+            }
+
+            if (write(p, count * sizeof(Packet), timeout, stalled)) {
+                return true;
+            }
+
+#ifdef DEBUG
+            std::cout << __func__ << " ";
+            _tprintf(L"WriteFile %d\n", GetLastError());
+#endif
+            close();    // broken (client restarted its end): reconnect once
+
+            if (stalled) {
+                return false;
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * Close the connection (the client goes back to waiting for one)
+     */
+    void close() {
+        if (pipe != INVALID_HANDLE_VALUE) {
+            CloseHandle(pipe);
+            pipe = INVALID_HANDLE_VALUE;
+        }
+
+        if (written != NULL) {
+            CloseHandle(written);
+            written = NULL;
+        }
+    }
+
+    /**
+     * Check if the connection is open
+     */
+    bool connected() const {
+        return pipe != INVALID_HANDLE_VALUE;
+    }
+};
+
+#endif
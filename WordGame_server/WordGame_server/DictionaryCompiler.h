@@ -0,0 +1,271 @@
+#pragma once
+
+#ifndef _DICTIONARYCOMPILER_H_
+#define _DICTIONARYCOMPILER_H_
+
+#include "..\..\wordgame_common.h"
+#include "..\..\wordgame_dictionary.h"
+#include "WordIndex.h"
+#include "WordListLoader.h"
+#include <vector>
+#include <algorithm>
+#include <map>
+
+/**
+ * Build the DAWG of a word list (incremental construction of the minimal
+ * automaton from sorted input: each finished branch is merged with an
+ * equivalent node already seen, so common suffixes are stored once)
+ *
+ * @param words Word keys, sorted and without duplicates
+ * @param edges Receives the edge table (see wordgame_dictionary.h)
+ * @param reach Receives the number of words reachable through each edge
+ * @return true on success, false if the DAWG is too large for the edge format
+ */
+bool buildDawg(const std::vector<WordKey>& words, std::vector<uint32_t>& edges, std::vector<uint32_t>& reach) {
+    struct Node {
+        bool final;                                         // a word ends here
+        std::vector<std::pair<uint32_t, uint32_t>> next;    // (letter, node), sorted by letter
+    };
+
+    struct Pending {
+        uint32_t parent;
+        uint32_t child;
+    };
+
+    std::vector<Node> nodes(1, Node{ false, {} });          // node 0 is the root
+    std::map<std::vector<uint32_t>, uint32_t> registry;     // node contents -> unique node
+    std::vector<Pending> unchecked;                         // path of the last word, not yet merged
+    std::vector<uint32_t> language;                         // words reachable from each merged node
+    WordKey previous = 0;
+
+    // Merge the unchecked path below depth 'keep' into equivalent registered nodes
+    auto minimize = [&](size_t keep) {
+        while (unchecked.size() > keep) {
+            Pending p = unchecked.back();
+            std::vector<uint32_t> key(1, nodes[p.child].final ? 1 : 0);
+
+            for (auto& n : nodes[p.child].next) {
+                key.push_back(n.first);
+                key.push_back(n.second);
+            }
+
+            auto found = registry.find(key);
+
+            if (found != registry.end()) {
+                nodes[p.parent].next.back().second = found->second;
+            }
+            else {
+                // children are all merged already, so their counts are known
+                language.resize(nodes.size(), 0);
+                language[p.child] = nodes[p.child].final ? 1 : 0;
+
+                for (auto& n : nodes[p.child].next) {
+                    language[p.child] += language[n.second];
+                }
+
+                registry[key] = p.child;
+            }
+
+            unchecked.pop_back();
+        }
+    };
+
+    for (WordKey w : words) {
+        size_t prefix = 0;
+        size_t len = wordKeyLength(w);
+
+        while (prefix < len && wordKeyLetter(w, prefix) == wordKeyLetter(previous, prefix)) {
+            ++prefix;
+        }
+
+        minimize(prefix);
+
+        uint32_t node = unchecked.empty() ? 0 : unchecked.back().child;
+
+        for (size_t i = prefix; i < len; ++i) {
+            uint32_t child = (uint32_t)nodes.size();
+
+            nodes.push_back(Node{ false, {} });
+            nodes[node].next.push_back(std::make_pair((uint32_t)wordKeyLetter(w, i), child));
+            unchecked.push_back(Pending{ node, child });
+            node = child;
+        }
+
+        nodes[node].final = true;
+        previous = w;
+    }
+
+    minimize(0);
+
+    // Lay out every node reachable from the root as a run of edges, root first at edge 1
+    std::vector<uint32_t> first(nodes.size(), 0);
+    std::vector<uint32_t> order(1, 0);
+    uint32_t count = 1;
+
+    for (size_t i = 0; i < order.size(); ++i) {
+        const Node& n = nodes[order[i]];
+
+        first[order[i]] = count;
+        count += (uint32_t)n.next.size();
+
+        for (auto& e : n.next) {
+            if (first[e.second] == 0 && !nodes[e.second].next.empty()) {
+                first[e.second] = UINT32_MAX;   // queued
+                order.push_back(e.second);
+            }
+        }
+    }
+
+    if (count > DAWG_MAX_EDGES) {
+        _tprintf(_T("Error: DAWG too large (%u edges)\n"), count);
+        return false;
+    }
+
+    edges.assign(count, 0);
+    reach.assign(count, 0);
+
+    for (uint32_t n : order) {
+        uint32_t at = first[n];
+
+        for (size_t i = 0; i < nodes[n].next.size(); ++i, ++at) {
+            uint32_t child = nodes[n].next[i].second;
+
+            edges[at] = nodes[n].next[i].first |
+                        (nodes[child].final ? DAWG_TERMINAL : 0) |
+                        (i + 1 == nodes[n].next.size() ? DAWG_LAST : 0) |
+                        ((nodes[child].next.empty() ? 0 : first[child]) << DAWG_CHILD_SHIFT);
+            reach[at] = language[child];
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Compile words into a dictionary image (see wordgame_dictionary.h)
+ *
+ * @param words Word keys, sorted and without duplicates
+ * @param image Receives the image
+ * @return true on success, false if the words do not fit the format
+ */
+bool compileDictionary(const std::vector<WordKey>& words, std::vector<uint8_t>& image) {
+    DictionaryHeader header = { 0 };
+    std::vector<uint32_t> edges, reach;
+    uint64_t letters = 0;
+    uint64_t slots = 2;
+
+    if (!buildDawg(words, edges, reach)) {
+        return false;
+    }
+
+    for (WordKey w : words) {
+        letters += wordKeyLength(w) + 1;
+    }
+
+    while (slots < 2 * (uint64_t)words.size()) {
+        slots <<= 1;
+    }
+
+    // Lay out the sections, index aligned to 8 bytes
+    uint64_t offsets = sizeof(DictionaryHeader);
+    uint64_t pool = offsets + words.size() * sizeof(uint32_t);
+    uint64_t index = (pool + letters * sizeof(Letter) + 7) & ~7ULL;
+    uint64_t dawg = index + slots * sizeof(DictionarySlot);
+    uint64_t size = dawg + 2 * edges.size() * sizeof(uint32_t);
+
+    if (size > UINT32_MAX) {
+        _tprintf(_T("Error: dictionary too large (%llu bytes)\n"), size);
+        return false;
+    }
+
+    header.magic = DICTIONARY_MAGIC;
+    header.version = DICTIONARY_VERSION;
+    header.words = (uint32_t)words.size();
+    header.index_slots = (uint32_t)slots;
+    header.offsets = (uint32_t)offsets;
+    header.pool = (uint32_t)pool;
+    header.index = (uint32_t)index;
+    header.dawg = (uint32_t)dawg;
+    header.dawg_edges = (uint32_t)edges.size();
+    header.size = (uint32_t)size;
+
+    image.assign(size, 0);
+    memcpy(image.data(), &header, sizeof(DictionaryHeader));
+
+    uint32_t* offsetTable = (uint32_t*)(image.data() + offsets);
+    Letter* poolLetters = (Letter*)(image.data() + pool);
+    DictionarySlot* slotTable = (DictionarySlot*)(image.data() + index);
+    uint32_t at = 0;
+
+    for (uint32_t i = 0; i < header.words; ++i) {
+        offsetTable[i] = at;
+        at += (uint32_t)wordKeyLetters(words[i], poolLetters + at) + 1;
+    }
+
+    memcpy(image.data() + dawg, edges.data(), edges.size() * sizeof(uint32_t));
+    memcpy(image.data() + dawg + edges.size() * sizeof(uint32_t), reach.data(), reach.size() * sizeof(uint32_t));
+
+    // Index every word by its letter signature
+    for (uint32_t i = 0; i < header.words; ++i) {
+        LetterSignature sig;
+        const Letter* word = poolLetters + offsetTable[i];
+
+        signatureFromLetters(word, sig);    // keys are valid words
+
+        uint64_t hash = signatureHash(sig);
+        uint64_t slot = WordIndex::probe(slotTable, slots - 1, word, hash,
+            [poolLetters, offsetTable](uint32_t w) { return (const Letter*)poolLetters + offsetTable[w]; });
+
+        slotTable[slot].hash = (uint32_t)hash;
+        slotTable[slot].word = i + 1;
+    }
+
+    return true;
+}
+
+/**
+ * Write a dictionary image to disk
+ *
+ * @param path File to create (replaced if it exists)
+ * @param image Compiled image
+ * @return true on success, false otherwise
+ */
+bool writeDictionary(const TCHAR* path, const std::vector<uint8_t>& image) {
+    DWORD written = 0;
+    HANDLE file = CreateFile(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if (file == INVALID_HANDLE_VALUE) {
+        _tprintf(_T("CreateFile %d\n"), GetLastError());
+        return false;
+    }
+
+    if (!WriteFile(file, image.data(), (DWORD)image.size(), &written, NULL) || written != image.size()) {
+        _tprintf(_T("WriteFile %d\n"), GetLastError());
+        CloseHandle(file);
+        return false;
+    }
+
+    CloseHandle(file);
+    return true;
+}
+
+/**
+ * Offline compiler entry point: word list -> dictionary file
+ *
+ * @param input Text word list
+ * @param output Dictionary file to write
+ * @return true on success, false otherwise
+ */
+bool compileDictionaryFile(const TCHAR* input, const TCHAR* output) {
+    std::vector<WordKey> words;
+    std::vector<uint8_t> image;
+
+    if (!readWordList(input, words) || !compileDictionary(words, image) || !writeDictionary(output, image)) {
+        return false;
+    }
+
+    _tprintf(_T("Compiled %u words into '%s' (%u bytes)\n"), (uint32_t)words.size(), output, (uint32_t)image.size());
+    return true;
+}
+
+#endif
@@ -0,0 +1,183 @@
+#pragma once
+
+#ifndef _DICTIONARYVERSION_H_
+#define _DICTIONARYVERSION_H_
+
+#include "..\..\wordgame_common.h"
+#include "..\..\wordgame_dictionary.h"
+#include "WordIndex.h"
+#include "GuessFilter.h"
+#include "SolutionSet.h"
+#include "DictionaryCompiler.h"
+
+/**
+ * One loaded dictionary and everything built from it
+ * Never changed once published: a reload builds a whole new version in the background,
+ * game() swaps the pointer at a tick and the old one is freed once no guess can use it
+ */
+struct DictionaryVersion {
+    uint32_t generation;            // 1 at startup, +1 per reload; names the image mapping
+    HANDLE file;                    // Compiled dictionary file, INVALID_HANDLE_VALUE if built in memory
+    HANDLE mapping;                 // Named mapping of the image, shared with the bots
+    const DictionaryHeader* image;  // Read-only view of the image
+    bool embedded;                  // Built from EmbeddedDictionary.h (embeddedFind applies)
+    WordIndex index;                // for quick dictionary verification
+    GuessFilter filter;             // Bloom filter of the words
+    SolutionSet solutions;          // every word the board can form, rebuilt by game() (state mutex held)
+};
+
+/**
+ * Unmap and free a dictionary version
+ *
+ * @param v Version to free (NULL is ignored)
+ */
+void destroyDictionaryVersion(DictionaryVersion* v) {
+    if (v == NULL) {
+        return;
+    }
+
+    if (v->image != NULL) {
+        UnmapViewOfFile(v->image);
+    }
+
+    if (v->mapping != NULL) {
+        CloseHandle(v->mapping);
+    }
+
+    if (v->file != INVALID_HANDLE_VALUE) {
+        CloseHandle(v->file);
+    }
+
+    delete v;
+}
+
+/**
+ * Check if a file holds a compiled dictionary (magic number) rather than a word list
+ */
+bool isCompiledDictionary(HANDLE file) {
+    uint32_t magic = 0;
+    DWORD read = 0;
+
+    return ReadFile(file, &magic, sizeof(magic), &read, NULL) && read == sizeof(magic) && magic == DICTIONARY_MAGIC;
+}
+
+/**
+ * Load a dictionary and build everything derived from it
+ * Compiled dictionaries are mapped as they are; word lists (and the dictionary embedded
+ * in the server) are compiled into a pagefile backed mapping with the same layout.
+ * The image is published read-only under dictionaryImageName(generation).
+ *
+ * @param path Compiled dictionary or word list; NULL for 'words.dict' if present, else the built-in words
+ * @param generation Generation of the new version
+ * @param filterRate Target false positive rate of the guess filter
+ * @return New version, NULL on failure
+ */
+DictionaryVersion* loadDictionaryVersion(const TCHAR* path, uint32_t generation, double filterRate) {
+    DictionaryVersion* v = new DictionaryVersion();
+    TCHAR name[DICTIONARY_NAME_SIZE];
+    LARGE_INTEGER size = { 0 };
+
+    v->generation = generation;
+    v->file = INVALID_HANDLE_VALUE;
+    v->mapping = NULL;
+    v->image = NULL;
+    v->embedded = false;
+    dictionaryImageName(name, DICTIONARY_NAME_SIZE, generation);
+
+    if (path == NULL && GetFileAttributes(DICTIONARY_FILE_NAME) != INVALID_FILE_ATTRIBUTES) {
+        path = DICTIONARY_FILE_NAME;
+    }
+
+    if (path != NULL) {
+        v->file = CreateFile(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+        if (v->file == INVALID_HANDLE_VALUE || !GetFileSizeEx(v->file, &size)) {
+            _tprintf(_T("CreateFile %d\n"), GetLastError());
+            destroyDictionaryVersion(v);
+            return NULL;
+        }
+
+        if (!isCompiledDictionary(v->file)) {
+            CloseHandle(v->file);       // a word list, compiled below
+            v->file = INVALID_HANDLE_VALUE;
+        }
+    }
+
+    if (v->file != INVALID_HANDLE_VALUE) {
+        _tprintf(_T("Mapping compiled dictionary '%s'...\n"), path);
+
+        // Named mapping of the file itself, bots share the same pages
+        v->mapping = CreateFileMapping(v->file, NULL, PAGE_READONLY, 0, 0, name);
+    }
+    else {
+        std::vector<WordKey> words;
+        std::vector<uint8_t> image;
+
+        if (path != NULL) {
+            _tprintf(_T("Compiling word list '%s'...\n"), path);
+
+            if (!readWordList(path, words)) {
+                destroyDictionaryVersion(v);
+                return NULL;
+            }
+        }
+        else {
+            _tprintf(_T("Using built-in dictionary...\n"));
+            wordKeysFromList(embedded_words, EMBEDDED_WORDS, words);
+            v->embedded = true;
+        }
+
+        if (!compileDictionary(words, image)) {
+            destroyDictionaryVersion(v);
+            return NULL;
+        }
+
+        size.QuadPart = image.size();
+        v->mapping = CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, (DWORD)image.size(), name);
+
+        if (v->mapping != NULL) {
+            void* view = MapViewOfFile(v->mapping, FILE_MAP_WRITE, 0, 0, image.size());
+
+            if (view == NULL) {
+                std::cout << "MapViewOfFile " << GetLastError() << std::endl;
+                destroyDictionaryVersion(v);
+                return NULL;
+            }
+
+            memcpy(view, image.data(), image.size());
+            UnmapViewOfFile(view);
+        }
+    }
+
+    if (v->mapping == NULL) {
+        std::cout << "CreateFileMapping " << GetLastError() << std::endl;
+        destroyDictionaryVersion(v);
+        return NULL;
+    }
+
+    v->image = (const DictionaryHeader*)MapViewOfFile(v->mapping, FILE_MAP_READ, 0, 0, 0);
+
+    if (v->image == NULL) {
+        std::cout << "MapViewOfFile " << GetLastError() << std::endl;
+        destroyDictionaryVersion(v);
+        return NULL;
+    }
+
+    if (!dictionaryValid(v->image, size.QuadPart)) {
+        _tprintf(_T("Error: invalid dictionary image\n"));
+        destroyDictionaryVersion(v);
+        return NULL;
+    }
+
+    // index words by letter signature for fast lookup
+    v->index.attach(v->image);
+    v->solutions.reset(v->image);
+
+    // filter out guesses that are not words before the index is touched
+    v->filter.build(v->image, filterRate);
+
+    _tprintf(_T("Indexed %u words, guess filter: %llu bytes\n"), v->index.size(), v->filter.size());
+    return v;
+}
+
+#endif
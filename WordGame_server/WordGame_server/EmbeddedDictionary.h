@@ -0,0 +1,429 @@
+#pragma once
+
+#ifndef _EMBEDDEDDICTIONARY_H_
+#define _EMBEDDEDDICTIONARY_H_
+
+/* Generated by gen_embedded_dictionary.py from words.txt, do not edit */
+
+#include "..\..\wordgame_common.h"
+
+#define EMBEDDED_WORDS 135
+
+// Sorted words
+constexpr const TCHAR* embedded_words[EMBEDDED_WORDS > 0 ? EMBEDDED_WORDS : 1] = {
+    L"ant",
+    L"apple",
+    L"ax",
+    L"baby",
+    L"ball",
+    L"bird",
+    L"book",
+    L"box",
+    L"cage",
+    L"car",
+    L"cat",
+    L"chair",
+    L"cloud",
+    L"coin",
+    L"cup",
+    L"desk",
+    L"dice",
+    L"dog",
+    L"door",
+    L"dream",
+    L"drop",
+    L"ear",
+    L"echo",
+    L"edge",
+    L"egg",
+    L"elephant",
+    L"elm",
+    L"face",
+    L"fire",
+    L"fish",
+    L"flag",
+    L"flower",
+    L"fox",
+    L"gate",
+    L"gem",
+    L"glass",
+    L"gold",
+    L"green",
+    L"gun",
+    L"hand",
+    L"hat",
+    L"heart",
+    L"hill",
+    L"home",
+    L"house",
+    L"ice",
+    L"idea",
+    L"ink",
+    L"iron",
+    L"island",
+    L"item",
+    L"jar",
+    L"jet",
+    L"joke",
+    L"jug",
+    L"jump",
+    L"jungle",
+    L"key",
+    L"king",
+    L"kit",
+    L"kite",
+    L"knife",
+    L"knot",
+    L"lake",
+    L"lamb",
+    L"leaf",
+    L"light",
+    L"lion",
+    L"log",
+    L"map",
+    L"mat",
+    L"moon",
+    L"mountain",
+    L"mouse",
+    L"music",
+    L"nail",
+    L"nest",
+    L"net",
+    L"night",
+    L"number",
+    L"nut",
+    L"ocean",
+    L"odd",
+    L"oil",
+    L"onion",
+    L"orange",
+    L"owl",
+    L"paper",
+    L"park",
+    L"pen",
+    L"pine",
+    L"pot",
+    L"purple",
+    L"queen",
+    L"quick",
+    L"quiet",
+    L"quilt",
+    L"quit",
+    L"quiz",
+    L"rain",
+    L"river",
+    L"road",
+    L"rope",
+    L"rose",
+    L"seed",
+    L"ship",
+    L"snow",
+    L"star",
+    L"sun",
+    L"table",
+    L"tent",
+    L"top",
+    L"tower",
+    L"tree",
+    L"umbrella",
+    L"under",
+    L"unit",
+    L"up",
+    L"use",
+    L"valley",
+    L"van",
+    L"view",
+    L"violin",
+    L"voice",
+    L"water",
+    L"wave",
+    L"web",
+    L"wind",
+    L"wolf",
+    L"yard",
+    L"yarn",
+    L"year",
+    L"zebra",
+    L"zip",
+    L"zone",
+};
+
+// Seed per bucket (bucket = hash(0, word) % EMBEDDED_WORDS), or -(slot + 1) for single word buckets
+constexpr int32_t embedded_seeds[EMBEDDED_WORDS > 0 ? EMBEDDED_WORDS : 1] = {
+    -135,
+    -133,
+    -124,
+    -123,
+    0,
+    -121,
+    -119,
+    1,
+    1,
+    2,
+    1,
+    0,
+    -117,
+    -115,
+    -110,
+    2,
+    1,
+    1,
+    0,
+    1,
+    1,
+    -104,
+    0,
+    1,
+    -103,
+    0,
+    1,
+    2,
+    6,
+    0,
+    -102,
+    0,
+    0,
+    -101,
+    -98,
+    0,
+    -97,
+    0,
+    0,
+    -95,
+    -94,
+    -91,
+    0,
+    -89,
+    0,
+    2,
+    0,
+    2,
+    -85,
+    4,
+    1,
+    0,
+    -81,
+    0,
+    0,
+    -79,
+    -76,
+    0,
+    0,
+    -74,
+    -73,
+    0,
+    0,
+    0,
+    -72,
+    1,
+    3,
+    0,
+    -70,
+    -65,
+    2,
+    -64,
+    -62,
+    -61,
+    -59,
+    1,
+    0,
+    -55,
+    1,
+    -50,
+    -47,
+    0,
+    0,
+    -46,
+    -43,
+    0,
+    -39,
+    0,
+    0,
+    0,
+    -36,
+    5,
+    0,
+    4,
+    0,
+    1,
+    -34,
+    -33,
+    -32,
+    1,
+    -31,
+    -29,
+    1,
+    0,
+    -24,
+    0,
+    -22,
+    1,
+    2,
+    0,
+    0,
+    -18,
+    -16,
+    -14,
+    8,
+    -13,
+    -11,
+    1,
+    -10,
+    0,
+    -8,
+    0,
+    2,
+    0,
+    0,
+    -5,
+    0,
+    4,
+    0,
+    0,
+    2,
+    0,
+    0,
+    -4,
+    2,
+};
+
+// Word number held by each slot
+constexpr uint32_t embedded_slots[EMBEDDED_WORDS > 0 ? EMBEDDED_WORDS : 1] = {
+    18,
+    6,
+    68,
+    85,
+    75,
+    62,
+    34,
+    26,
+    45,
+    89,
+    17,
+    90,
+    120,
+    82,
+    30,
+    113,
+    25,
+    1,
+    83,
+    49,
+    125,
+    22,
+    39,
+    126,
+    111,
+    65,
+    101,
+    99,
+    108,
+    32,
+    117,
+    77,
+    127,
+    12,
+    96,
+    16,
+    107,
+    72,
+    80,
+    53,
+    106,
+    123,
+    20,
+    79,
+    31,
+    42,
+    64,
+    13,
+    86,
+    63,
+    3,
+    15,
+    102,
+    94,
+    119,
+    81,
+    134,
+    7,
+    36,
+    11,
+    70,
+    92,
+    4,
+    118,
+    52,
+    56,
+    78,
+    40,
+    8,
+    74,
+    91,
+    33,
+    76,
+    132,
+    121,
+    28,
+    48,
+    47,
+    104,
+    55,
+    41,
+    27,
+    130,
+    103,
+    110,
+    93,
+    54,
+    115,
+    71,
+    95,
+    73,
+    24,
+    50,
+    122,
+    67,
+    43,
+    98,
+    66,
+    131,
+    37,
+    129,
+    97,
+    105,
+    124,
+    100,
+    23,
+    19,
+    0,
+    133,
+    112,
+    9,
+    87,
+    14,
+    61,
+    38,
+    88,
+    128,
+    51,
+    10,
+    21,
+    2,
+    60,
+    84,
+    109,
+    46,
+    29,
+    58,
+    114,
+    116,
+    5,
+    59,
+    44,
+    35,
+    57,
+    69,
+};
+
+#endif
@@ -0,0 +1,63 @@
+#pragma once
+
+#ifndef _EPOCH_H_
+#define _EPOCH_H_
+
+#include "..\..\wordgame_common.h"
+
+#define EPOCH_MAX_READERS 8     // threads that read shared data without a lock
+
+/**
+ * Epoch based reclamation for data read without locks
+ * A reader announces the epoch it entered in before loading a shared pointer and clears it
+ * when done. A writer that unpublished an object calls synchronize(): it opens a new epoch
+ * and waits for every reader still in an older one, after which nobody can hold the object.
+ * Readers never wait; only the (background) writer does.
+ */
+class EpochDomain {
+    volatile LONG64 epoch;                          // current epoch, starts at 1
+    volatile LONG64 readers[EPOCH_MAX_READERS];     // epoch each reader entered, 0 = outside
+
+public:
+    EpochDomain() : epoch(1) {
+        for (int i = 0; i < EPOCH_MAX_READERS; ++i) {
+            readers[i] = 0;
+        }
+    };
+
+    /**
+     * Start a read side section (full barrier: the pointer is loaded after this)
+     *
+     * @param reader Slot of the calling thread (0 <= reader < EPOCH_MAX_READERS)
+     */
+    void enter(int reader) {
+        InterlockedExchange64(&readers[reader], epoch);
+    }
+
+    /**
+     * End a read side section
+     *
+     * @param reader Slot of the calling thread
+     */
+    void leave(int reader) {
+        InterlockedExchange64(&readers[reader], 0);
+    }
+
+    /**
+     * Wait until every reader that could have loaded an unpublished pointer is done
+     * Call after replacing the pointer, before freeing what it pointed to
+     */
+    void synchronize() {
+        LONG64 now = InterlockedIncrement64(&epoch);
+
+        for (int i = 0; i < EPOCH_MAX_READERS; ++i) {
+            LONG64 entered;
+
+            while ((entered = readers[i]) != 0 && entered < now) {
+                Sleep(1);
+            }
+        }
+    }
+};
+
+#endif
@@ -4,118 +4,614 @@
 #define _GAMEDATA_H_
 
 #include "..\..\wordgame_common.h"
+#include "ScoreJournal.h"
+#include "Broadcaster.h"
 #include <iostream>
 #include <windows.h>
 #include <tchar.h>
 #include <cstdlib>
 #include <cstring>
 #include <string>
-#include <set>
-#include <map>
+#include <vector>
 #include <sstream>
 #include <functional>
 
+#define PLAYER_GENERATION_MASK 0x1FFFu                  // high bits: generation (IDs stay positive)
+#define PLAYER_NONE UINT32_MAX                          // no slot (empty tree link, empty list)
+
 /**
- * Simple ID generator for creating unique player IDs
- * Uses incrementing counter starting from 0
+ * Represents a connected player in the game
+ * Contains identification, score, and the client's pipe,
+ * plus its links in the leaderboard (players are never moved, only relinked)
  */
-struct Player_ID_Generator {
-    int32_t state;  // Current ID counter
-
-    Player_ID_Generator() : state(0) {};
+struct Player {
+    TCHAR name[NAME_SIZE];                   // Player name
+    uint32_t name_hash;                      // playerNameHash(name)
+    int32_t id;                              // Unique player identifier (generation << PLAYER_SLOT_BITS | slot)
+    int32_t score;                           // Current player score
+    TCHAR pipe_name[2 * ARRAY_SIZE + 2];    // Named pipe path for client communication
+    mutable ClientConnection connection;     // Open connection to pipe_name, if packets are sent directly
+
+    uint32_t generation;                     // Bumped every time the slot is reused
+    uint32_t live;                           // Position in the live list, PLAYER_NONE if the slot is free
+    uint64_t stamp;                          // Order of the last score change (ties: earliest first)
+    uint32_t left, right;                    // Leaderboard tree children
+    uint32_t priority;                       // Leaderboard tree heap priority
+    uint32_t size;                           // Players in the leaderboard subtree rooted here
+};
 
-    /**
-     * Generate next unique player ID
-     * @return Next available ID (incremented from previous)
-     */
-    int32_t gen() {
-        state += 1;
-        return state;
-    }
+/**
+ * Position of a player, read in one consistent snapshot
+ */
+struct PlayerStanding {
+    int32_t rank;       // 1 = highest score
+    int32_t players;    // Players in the game
+    int32_t score;      // Score of the player
+    int32_t next;       // Points missing to climb one rank (0 if first)
 };
 
-// Global player ID generator instance
-static Player_ID_Generator pid_gen;
+/**
+ * Ranks of a player around a score change
+ */
+struct RankChange {
+    uint32_t before;    // 1 = highest score
+    uint32_t after;
+};
 
 /**
- * Represents a connected player in the game
- * Contains identification, score, and communication handles
+ * Leaderboard line copied out of the store
  */
-struct Player {
-    int32_t id;                              // Unique player identifier
-    int32_t score;                           // Current player score
-    TCHAR pipe_name[2 * ARRAY_SIZE + 2];    // Named pipe path for client communication
-    HANDLE update_handle;                    // Event handle for notifying client of updates
+struct LeaderboardEntry {
+    TCHAR name[NAME_SIZE];
+    int32_t score;
 };
 
+/**
+ * Hash of a player name (FNV-1a)
+ */
+inline uint32_t playerNameHash(const TCHAR* name) {
+    uint32_t h = 0x811C9DC5u;
+
+    for (int i = 0; name[i] != TEXT('\0'); ++i) {
+        h = (h ^ (uint32_t)name[i]) * 0x01000193u;
+    }
+
+    return h;
+}
+
 /**
  * Main game data management class
  * Handles player registration, scoring, and client communication
- * Maintains multiple data structures for efficient lookups:
- * - id_map: ID -> player name mapping
- * - score_map: score -> player name mapping (sorted by score descending)
- * - name_map: player name -> Player object mapping
+ * Players live in a fixed array of slots; everything else refers to them by slot:
+ * - player IDs carry the slot and its generation, so an ID is one array access and
+ *   a stale ID (player left, slot reused) is told apart by the generation
+ * - names: flat open addressing table of slots (linear probing, load factor <= 0.5)
+ * - live: dense list of occupied slots, for broadcasts
+ * - leaderboard: treap threaded through the slots, ordered by score (highest first),
+ *   so a score change relinks one player in O(log n) and nothing is allocated;
+ *   subtree sizes make it an order statistic tree (rank, select and rank ranges in O(log n))
+ *
+ * Writers (insert, remove, update and anything sending to clients) are serialized by the
+ * caller (data_handle). Readers of scores, ranks, names and the leaderboard take no lock:
+ * every change is bracketed by a sequence counter (seqlock) and a reader retries if the
+ * counter moved. Slots are never reallocated, so a read racing a change only sees stale
+ * values, which the retry throws away.
  */
 class GameData {
-    // Maps player ID to player name for quick ID-based lookups
-    std::map<int32_t, std::wstring> id_map;
-
-    // Maps score to player name, sorted by score (highest first) for leaderboard
-    std::multimap<int32_t, std::wstring, std::greater<unsigned int>> score_map;
-
-    // Maps player name to Player object for complete player data access
-    std::map<std::wstring, Player> name_map;
-
-    bool write(const TCHAR* name, Packet& p) {
-        // Connect to client's named pipe
-        bool res;
-        HANDLE pipeHandle = CreateFile(
-            name,
-            GENERIC_READ | GENERIC_WRITE,
-            0,
-            NULL,
-            OPEN_EXISTING,
-            0,
-            NULL
-        );
-
-        if (pipeHandle == INVALID_HANDLE_VALUE) {
-#ifdef DEBUG
-            std::cout << __func__ << " ";
-            _tprintf(L"CreateFile %d\n", GetLastError());
-#endif
-            return false;  // Skip this client if connection fails
+    std::vector<Player> slots;          // capacity players
+    std::vector<uint32_t> free_slots;   // stack of free slots
+    std::vector<uint32_t> live;         // occupied slots, in no particular order
+    std::vector<uint32_t> names;        // name table: slot + 1, 0 if empty
+    uint32_t name_mask;
+    uint32_t root;                      // leaderboard tree root
+    uint64_t stamps;                    // score changes so far
+    uint32_t seed;                      // leaderboard priorities (xorshift)
+    volatile LONG sequence;             // odd while a change is being made
+    PlayerNameTable* published;         // shared name table clients resolve IDs with (NULL if none)
+    ScoreJournal* journal;              // journal of every change (NULL if none)
+    LeaderboardPage* page;              // shared top of the leaderboard and scores (NULL if none)
+    Broadcaster* outbox;                // delivers the packets for one player (NULL: sent directly)
+    EventRing* events;                  // shared ring of the events for every player (NULL if none)
+    const HANDLE* event_signals;        // the two events set by head parity when an event is written
+
+    /**
+     * Start a change (readers retry until it ends)
+     */
+    void writeBegin() {
+        InterlockedIncrement(&sequence);
+    }
+
+    /**
+     * End a change
+     */
+    void writeEnd() {
+        InterlockedIncrement(&sequence);
+    }
+
+    /**
+     * Start a lock free read
+     *
+     * @return Sequence to pass to readRetry
+     */
+    LONG readBegin() const {
+        LONG s;
+
+        while ((s = sequence) & 1) {
+            YieldProcessor();       // a change is being made
         }
 
-        // Send packet and wait for acknowledgment
-        if(!WriteFile(pipeHandle, &p, sizeof(Packet), NULL, NULL)){
-#ifdef DEBUG
-            std::cout << __func__ << " ";
-            _tprintf(L"WriteFile %d\n", GetLastError());
-#endif
-            return false;
+        return s;
+    }
+
+    /**
+     * Check if a lock free read must be redone (the data changed under it)
+     */
+    bool readRetry(LONG s) const {
+        MemoryBarrier();            // the reads happen before the sequence is checked again
+        return sequence != s;
+    }
+
+    /**
+     * Get the slot of a player ID, PLAYER_NONE if no such player (any more)
+     */
+    uint32_t slotOf(int32_t id) const {
+        uint32_t slot = (uint32_t)id & PLAYER_SLOT_MASK;
+
+        if (id <= 0 || slot >= slots.size() || slots[slot].live == PLAYER_NONE || slots[slot].id != id) {
+            return PLAYER_NONE;
         }
 
-        if (!ReadFile(pipeHandle, &res, sizeof(bool), NULL, NULL)) {
-#ifdef DEBUG
-            std::cout << __func__ << " ";
-            _tprintf(L"ReadFile %d\n", GetLastError());
-#endif
+        return slot;
+    }
+
+    /**
+     * Get the position of a name in the name table (its entry, or the empty entry where it would go)
+     */
+    uint32_t namePosition(const TCHAR* name, uint32_t hash) const {
+        uint32_t i = hash & name_mask;
+
+        while (names[i] != 0) {
+            const Player& p = slots[names[i] - 1];
+
+            if (p.name_hash == hash && _tcscmp(p.name, name) == 0) {
+                break;
+            }
+
+            i = (i + 1) & name_mask;
+        }
+
+        return i;
+    }
+
+    /**
+     * Get the slot of a player name, PLAYER_NONE if no such player
+     */
+    uint32_t slotOf(const TCHAR* name) const {
+        uint32_t i = namePosition(name, playerNameHash(name));
+        return names[i] == 0 ? PLAYER_NONE : names[i] - 1;
+    }
+
+    /**
+     * Remove entry i of the name table, shifting back the entries that probed past it
+     */
+    void nameErase(uint32_t i) {
+        uint32_t j = i;
+
+        names[i] = 0;
+
+        while (names[j = (j + 1) & name_mask] != 0) {
+            uint32_t home = slots[names[j] - 1].name_hash & name_mask;
+
+            // entry j may move to the hole if the hole is between its home and j (cyclically)
+            if (((j - home) & name_mask) >= ((j - i) & name_mask)) {
+                names[i] = names[j];
+                names[j] = 0;
+                i = j;
+            }
+        }
+    }
+
+    /**
+     * Check if slot a ranks before slot b (higher score, or same score and changed earlier)
+     */
+    bool ranksBefore(uint32_t a, uint32_t b) const {
+        const Player& x = slots[a];
+        const Player& y = slots[b];
+        return x.score > y.score || (x.score == y.score && x.stamp < y.stamp);
+    }
+
+    /**
+     * Get the number of players in a leaderboard subtree
+     */
+    uint32_t rankSize(uint32_t t) const {
+        return t == PLAYER_NONE ? 0 : slots[t].size;
+    }
+
+    /**
+     * Recount a leaderboard node after its children changed
+     */
+    void rankResize(uint32_t t) {
+        slots[t].size = 1 + rankSize(slots[t].left) + rankSize(slots[t].right);
+    }
+
+    /**
+     * Split a leaderboard subtree into the players ranking before slot k and the rest
+     */
+    void rankSplit(uint32_t t, uint32_t k, uint32_t& before, uint32_t& after) {
+        if (t == PLAYER_NONE) {
+            before = after = PLAYER_NONE;
+        }
+        else if (ranksBefore(t, k)) {
+            rankSplit(slots[t].right, k, slots[t].right, after);
+            rankResize(t);
+            before = t;
+        }
+        else {
+            rankSplit(slots[t].left, k, before, slots[t].left);
+            rankResize(t);
+            after = t;
+        }
+    }
+
+    /**
+     * Join two leaderboard subtrees (every player of a ranks before every player of b)
+     */
+    uint32_t rankMerge(uint32_t a, uint32_t b) {
+        if (a == PLAYER_NONE || b == PLAYER_NONE) {
+            return a == PLAYER_NONE ? b : a;
+        }
+
+        if (slots[a].priority > slots[b].priority) {
+            slots[a].right = rankMerge(slots[a].right, b);
+            rankResize(a);
+            return a;
+        }
+
+        slots[b].left = rankMerge(a, slots[b].left);
+        rankResize(b);
+        return b;
+    }
+
+    /**
+     * Link a slot into the leaderboard by its current score
+     */
+    void rankInsert(uint32_t k) {
+        uint32_t before, after;
+
+        slots[k].left = slots[k].right = PLAYER_NONE;
+        slots[k].size = 1;
+        slots[k].stamp = ++stamps;
+        rankSplit(root, k, before, after);
+        root = rankMerge(rankMerge(before, k), after);
+    }
+
+    /**
+     * Unlink a slot from the leaderboard subtree at t
+     */
+    uint32_t rankErase(uint32_t t, uint32_t k) {
+        if (t == k) {
+            return rankMerge(slots[t].left, slots[t].right);
+        }
+
+        if (ranksBefore(k, t)) {
+            slots[t].left = rankErase(slots[t].left, k);
+        }
+        else {
+            slots[t].right = rankErase(slots[t].right, k);
+        }
+
+        rankResize(t);
+        return t;
+    }
+
+    /**
+     * Get the rank of a slot in the leaderboard (1 = highest score)
+     */
+    uint32_t rankOf(uint32_t k) const {
+        uint32_t rank = rankSize(slots[k].left) + 1;
+        uint32_t t = root;
+        size_t steps = 0;
+
+        // every node left of the path to k ranks before it (bounded: links may be torn in a lock free read)
+        while (t != k && t < slots.size() && ++steps <= slots.size()) {
+            if (ranksBefore(k, t)) {
+                t = slots[t].left;
+            }
+            else {
+                rank += rankSize(slots[t].left) + 1;
+                t = slots[t].right;
+            }
+        }
+
+        return rank;
+    }
+
+    /**
+     * Get the slot at a rank (1 <= rank <= count())
+     */
+    uint32_t rankSelect(uint32_t rank) const {
+        uint32_t t = root;
+        size_t steps = 0;
+
+        while (t < slots.size() && ++steps <= slots.size()) {
+            uint32_t left = rankSize(slots[t].left);
+
+            if (rank <= left) {
+                t = slots[t].left;
+            }
+            else if (rank == left + 1) {
+                break;
+            }
+            else {
+                rank -= left + 1;
+                t = slots[t].right;
+            }
+        }
+
+        return t < slots.size() ? t : PLAYER_NONE;
+    }
+
+    /**
+     * Visit the players of a leaderboard subtree with ranks in [first, last], in rank order
+     *
+     * @param t Subtree
+     * @param offset Players ranking before the subtree
+     */
+    template <typename F>
+    void rankWalk(uint32_t t, uint32_t offset, uint32_t first, uint32_t last, F& f) const {
+        if (t == PLAYER_NONE) {
+            return;
+        }
+
+        uint32_t rank = offset + rankSize(slots[t].left) + 1;
+
+        if (first < rank) {
+            rankWalk(slots[t].left, offset, first, last, f);
+        }
+
+        if (first <= rank && rank <= last) {
+            f(slots[t], rank);
+        }
+
+        if (last > rank) {
+            rankWalk(slots[t].right, rank, first, last, f);
+        }
+    }
+
+    /**
+     * Copy a changed slot and the top of the leaderboard to the shared page
+     * Call inside the change: the page gets the version the change makes
+     */
+    void pagePublish(uint32_t k) {
+        if (page == NULL) {
+            return;
+        }
+
+        InterlockedIncrement(&page->sequence);
+        page->scores[k].id = slots[k].live == PLAYER_NONE ? 0 : slots[k].id;
+        page->scores[k].score = slots[k].score;
+        page->top.version = (uint32_t)(sequence + 1) / 2 + 1;
+        page->top.players = (uint32_t)live.size();
+        page->top.count = 0;
+
+        ranked(1, LEADERBOARD_TOP, [this](const Player& p, uint32_t) {
+            LeaderboardTopEntry& e = page->top.entries[page->top.count++];
+            e.id = p.id;
+            e.score = p.score;
+            memcpy(e.name, p.name, sizeof(e.name));
+        });
+
+        InterlockedIncrement(&page->sequence);
+    }
+
+    /**
+     * Set a player's score and move it to its new place in the leaderboard
+     *
+     * @param change If not NULL, receives the ranks before and after (O(log n) each)
+     */
+    void setScore(uint32_t k, int32_t score, RankChange* change = NULL) {
+        writeBegin();
+
+        if (change != NULL) {
+            change->before = rankOf(k);
+        }
+
+        root = rankErase(root, k);
+        slots[k].score = score;
+        rankInsert(k);
+
+        if (change != NULL) {
+            change->after = rankOf(k);
+        }
+
+        pagePublish(k);
+
+        if (journal != NULL) {
+            journal->append(JOURNAL_UPDATE, slots[k].name, score);
+        }
+
+        writeEnd();
+    }
+
+    /**
+     * Free an occupied slot
+     */
+    void removeSlot(uint32_t k) {
+        Player& p = slots[k];
+
+        if (journal != NULL) {
+            journal->append(JOURNAL_REMOVE, p.name, p.score);
+        }
+
+        root = rankErase(root, k);
+        nameErase(namePosition(p.name, p.name_hash));
+
+        // swap the last live slot into this one's place
+        live[p.live] = live.back();
+        slots[live.back()].live = p.live;
+        live.pop_back();
+
+        p.live = PLAYER_NONE;
+        p.connection.close();
+
+        if (outbox != NULL) {
+            outbox->detach(p.id);   // after the packets already posted for it
+        }
+
+        pagePublish(k);
+        p.name[0] = TEXT('\0');
+        free_slots.push_back(k);
+    }
+
+public:
+    /**
+     * Create an empty player store
+     *
+     * @param capacity Maximum number of players (at most PLAYER_SLOT_MASK + 1)
+     */
+    GameData(uint32_t capacity = MAX_PLAYERS) : name_mask(1), root(PLAYER_NONE), stamps(0), seed(0x9E3779B9u), sequence(0), published(NULL), journal(NULL), page(NULL), outbox(NULL), events(NULL), event_signals(NULL) {
+        setCapacity(capacity);
+    }
+
+    /**
+     * Set the maximum number of players
+     * Only before the first login: slots are never reallocated while readers may use them
+     *
+     * @param capacity Maximum number of players (at most PLAYER_SLOT_MASK + 1)
+     * @return false if players are connected or the names or the leaderboard are already published
+     */
+    bool setCapacity(uint32_t capacity) {
+        if (!live.empty() || published != NULL || page != NULL) {
             return false;
         }
 
-        CloseHandle(pipeHandle);
+        capacity = capacity > PLAYER_SLOT_MASK + 1 ? PLAYER_SLOT_MASK + 1 : capacity;
+        slots.assign(capacity, Player());
+        free_slots.clear();
+        live.clear();
+        live.reserve(capacity);
+
+        for (uint32_t i = capacity; i > 0; --i) {
+            slots[i - 1].generation = 0;
+            slots[i - 1].live = PLAYER_NONE;
+            free_slots.push_back(i - 1);    // slot 0 on top
+        }
+
+        name_mask = 1;
+
+        while (name_mask + 1 < 2 * capacity) {
+            name_mask = 2 * name_mask + 1;
+        }
+
+        names.assign(name_mask + 1, 0);
         return true;
     }
 
-public:
     /**
-     * Destructor - Clean up all player event handles
+     * Publish player names in a shared table (see PlayerNameTable)
+     *
+     * @param table Table of at least capacity() entries, zeroed
+     */
+    void publishNames(PlayerNameTable* table) {
+        published = table;
+        published->capacity = (uint32_t)slots.size();
+
+        for (uint32_t k : live) {
+            memcpy(published->entries[k].name, slots[k].name, sizeof(slots[k].name));
+            InterlockedExchange(&published->entries[k].id, slots[k].id);
+        }
+    }
+
+    /**
+     * Publish the top of the leaderboard and the scores in a shared page (see LeaderboardPage)
+     *
+     * @param p Page of at least capacity() score entries, zeroed
      */
-    ~GameData() {
-        for (auto& p : name_map) {
-            CloseHandle(p.second.update_handle);
+    void publishLeaderboard(LeaderboardPage* p) {
+        p->capacity = (uint32_t)slots.size();
+
+        for (uint32_t k : live) {
+            p->scores[k].id = slots[k].id;
+            p->scores[k].score = slots[k].score;
         }
+
+        page = p;
+        pagePublish(live.empty() ? 0 : live[0]);
+    }
+
+    /**
+     * Write the events for every player to a shared ring from now on (see EventRing)
+     *
+     * @param ring Ring, zeroed
+     * @param signals Events set by head parity (manual reset)
+     */
+    void publishEvents(EventRing* ring, const HANDLE* signals) {
+        events = ring;
+        event_signals = signals;
+    }
+
+    /**
+     * Hand the packets for one player to a broadcaster from now on (see Broadcaster)
+     * Players already in the game are attached to it
+     */
+    void broadcastThrough(Broadcaster* b) {
+        outbox = b;
+
+        for (uint32_t k : live) {
+            slots[k].connection.close();
+            outbox->attach(slots[k].id, slots[k].pipe_name);
+        }
+    }
+
+    /**
+     * Journal every change from now on (see ScoreJournal)
+     */
+    void journalTo(ScoreJournal* j) {
+        journal = j;
+    }
+
+    /**
+     * Copy every player's score for a journal snapshot (lock free)
+     *
+     * @param records Receives one JOURNAL_INSERT record per player
+     * @return Journal sequence the copy reflects (every record before it, none after)
+     */
+    uint64_t journalState(std::vector<JournalRecord>& records) const {
+        uint64_t at;
+        LONG s;
+
+        do {
+            s = readBegin();
+            records.clear();
+            at = journal->sequence();   // appended inside the same changes as the slots
+
+            for (size_t i = 0; i < live.size() && i < slots.size(); ++i) {
+                uint32_t k = live[i];
+
+                if (k < slots.size()) {
+                    JournalRecord r;
+                    journalRecord(r, JOURNAL_INSERT, slots[k].name, slots[k].score);
+                    records.push_back(r);
+                }
+            }
+        } while (readRetry(s));
+
+        return at;
+    }
+
+    /**
+     * Get the leaderboard version: changes made to players and scores so far (lock free)
+     * Read it before the leaderboard: a copy taken after it is at least that recent
+     */
+    uint32_t version() const {
+        return (uint32_t)readBegin() / 2;
+    }
+
+    /**
+     * Get the maximum number of players
+     */
+    uint32_t capacity() const {
+        return (uint32_t)slots.size();
     }
 
     /**
@@ -128,9 +624,7 @@ public:
      */
     Login_Return_Type insert(const TCHAR* name, const int32_t initial_score = 0)
     {
-        Player p = { 0 };
-        HANDLE update_event, pipe_handle = 0;
-        TCHAR temp[2 * ARRAY_SIZE + 2] = { 0 };
+        TCHAR pipe_name[2 * ARRAY_SIZE + 2] = { 0 };
         Login_Return_Type return_type = { 0 };
 
         // Check if player name is already taken
@@ -141,44 +635,66 @@ public:
         }
 
         // Check if server has reached maximum player capacity
-        if (name_map.size() >= MAX_PLAYERS) {
+        if (free_slots.empty()) {
             return_type.flag = SERVER_FULL;
             return_type.id = -1;
             return return_type;
         }
 
-        // Try to open the client's update event handle
-        // Format: "Local\\<playername>_update"
-        _stprintf_s(temp, TEXT("%s%s%s"), TEXT("Local\\"), name, TEXT("_update"));
-        update_event = OpenEvent(EVENT_ALL_ACCESS, FALSE, temp);
-
-        if (!update_event) {
-            return_type.flag = NO_EVENT;
-            return_type.id = -1;
-            return return_type;
-        }
-
         // Verify client's named pipe exists and is available
         // Format: "\\\\.\\pipe\\<playername>"
-        _stprintf_s(p.pipe_name, TEXT("%s%s"), TEXT("\\\\.\\pipe\\"), name);
+        _stprintf_s(pipe_name, TEXT("%s%s"), TEXT("\\\\.\\pipe\\"), name);
 
-        if (!WaitNamedPipe(p.pipe_name, 0))
+        if (!WaitNamedPipe(pipe_name, 0))
         {
             return_type.flag = NO_PIPE;
             return_type.id = -1;
             return return_type;
         }
 
-        // Initialize player data
-        p.id = pid_gen.gen();           // Generate unique ID
+        writeBegin();
+
+        // Take a free slot; its new generation makes the ID differ from any earlier one
+        uint32_t k = free_slots.back();
+        Player& p = slots[k];
+        free_slots.pop_back();
+
+        p.generation = (p.generation % PLAYER_GENERATION_MASK) + 1;     // 1 .. PLAYER_GENERATION_MASK
+        p.id = (int32_t)(p.generation << PLAYER_SLOT_BITS | k);
         p.score = initial_score;        // Set initial score
-        p.update_handle = update_event; // Store event handle for updates
+        _tcsncpy_s(p.name, name, _TRUNCATE);
+        _tcscpy_s(p.pipe_name, pipe_name);
+        p.name_hash = playerNameHash(p.name);
+
+        // Intern the name for the clients: the entry is claimed only once the name is whole
+        if (published != NULL) {
+            PlayerNameEntry& e = published->entries[k];
+            InterlockedExchange(&e.id, 0);
+            memcpy(e.name, p.name, sizeof(p.name));
+            InterlockedExchange(&e.id, p.id);
+        }
+
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        p.priority = seed;
 
-        // Add player to all tracking data structures
-        std::wstring n(name);
-        this->name_map[n] = p;                                                    // Name -> Player mapping
-        this->id_map[p.id] = n;                                                  // ID -> Name mapping
-        this->score_map.insert(std::pair<int32_t, std::wstring>(initial_score, n)); // Score -> Name mapping
+        // Add player to the name table, the live list and the leaderboard
+        names[namePosition(p.name, p.name_hash)] = k + 1;
+        p.live = (uint32_t)live.size();
+        live.push_back(k);
+        rankInsert(k);
+        pagePublish(k);
+
+        if (journal != NULL) {
+            journal->append(JOURNAL_INSERT, p.name, p.score);
+        }
+
+        if (outbox != NULL) {
+            outbox->attach(p.id, p.pipe_name);
+        }
+
+        writeEnd();
 
         // Return success with assigned player ID
         return_type.flag = LOGIN;
@@ -189,40 +705,21 @@ public:
 
     /**
      * Remove player by name
-     * Cleans up all references in id_map, score_map, and name_map
      *
      * @param name Player name to remove
      * @return true if player was found and removed, false otherwise
      */
     bool remove(const TCHAR* name) {
-        std::wstring player_name(name);
-
-        // Find player in name_map
-        std::map<std::wstring, Player>::iterator itr1 = name_map.find(player_name);
-
-        if (itr1 != name_map.end()) {
-            int id = itr1->second.id;
-            int score = itr1->second.score;
-            name_map.erase(itr1);  // Remove from name_map
-
-            // Remove from id_map
-            std::map<int32_t, std::wstring>::iterator itr = id_map.find(id);
-            if (itr != id_map.end()) {
-                id_map.erase(itr);
-
-                // Remove from score_map (need to find correct entry since scores may not be unique)
-                auto range = score_map.equal_range(score);
-                for (auto i = range.first; i != range.second; ++i) {
-                    if (i->second == player_name) {
-                        score_map.erase(i);
-                        return true;
-                    }
-                }
-                return false;
-            }
+        uint32_t k = slotOf(name);
+
+        if (k == PLAYER_NONE) {
             return false;
         }
-        return false;
+
+        writeBegin();
+        removeSlot(k);
+        writeEnd();
+        return true;
     }
 
     /**
@@ -233,85 +730,49 @@ public:
      * @return true if player was found and removed, false otherwise
      */
     bool remove(int32_t id) {
-        // Find player name by ID
-        std::map<int32_t, std::wstring>::iterator itr = id_map.find(id);
-
-        if (itr != id_map.end()) {
-            std::wstring player_name = (*itr).second;
-            id_map.erase(id);  // Remove from id_map
-
-            // Remove from name_map
-            std::map<std::wstring, Player>::iterator itr1 = name_map.find(player_name); // map<wstring, Player>::find(&name_map, player_name)
-            if (itr1 != name_map.end()) {
-                int score = itr1->second.score;
-                name_map.erase(player_name);
-
-                // Remove from score_map
-                auto range = score_map.equal_range(score);
-                for (auto i = range.first; i != range.second; ++i) {
-                    if (i->second == player_name) {
-                        score_map.erase(i);
-                        return true;
-                    }
-                }
-                return false;
-            }
+        uint32_t k = slotOf(id);
+
+        if (k == PLAYER_NONE) {
             return false;
         }
-        return false;
+
+        writeBegin();
+        removeSlot(k);
+        writeEnd();
+        return true;
     }
 
     /**
-     * Check if a player with given name already exists
+     * Check if a player with given name already exists (writer side)
      *
      * @param name Player name to check
      * @return true if player exists, false otherwise
      */
-    bool playerExists(const TCHAR* name) {
-        std::wstring player_name(name);
-        return (name_map.find(player_name) != name_map.end());
+    bool playerExists(const TCHAR* name) const {
+        return slotOf(name) != PLAYER_NONE;
     }
 
     /**
      * Update player score by ID
-     * Adjusts score and updates score_map for leaderboard consistency
+     * Adjusts score and moves the player in the leaderboard
      * Score cannot go below 0
      *
      * @param id Player ID to update
      * @param increment Amount to add to current score (can be negative)
+     * @param change If not NULL, receives the player's ranks before and after (to spot overtakes)
      * @return true if update successful, false if player not found
      */
-    bool update(const int32_t id, const int32_t increment) {
-        // Find player by ID
-        std::map<int32_t, std::wstring>::iterator itr = id_map.find(id);
-        if (itr == id_map.end()) {
-            return false;
-        }
-
-        auto player_name = (*itr).second;
+    bool update(const int32_t id, const int32_t increment, RankChange* change = NULL) {
+        uint32_t k = slotOf(id);
 
-        // Get player data
-        std::map<std::wstring, Player>::iterator itr1 = name_map.find(player_name);
-        if (itr1 == name_map.end()) {
-            remove((*itr1).second.id);  // Clean up inconsistent data
+        if (k == PLAYER_NONE) {
             return false;
         }
 
         // Calculate new score (minimum 0)
-        int score = itr1->second.score;
-        int new_score = (score + increment < 0) ? 0 : score + increment;
-        itr1->second.score = new_score;
-
-        // Update score_map: remove old entry and add new one
-        auto range = score_map.equal_range(score);
-        for (auto i = range.first; i != range.second; ++i) {
-            if (i->second == player_name) {
-                score_map.erase(i);
-                score_map.insert(std::pair<int32_t, std::wstring>(new_score, player_name));
-                return true;
-            }
-        }
-        return false;
+        int score = slots[k].score;
+        setScore(k, (score + increment < 0) ? 0 : score + increment, change);
+        return true;
     }
 
     /**
@@ -323,58 +784,167 @@ public:
      * @return true if update successful, false if player not found
      */
     bool update(const TCHAR* name, const int32_t increment) {
-        auto player_name = std::wstring(name);
+        uint32_t k = slotOf(name);
 
-        // Find player by name
-        std::map<std::wstring, Player>::iterator itr1 = name_map.find(player_name);
-        if (itr1 == name_map.end()) {
-            remove((*itr1).second.id);  // Clean up inconsistent data
+        if (k == PLAYER_NONE) {
             return false;
         }
 
         // Calculate new score (minimum 0)
-        int score = itr1->second.score;
-        int new_score = (score + increment < 0) ? 0 : score + increment;
-        itr1->second.score = new_score;
-
-        // Update score_map: remove old entry and add new one
-        auto range = score_map.equal_range(score);
-        for (auto i = range.first; i != range.second; ++i) {
-            if (i->second == player_name) {
-                score_map.erase(i);
-                score_map.insert(std::pair<int32_t, std::wstring>(new_score, player_name));
-                return true;
-            }
-        }
-        return false;
+        int score = slots[k].score;
+        setScore(k, (score + increment < 0) ? 0 : score + increment);
+        return true;
     }
 
-    int32_t score(int32_t gameId) {
+    /**
+     * Get player score by ID (lock free)
+     *
+     * @param gameId Player ID
+     * @return Score, -1 if player not found
+     */
+    int32_t score(int32_t gameId) const {
+        int32_t score;
+        LONG s;
 
-        std::map<int32_t, std::wstring>::iterator itr = id_map.find(gameId);
-        
-        if (itr != id_map.end()) {  // Found id in id_map
+        do {
+            s = readBegin();
+            uint32_t k = slotOf(gameId);
+            score = k == PLAYER_NONE ? -1 : slots[k].score;
+        } while (readRetry(s));
 
-            std::wstring& name = (itr)->second;
-            std::map<std::wstring, Player>::iterator itr2 = name_map.find(name);
+        return score;
+    }
 
-            if (itr2 != name_map.end()) {   // Found name in name_map
+    /**
+     * Get the leaderboard rank of a player (lock free)
+     *
+     * @param id Player ID
+     * @return Rank (1 = highest score), -1 if player not found
+     */
+    int32_t rank(int32_t id) const {
+        int32_t rank;
+        LONG s;
 
-                Player& p = itr2->second;
-                return p.score;
+        do {
+            s = readBegin();
+            uint32_t k = slotOf(id);
+            rank = k == PLAYER_NONE ? -1 : (int32_t)rankOf(k);
+        } while (readRetry(s));
 
+        return rank;
+    }
+
+    /**
+     * Get the rank, score and distance to the next rank of a player in one snapshot (lock free)
+     *
+     * @param id Player ID
+     * @param standing Receives the standing
+     * @return false if player not found
+     */
+    bool standing(int32_t id, PlayerStanding& standing) const {
+        bool found;
+        LONG s;
+
+        do {
+            s = readBegin();
+            uint32_t k = slotOf(id);
+
+            if ((found = k != PLAYER_NONE)) {
+                uint32_t rank = rankOf(k);
+                uint32_t ahead = rank > 1 ? rankSelect(rank - 1) : PLAYER_NONE;
+
+                standing.rank = (int32_t)rank;
+                standing.players = (int32_t)live.size();
+                standing.score = slots[k].score;
+                standing.next = ahead == PLAYER_NONE ? 0 : slots[ahead].score + 1 - slots[k].score;
             }
+        } while (readRetry(s));
+
+        return found;
+    }
 
+    /**
+     * Get the score a player needs to be at a given rank or better (writer side)
+     * Ties rank by the order of the last score change, so passing the player now at the
+     * rank takes one point more than their score
+     *
+     * @param id Player ID
+     * @param rank Rank to reach (1 = highest score)
+     * @return Score needed (the player's own if already there), -1 if player not found
+     */
+    int32_t scoreForRank(int32_t id, uint32_t rank) const {
+        uint32_t k = slotOf(id);
+
+        if (k == PLAYER_NONE) {
             return -1;
+        }
 
+        if (rank == 0 || rankOf(k) <= rank) {
+            return slots[k].score;
         }
 
-        // Player not found
-        return -1;
+        return slots[rankSelect(rank)].score + 1;
+    }
+
+    /**
+     * Visit the players with ranks in [first, last], highest score first (writer side)
+     * O(log n) to reach first, then O(1) per player
+     *
+     * @param first First rank (1 = highest score)
+     * @param last Last rank (inclusive, clamped to count())
+     * @param f Called as f(const Player&, rank)
+     */
+    template <typename F>
+    void ranked(uint32_t first, uint32_t last, F f) const {
+        rankWalk(root, 0, first < 1 ? 1 : first, last, f);
     }
 
     /**
-     * Generate leaderboard string
+     * Copy the top of the leaderboard (lock free)
+     *
+     * @param n Maximum number of players to copy (-1 for all players)
+     * @param top Receives the players, highest score first
+     */
+    void leaders(int32_t n, std::vector<LeaderboardEntry>& top) const {
+        std::vector<uint32_t> path;     // ancestors still to visit
+        LONG s;
+
+        do {
+            s = readBegin();
+            top.clear();
+            path.clear();
+
+            uint32_t t = root;
+            size_t steps = 0;
+
+            // In order walk (bounded: links may be torn while a change is made)
+            while ((n < 0 || top.size() < (size_t)n) && ++steps <= 2 * slots.size() + 1) {
+                if (t < slots.size()) {
+                    path.push_back(t);
+                    t = slots[t].left;
+                    continue;
+                }
+
+                if (path.empty()) {
+                    break;
+                }
+
+                t = path.back();
+                path.pop_back();
+
+                LeaderboardEntry e;
+                memcpy(e.name, slots[t].name, sizeof(e.name));
+                e.name[NAME_SIZE - 1] = TEXT('\0');
+                e.score = slots[t].score;
+                top.push_back(e);
+
+                t = slots[t].right;
+            }
+        } while (readRetry(s));
+    }
+
+    /**
+     * Generate leaderboard string (lock free)
      * Creates formatted string showing player names and scores in descending order
      *
      * @param n Maximum number of players to include (-1 for all players)
@@ -382,28 +952,17 @@ public:
      */
     std::wstring str(int32_t n = -1) const {
         std::wstringstream ss;
+        std::vector<LeaderboardEntry> top;
+
+        leaders(n, top);
 
-        // Iterate through score_map (already sorted by score descending)
-        for (auto& pr : score_map) {
-            if (n == 0) break;
-            ss << L"Nome: " << pr.second << L" Pontuao: " << pr.first << L"\n";
-            n -= 1;
+        for (const LeaderboardEntry& e : top) {
+            ss << L"Nome: " << e.name << L" Pontuao: " << e.score << L"\n";
         }
 
         return ss.str();
     }
 
-    /**
-     * Notify all connected clients of updates
-     * Triggers the update event for each player to refresh their game state
-     */
-    void updateAllClients() const {
-        for (auto& pr : name_map) {
-            const Player& p = pr.second;
-            SetEvent(p.update_handle);  // Signal client to refresh
-        }
-    }
-
     /**
      * Send logout notification to all clients
      * Broadcasts LOGOUT packet to inform all players to leave
@@ -416,153 +975,99 @@ public:
 
     /**
      * Send packet to all connected clients
-     * Establishes connection to each client's named pipe and sends the packet
+     * Written once to the shared event ring if there is one (same cost for any number of players),
+     * else one write per client on its long lived connection (see ClientConnection)
+     * Call with data_handle held: the ring has one writer
      *
      * @param p Packet to broadcast to all clients
      */
     void broadcast(Packet& p, int32_t except = -1) const {
-        bool res;  // Response from client
+        if (events != NULL) {
+            LONG64 n = events->head;
+            EventSlot& slot = events->slots[n % EVENT_RING_SIZE];
+
+            ResetEvent(event_signals[n & 1]);   // rearmed first: a reader that takes this event waits on it
+            InterlockedExchange64(&slot.sequence, 2 * n + 1);
+            slot.except = except == -1 ? 0 : except;
+            slot.packet = p;
+            InterlockedExchange64(&slot.sequence, 2 * n + 2);
+            InterlockedExchange64(&events->head, n + 1);
+
+            SetEvent(event_signals[(n + 1) & 1]);     // wake the readers
+            return;
+        }
 
-        for (auto& pr : this->name_map) {
+        for (uint32_t k : live) {
 
-            const Player& player = pr.second;
+            const Player& player = slots[k];
 
             if (except != -1 && player.id == except) {
                 continue;   // Exception, won't be notified
             }
 
 #ifdef DEBUG
-            std::wcout << L"Broadcasting to " << pr.first << L" at " << pr.second.pipe_name << L"\n";
+            std::wcout << L"Broadcasting to " << player.name << L" at " << player.pipe_name << L"\n";
 #endif
-            
-            // Connect to client's named pipe
-            HANDLE pipeHandle = CreateFile(
-                player.pipe_name,
-                GENERIC_READ | GENERIC_WRITE,
-                0,
-                NULL,
-                OPEN_EXISTING,
-                0,
-                NULL
-            );
-
-            if (pipeHandle == INVALID_HANDLE_VALUE) {
-#ifdef DEBUG
-                std::cout << __func__ << " ";
-                _tprintf(L"CreateFile %d\n", GetLastError());
-#endif
-                continue;  // Skip this client if connection fails
-            }
-
-            // Send packet and wait for acknowledgment
-            if (!WriteFile(pipeHandle, &p, sizeof(Packet), NULL, NULL)) {
-#ifdef DEBUG
-                std::cout << __func__ << " ";
-                _tprintf(L"WriteFile %d\n", GetLastError());
-#endif
-                continue;
-            }
-
-            if (!ReadFile(pipeHandle, &res, sizeof(bool), NULL, NULL)) {
-#ifdef DEBUG
-                std::cout << __func__ << " ";
-                _tprintf(L"ReadFile %d\n", GetLastError());
-#endif
-                continue;
-            }
 
-            CloseHandle(pipeHandle);
+            player.connection.send(player.pipe_name, &p);    // an unreachable client is skipped
         }
     }
 
     int32_t byName(const TCHAR* name) const {
-        if (name_map.find(name) != name_map.end()) {
-            // Player by name exists
-            return name_map.find(name)->second.id;
-        }
-
-        return -1;
+        uint32_t k = slotOf(name);
+        return k == PLAYER_NONE ? -1 : slots[k].id;
     }
 
-     
-    bool send(const int32_t id, const Packet& p) const {    
-        auto itr = id_map.find(id);
-
-        if (itr != id_map.end()) {
-            auto itr2 = name_map.find(itr->second);
-            
-            if (itr2 != name_map.end()) {
-
-                const Player& player = itr2->second;
-                bool res;
-
-                // Connect to client's named pipe
-                HANDLE pipeHandle = CreateFile(
-                    player.pipe_name,
-                    GENERIC_READ | GENERIC_WRITE,
-                    0,
-                    NULL,
-                    OPEN_EXISTING,
-                    0,
-                    NULL
-                );
-
-                if (pipeHandle == INVALID_HANDLE_VALUE) {
-#ifdef DEBUG
-                    std::cout << __func__ << " ";
-                    _tprintf(L"CreateFile %d\n", GetLastError());
-#endif
-                    CloseHandle(pipeHandle);
-                    return false;  // Skip this client if connection fails
-                }
-
-                // Send packet and wait for acknowledgment
-                if (!WriteFile(pipeHandle, &p, sizeof(Packet), NULL, NULL)) {
-#ifdef DEBUG
-                    std::cout << __func__ << " ";
-                    _tprintf(L"WriteFile %d\n", GetLastError());
-#endif
-
-                    CloseHandle(pipeHandle);
-                    return false;
-                }
-   
-                CloseHandle(pipeHandle);
-                return true;
-            }
 
+    /**
+     * Send packet to one client (through the broadcaster, or on its long lived connection)
+     *
+     * @param id Player ID
+     * @param p Packet to send
+     * @return false if the player does not exist or cannot be reached
+     */
+    bool send(const int32_t id, const Packet& p) const {
+        uint32_t k = slotOf(id);
 
+        if (k == PLAYER_NONE) {
             return false;
+        }
 
+        if (outbox != NULL) {
+            outbox->post(p, id);
+            return true;
         }
 
-        return false;
-    } 
+        return slots[k].connection.send(slots[k].pipe_name, &p);
+    }
 
 
     /**
-     * Get player name by ID
+     * Get player name by ID (lock free)
      * Safe lookup that handles invalid IDs gracefully
      *
      * @param id Player ID to look up
-     * @return Player name if found, NULL if ID doesn't exist
+     * @param name Receives the name (NAME_SIZE characters)
+     * @return true if found, false if ID doesn't exist
      */
-    const TCHAR* playerName(int32_t id) const {
-        auto itr = id_map.find(id);
-        
-        if (itr != id_map.end()) {
-            
-            auto itr1 = name_map.find(itr->second);
+    bool playerName(int32_t id, TCHAR* name) const {
+        bool found;
+        LONG s;
 
-            if (itr1 != name_map.end()) {
+        do {
+            s = readBegin();
+            uint32_t k = slotOf(id);
 
-                return itr1->second.pipe_name;
+            if ((found = k != PLAYER_NONE)) {
+                memcpy(name, slots[k].name, NAME_SIZE * sizeof(TCHAR));
             }
+        } while (readRetry(s));
 
-            return NULL;
+        if (found) {
+            name[NAME_SIZE - 1] = TEXT('\0');
         }
 
-        return NULL;
+        return found;
     }
 
     /**
@@ -571,10 +1076,10 @@ public:
      * @return Number of players currently in the game
      */
     int32_t count() const {
-        return this->name_map.size();
+        return (int32_t)live.size();
     }
 
 
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,177 @@
+#pragma once
+
+#ifndef _GUESSFILTER_H_
+#define _GUESSFILTER_H_
+
+#include "..\..\wordgame_common.h"
+#include "..\..\wordgame_dictionary.h"
+#include "GuessKernel.h"
+#include <cmath>
+#include <vector>
+
+/*
+    Guess filter: split block Bloom filter of the dictionary words
+    Most guesses are not words at all; the filter answers "surely not a word" from a single
+    32 byte block (half a cache line) without touching the index or the string pool.
+    Each key sets one bit in each of the 8 lanes of its block, so a lookup is one block load,
+    8 multiplies and one compare (a single AVX2 instruction each).
+    Built once from the dictionary and read-only afterwards, so lookups need no lock.
+*/
+
+#define GUESS_FILTER_LANES 8    // 32 bit lanes per block
+
+// Odd multipliers picking the bit of each lane
+const uint32_t GUESS_FILTER_SALTS[GUESS_FILTER_LANES] = {
+    0x47B6137Bu, 0x44974D91u, 0x8824AD5Bu, 0xA2B7289Du,
+    0x705495C7u, 0x2DF1424Bu, 0x9EFC4947u, 0x5C6BFB31u
+};
+
+/**
+ * Hash of a word for the filter
+ * A word of at most MAX_WORD_LENGTH letters packs into 60 bits (5 per letter, a = 1),
+ * so distinct words get distinct keys before mixing
+ *
+ * @param word Word of at most MAX_WORD_LENGTH letters (LETTER_NONE terminated)
+ * @return 64 bit hash
+ */
+inline uint64_t guessFilterHash(const Letter* word) {
+    static_assert(5 * MAX_WORD_LENGTH <= 64, "packed words must fit 64 bits");
+    uint64_t h = 0;
+
+    for (int i = 0; word[i] != LETTER_NONE; ++i) {
+        h = (h << 5) | (uint64_t)(word[i] + 1);
+    }
+
+    // 64 bit finalizer (MurmurHash3): every input bit reaches every output bit
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+#ifdef GUESS_KERNEL_X86
+
+/**
+ * AVX2 probe: all 8 lanes at once
+ */
+#if defined(__GNUC__) && !defined(__clang__)
+__attribute__((target("avx2")))
+#endif
+inline bool guessFilterProbeAVX2(const uint32_t* block, uint32_t key) {
+    __m256i salts = _mm256_loadu_si256((const __m256i*)GUESS_FILTER_SALTS);
+    __m256i shifts = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32((int)key), salts), 27);
+    __m256i mask = _mm256_sllv_epi32(_mm256_set1_epi32(1), shifts);
+
+    // every bit of mask set in the block
+    return _mm256_testc_si256(_mm256_loadu_si256((const __m256i*)block), mask) != 0;
+}
+
+#endif
+
+/**
+ * Split block Bloom filter of the dictionary
+ */
+class GuessFilter {
+    std::vector<uint32_t> bits;     // blocks of GUESS_FILTER_LANES lanes
+    uint64_t blocks;
+    double rate;                    // target false positive rate
+    bool avx2;
+
+    /**
+     * Expected false positive rate with a given average number of keys per block
+     * (keys per block are Poisson distributed; a key with i others in its block is
+     * a false positive if all 8 of its bits are taken)
+     */
+    static double expectedRate(double keysPerBlock) {
+        double p = exp(-keysPerBlock);
+        double sum = 0;
+
+        for (int i = 0; i < 4 * keysPerBlock + 64; ++i) {
+            sum += p * pow(1 - pow(1 - 1.0 / 32, i), GUESS_FILTER_LANES);
+            p *= keysPerBlock / (i + 1);
+        }
+
+        return sum;
+    }
+
+    const uint32_t* block(uint64_t h) const {
+        return bits.data() + ((h >> 32) * blocks >> 32) * GUESS_FILTER_LANES;
+    }
+
+public:
+    GuessFilter() : bits(GUESS_FILTER_LANES, 0), blocks(1), rate(1), avx2(false) {};
+
+    /**
+     * Build the filter for a dictionary
+     *
+     * @param d Dictionary image
+     * @param falsePositiveRate Target false positive rate (0 < rate < 1)
+     */
+    void build(const DictionaryHeader* d, double falsePositiveRate) {
+        rate = falsePositiveRate;
+        blocks = d->words / 32 + 1;
+
+        // smallest filter expected to meet the rate (grows about 3% a step)
+        while (expectedRate((double)d->words / blocks) > rate && blocks < UINT32_MAX / 2) {
+            blocks += blocks / 32 + 1;
+        }
+
+        bits.assign(blocks * GUESS_FILTER_LANES, 0);
+
+        for (uint32_t i = 0; i < d->words; ++i) {
+            uint64_t h = guessFilterHash(dictionaryWord(d, i));
+            uint32_t* b = (uint32_t*)block(h);
+
+            for (int l = 0; l < GUESS_FILTER_LANES; ++l) {
+                b[l] |= 1u << (((uint32_t)h * GUESS_FILTER_SALTS[l]) >> 27);
+            }
+        }
+
+#ifdef GUESS_KERNEL_X86
+        avx2 = cpuHasAVX2();
+#endif
+    }
+
+    /**
+     * Check if a word may be in the dictionary
+     *
+     * @param word Word of at most MAX_WORD_LENGTH letters (guess kernel output)
+     * @return false if the word is surely not in the dictionary
+     */
+    bool mayContain(const Letter* word) const {
+        uint64_t h = guessFilterHash(word);
+        const uint32_t* b = block(h);
+
+#ifdef GUESS_KERNEL_X86
+        if (avx2) {
+            return guessFilterProbeAVX2(b, (uint32_t)h);
+        }
+#endif
+
+        for (int l = 0; l < GUESS_FILTER_LANES; ++l) {
+            if ((b[l] & (1u << (((uint32_t)h * GUESS_FILTER_SALTS[l]) >> 27))) == 0) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * Get filter size in bytes
+     */
+    uint64_t size() const {
+        return bits.size() * sizeof(uint32_t);
+    }
+
+    /**
+     * Get the false positive rate the filter was sized for
+     */
+    double targetRate() const {
+        return rate;
+    }
+};
+
+#endif
@@ -0,0 +1,149 @@
+#pragma once
+
+#ifndef _GUESSKERNEL_H_
+#define _GUESSKERNEL_H_
+
+#include "..\..\wordgame_common.h"
+#include "WordIndex.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define GUESS_KERNEL_X86
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+/*
+    Guess validation kernels
+    Each kernel checks a guess received as letter codes (Packet::letters) and builds its letter
+    signature: a non-empty word of at most MAX_WORD_LENGTH letters, each one below LETTER_COUNT,
+    ended by LETTER_NONE. Only the first GUESS_KERNEL_WIDTH bytes are ever read: a guess with no
+    terminator in that window is longer than MAX_WORD_LENGTH, so it cannot be a word.
+    The window is a single 16 byte SSE2 register.
+*/
+
+#define GUESS_KERNEL_WIDTH GUESS_SIZE
+
+static_assert(MAX_WORD_LENGTH < GUESS_KERNEL_WIDTH, "a word and its terminator must fit the kernel window");
+static_assert(GUESS_KERNEL_WIDTH == 16, "the kernel window is one 16 byte register");
+
+/**
+ * Kernel signature
+ *
+ * @param guess Guess as received (possibly garbage, GUESS_KERNEL_WIDTH bytes readable)
+ * @param word Receives the LETTER_NONE terminated guess (GUESS_KERNEL_WIDTH bytes)
+ * @param sig Receives the letter signature of word
+ * @return true if the guess is a non-empty word of at most MAX_WORD_LENGTH letters
+ */
+typedef bool (*GuessKernel)(const Letter* guess, Letter* word, LetterSignature& sig);
+
+/**
+ * Count the letters of a validated guess
+ */
+inline void guessKernelCount(const Letter* letters, int len, LetterSignature& sig) {
+    memset(&sig, 0, sizeof(LetterSignature));
+
+    for (int i = 0; i < len; ++i) {
+        sig.counts[letters[i]] += 1;
+    }
+}
+
+/**
+ * Scalar kernel, used when no vector unit is available
+ */
+inline bool guessKernelScalar(const Letter* guess, Letter* word, LetterSignature& sig) {
+    for (int i = 0; i < GUESS_KERNEL_WIDTH; ++i) {
+        Letter c = guess[i];
+
+        if (c == LETTER_NONE) {
+            word[i] = LETTER_NONE;
+            guessKernelCount(word, i, sig);
+            return i > 0;
+        }
+
+        if (i >= MAX_WORD_LENGTH || c >= LETTER_COUNT) {
+            return false;                   // too long, or not a letter
+        }
+
+        word[i] = c;
+    }
+
+    return false;
+}
+
+#ifdef GUESS_KERNEL_X86
+
+/**
+ * SSE2 kernel: the whole window in one register
+ */
+inline bool guessKernelSSE2(const Letter* guess, Letter* word, LetterSignature& sig) {
+    const __m128i none = _mm_set1_epi8((char)LETTER_NONE);
+    const __m128i last = _mm_set1_epi8(LETTER_COUNT - 1);
+    unsigned long len;
+
+    __m128i c = _mm_loadu_si128((const __m128i*)guess);
+
+    // Length: first terminator in the window
+    uint32_t terminators = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(c, none));
+
+    if (!_BitScanForward(&len, terminators) || len == 0 || len > MAX_WORD_LENGTH) {
+        return false;
+    }
+
+    // Every byte before the terminator must be a letter code (unsigned c <= 25)
+    uint32_t letters = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(c, last), c));
+    uint32_t wanted = (1u << len) - 1;
+
+    if ((letters & wanted) != wanted) {
+        return false;
+    }
+
+    _mm_storeu_si128((__m128i*)word, c);
+    word[len] = LETTER_NONE;
+
+    guessKernelCount(word, len, sig);
+    return true;
+}
+
+/**
+ * Check if the CPU and the OS both support AVX2 (YMM state saved on context switch)
+ */
+inline bool cpuHasAVX2() {
+    int info[4];
+
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+
+    __cpuid(info, 1);
+    if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0) {
+        return false;   // no OSXSAVE or no AVX
+    }
+
+    if ((_xgetbv(0) & 0x6) != 0x6) {
+        return false;   // OS does not save XMM/YMM state
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+}
+
+#endif
+
+/**
+ * Pick the fastest kernel the machine supports
+ *
+ * @param name Receives the kernel name, for logging
+ * @return Kernel to use
+ */
+inline GuessKernel selectGuessKernel(const TCHAR** name) {
+#ifdef GUESS_KERNEL_X86
+    *name = TEXT("SSE2");   // always present on x64
+    return guessKernelSSE2;
+#else
+    *name = TEXT("scalar");
+    return guessKernelScalar;
+#endif
+}
+
+#endif
@@ -0,0 +1,94 @@
+#pragma once
+
+#ifndef _LEADERBOARDSNAPSHOT_H_
+#define _LEADERBOARDSNAPSHOT_H_
+
+#include "..\..\wordgame_common.h"
+#include "GameData.h"
+#include "Epoch.h"
+
+/**
+ * Formatted leaderboard at one version of GameData
+ */
+struct LeaderboardSnapshot {
+    uint32_t version;           // GameData::version() + 1 when it was taken (0 = none)
+    std::wstring text;          // GameData::str() at that version
+};
+
+/**
+ * Leaderboard kept formatted for LIST and "listar"
+ * Whoever changes players or scores calls refresh() after releasing data_handle; it formats
+ * a new snapshot only if the version moved, so readers just copy the latest one.
+ * Snapshots are swapped by pointer and freed once no reader can hold them (epochs).
+ */
+class LeaderboardCache {
+    LeaderboardSnapshot* volatile current;
+    volatile LONG building;             // a thread is formatting a snapshot
+    const GameData& data;
+    EpochDomain& epochs;
+
+public:
+    LeaderboardCache(const GameData& data, EpochDomain& epochs) : current(NULL), building(0), data(data), epochs(epochs) {};
+
+    ~LeaderboardCache() {
+        delete current;
+    }
+
+    /**
+     * Format a new snapshot if the leaderboard changed since the last one
+     * Concurrent calls are coalesced: a caller finding another one formatting returns,
+     * and that one checks the version again before it stops
+     */
+    void refresh() {
+        while (InterlockedCompareExchange(&building, 1, 0) == 0) {
+            uint32_t version = data.version() + 1;
+            LeaderboardSnapshot* old = current;
+
+            if (old != NULL && old->version == version) {
+                InterlockedExchange(&building, 0);
+
+                // A change made after the check was left to us by its caller
+                if (data.version() + 1 == version) {
+                    return;
+                }
+
+                continue;
+            }
+
+            LeaderboardSnapshot* next = new LeaderboardSnapshot;
+            next->version = version;
+            next->text = data.str();     // read after the version: at least as recent
+
+            InterlockedExchangePointer((PVOID volatile*)&current, next);
+            InterlockedExchange(&building, 0);
+
+            epochs.synchronize();   // readers that loaded the old snapshot are done
+            delete old;
+        }
+    }
+
+    /**
+     * Copy the latest snapshot (lock free, no formatting)
+     *
+     * @param reader Epoch slot of the calling thread
+     * @param known Version the caller already has (0 if none)
+     * @param out Receives the snapshot, only if its version is not known
+     * @return true if copied, false if the caller is up to date (or there is no snapshot)
+     */
+    bool copy(int reader, uint32_t known, LeaderboardSnapshot& out) {
+        bool copied = false;
+
+        epochs.enter(reader);
+        const LeaderboardSnapshot* s = current;
+
+        if (s != NULL && s->version != known) {
+            out = *s;
+            copied = true;
+        }
+
+        epochs.leave(reader);
+        return copied;
+    }
+};
+
+#endif
@@ -0,0 +1,369 @@
+#pragma once
+
+#ifndef _PROFILESTORE_H_
+#define _PROFILESTORE_H_
+
+#include "..\..\wordgame_common.h"
+#include "GameData.h"
+#include <vector>
+
+/*
+    Profile store: lifetime stats of every player name ever seen, in a memory mapped file.
+    Profiles live in fixed size buckets indexed by extendible hashing: an in-memory directory
+    maps the low bits of a name's hash to its bucket, and a full bucket is split in two
+    (doubling the directory only when its depth runs out), so a lookup is one directory
+    access plus one bucket, and growing never rehashes the whole store.
+    Each bucket keeps the hashes of its profiles together, so a lookup scans one small array
+    and touches a single profile. Only bucket headers are read at startup (to rebuild the
+    directory); profiles are paged in when their players log in, and changes are written
+    back by the system as the mapped pages are flushed.
+    Not thread safe: used with data_handle held.
+*/
+
+#define PROFILE_MAGIC 0x464F5250u           // "PROF"
+#define PROFILE_VERSION 1
+#define PROFILE_BUCKET_SLOTS 64             // profiles per bucket
+#define PROFILE_MAX_DEPTH 24                // directory of at most 2^24 buckets
+#define PROFILE_GROW_MIN 64                 // buckets the file grows by, at least
+#define PROFILE_GROW_MAX 4096               // and at most (the file doubles in between)
+
+/**
+ * Lifetime stats of a player name
+ */
+struct PlayerProfile {
+    TCHAR name[NAME_SIZE];      // Player name
+    int64_t total_score;        // Points earned over all sessions
+    uint32_t words;             // Words guessed
+    uint32_t sessions;          // Logins
+    uint32_t best_streak;       // Most words guessed in a row (nobody else scoring in between)
+    uint32_t reserved;
+};
+
+/**
+ * Bucket of profiles sharing the low 'depth' bits of their hash
+ */
+struct ProfileBucket {
+    uint32_t depth;                             // Local depth
+    uint32_t prefix;                            // The low 'depth' bits shared by its profiles
+    uint32_t count;                             // Profiles in use
+    uint32_t reserved;
+    uint32_t hashes[PROFILE_BUCKET_SLOTS];      // profileHash of each profile
+    PlayerProfile profiles[PROFILE_BUCKET_SLOTS];
+};
+
+struct ProfileStoreHeader {
+    uint32_t magic;             // PROFILE_MAGIC
+    uint32_t version;           // PROFILE_VERSION
+    uint32_t buckets;           // Buckets in use (the file may hold more)
+    uint32_t reserved;
+    uint64_t count;             // Profiles stored
+};
+
+/**
+ * Hash of a name for the store (player name hash, mixed so the low bits are usable)
+ */
+inline uint32_t profileHash(const TCHAR* name) {
+    uint32_t h = playerNameHash(name);
+
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    return h;
+}
+
+/**
+ * Memory mapped store of player profiles
+ */
+class ProfileStore {
+    HANDLE file;
+    HANDLE mapping;
+    ProfileStoreHeader* header;         // start of the mapped file
+    uint32_t allocated;                 // buckets the file has room for
+    uint32_t depth;                     // global depth
+    std::vector<uint32_t> directory;    // low 'depth' hash bits -> bucket
+
+    ProfileBucket* bucket(uint32_t b) const {
+        return (ProfileBucket*)(header + 1) + b;
+    }
+
+    static uint64_t fileSize(uint32_t buckets) {
+        return sizeof(ProfileStoreHeader) + (uint64_t)buckets * sizeof(ProfileBucket);
+    }
+
+    /**
+     * Map the file with room for a number of buckets (the file grows to fit)
+     */
+    bool map(uint32_t buckets) {
+        uint64_t size = fileSize(buckets);
+
+        if (header != NULL) {
+            FlushViewOfFile(header, 0);
+            UnmapViewOfFile(header);
+            CloseHandle(mapping);
+            header = NULL;
+        }
+
+        mapping = CreateFileMapping(file, NULL, PAGE_READWRITE, (DWORD)(size >> 32), (DWORD)size, NULL);
+
+        if (mapping == NULL) {
+            std::cout << "CreateFileMapping " << GetLastError() << std::endl;
+            return false;
+        }
+
+        header = (ProfileStoreHeader*)MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, (SIZE_T)size);
+
+        if (header == NULL) {
+            std::cout << "MapViewOfFile " << GetLastError() << std::endl;
+            CloseHandle(mapping);
+            mapping = NULL;
+            return false;
+        }
+
+        allocated = buckets;
+        return true;
+    }
+
+    /**
+     * Take a new bucket, growing the file if needed (remaps: profile pointers become invalid)
+     *
+     * @return Bucket number, UINT32_MAX if the file cannot grow
+     */
+    uint32_t newBucket() {
+        if (header->buckets == allocated) {
+            uint32_t grow = allocated < PROFILE_GROW_MIN ? PROFILE_GROW_MIN : (allocated > PROFILE_GROW_MAX ? PROFILE_GROW_MAX : allocated);
+
+            if (!map(allocated + grow)) {
+                map(allocated);     // keep the current size
+                return UINT32_MAX;
+            }
+        }
+
+        ProfileBucket* b = bucket(header->buckets);
+        memset(b, 0, sizeof(ProfileBucket));
+        return header->buckets++;
+    }
+
+    /**
+     * Point every directory entry whose low bits match a bucket's prefix at it
+     */
+    void route(uint32_t b) {
+        const ProfileBucket* p = bucket(b);
+
+        for (uint32_t i = p->prefix; i < directory.size(); i += 1u << p->depth) {
+            directory[i] = b;
+        }
+    }
+
+    /**
+     * Split a full bucket on its next hash bit
+     *
+     * @return false if the bucket cannot be split (store full, or too many equal hashes)
+     */
+    bool split(uint32_t b) {
+        if (bucket(b)->depth >= PROFILE_MAX_DEPTH) {
+            return false;
+        }
+
+        uint32_t n = newBucket();
+
+        if (n == UINT32_MAX) {
+            return false;
+        }
+
+        ProfileBucket* old = bucket(b);     // after newBucket: the file may have moved
+        ProfileBucket* sibling = bucket(n);
+        uint32_t bit = 1u << old->depth;
+        uint32_t kept = 0;
+
+        // Double the directory if the bucket already uses all its bits
+        if (old->depth == depth) {
+            directory.resize(directory.size() * 2);
+            std::copy(directory.begin(), directory.begin() + directory.size() / 2, directory.begin() + directory.size() / 2);
+            ++depth;
+        }
+
+        sibling->depth = old->depth + 1;
+        sibling->prefix = old->prefix | bit;
+        old->depth += 1;
+
+        for (uint32_t i = 0; i < old->count; ++i) {
+            if (old->hashes[i] & bit) {
+                sibling->hashes[sibling->count] = old->hashes[i];
+                sibling->profiles[sibling->count++] = old->profiles[i];
+            }
+            else {
+                old->hashes[kept] = old->hashes[i];
+                old->profiles[kept++] = old->profiles[i];
+            }
+        }
+
+        old->count = kept;
+        route(n);
+        return true;
+    }
+
+public:
+    ProfileStore() : file(INVALID_HANDLE_VALUE), mapping(NULL), header(NULL), allocated(0), depth(0) {};
+
+    ~ProfileStore() {
+        close();
+    }
+
+    /**
+     * Open the store (created empty if missing) and rebuild the directory from the bucket headers
+     *
+     * @param path Store file
+     * @return true on success, false otherwise
+     */
+    bool open(const TCHAR* path) {
+        LARGE_INTEGER size = { 0 };
+
+        file = CreateFile(path, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+
+        if (file == INVALID_HANDLE_VALUE) {
+            _tprintf(_T("CreateFile %d\n"), GetLastError());
+            return false;
+        }
+
+        GetFileSizeEx(file, &size);
+
+        if ((uint64_t)size.QuadPart < fileSize(1)) {
+            // New store: one empty bucket of depth 0
+            if (!map(PROFILE_GROW_MIN)) {
+                return false;
+            }
+
+            memset(header, 0, (size_t)fileSize(1));
+            header->magic = PROFILE_MAGIC;
+            header->version = PROFILE_VERSION;
+            header->buckets = 1;
+        }
+        else if (!map((uint32_t)((size.QuadPart - sizeof(ProfileStoreHeader)) / sizeof(ProfileBucket)))) {
+            return false;
+        }
+
+        if (header->magic != PROFILE_MAGIC || header->version != PROFILE_VERSION || header->buckets == 0 || header->buckets > allocated) {
+            _tprintf(_T("Profile store '%s' has an unknown format\n"), path);
+            close();
+            return false;
+        }
+
+        for (uint32_t b = 0; b < header->buckets; ++b) {
+            const ProfileBucket* p = bucket(b);
+
+            // The directory is rebuilt from these: a bucket out of range would route outside it
+            if (p->depth > PROFILE_MAX_DEPTH || p->count > PROFILE_BUCKET_SLOTS || p->prefix >= 1u << p->depth) {
+                _tprintf(_T("Profile store '%s' has an invalid bucket %u\n"), path, b);
+                close();
+                return false;
+            }
+
+            depth = p->depth > depth ? p->depth : depth;
+        }
+
+        directory.assign((size_t)1 << depth, 0);
+
+        for (uint32_t b = 0; b < header->buckets; ++b) {
+            route(b);
+        }
+
+        _tprintf(_T("Profiles: %llu in %u buckets\n"), header->count, header->buckets);
+        return true;
+    }
+
+    /**
+     * Flush and unmap the store
+     */
+    void close() {
+        if (header != NULL) {
+            FlushViewOfFile(header, 0);
+            UnmapViewOfFile(header);
+            header = NULL;
+        }
+
+        if (mapping != NULL) {
+            CloseHandle(mapping);
+            mapping = NULL;
+        }
+
+        if (file != INVALID_HANDLE_VALUE) {
+            FlushFileBuffers(file);
+            CloseHandle(file);
+            file = INVALID_HANDLE_VALUE;
+        }
+    }
+
+    /**
+     * Check if the store is open
+     */
+    bool isOpen() const {
+        return header != NULL;
+    }
+
+    /**
+     * Find the profile of a name
+     *
+     * @param name Player name (at most NAME_SIZE - 1 characters)
+     * @return Profile (valid until the next create), NULL if the name has none
+     */
+    PlayerProfile* find(const TCHAR* name) const {
+        if (header == NULL) {
+            return NULL;
+        }
+
+        uint32_t h = profileHash(name);
+        ProfileBucket* b = bucket(directory[h & ((1u << depth) - 1)]);
+
+        for (uint32_t i = 0; i < b->count; ++i) {
+            if (b->hashes[i] == h && _tcsncmp(b->profiles[i].name, name, NAME_SIZE) == 0) {
+                return &b->profiles[i];
+            }
+        }
+
+        return NULL;
+    }
+
+    /**
+     * Find the profile of a name, adding an empty one if it has none
+     *
+     * @param name Player name (at most NAME_SIZE - 1 characters)
+     * @return Profile (valid until the next create), NULL if the store is full or closed
+     */
+    PlayerProfile* create(const TCHAR* name) {
+        PlayerProfile* p = find(name);
+
+        if (p != NULL || header == NULL) {
+            return p;
+        }
+
+        uint32_t h = profileHash(name);
+        uint32_t b = directory[h & ((1u << depth) - 1)];
+
+        while (bucket(b)->count == PROFILE_BUCKET_SLOTS) {
+            if (!split(b)) {
+                return NULL;
+            }
+
+            b = directory[h & ((1u << depth) - 1)];
+        }
+
+        ProfileBucket* target = bucket(b);
+        p = &target->profiles[target->count];
+        memset(p, 0, sizeof(PlayerProfile));
+        _tcsncpy_s(p->name, name, _TRUNCATE);
+        target->hashes[target->count++] = h;
+        header->count += 1;
+        return p;
+    }
+
+    /**
+     * Get the number of profiles stored
+     */
+    uint64_t count() const {
+        return header == NULL ? 0 : header->count;
+    }
+};
+
+#endif
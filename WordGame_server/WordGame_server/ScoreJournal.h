@@ -0,0 +1,659 @@
+#pragma once
+
+#ifndef _SCOREJOURNAL_H_
+#define _SCOREJOURNAL_H_
+
+#include "..\..\wordgame_common.h"
+#include <vector>
+#include <map>
+#include <string>
+#include <functional>
+
+/*
+    Score journal: every insert, score change and removal of GameData is appended as a fixed
+    size record. Appends only queue the record in memory; a writer thread commits the queue
+    every JOURNAL_COMMIT_MS with one write and one flush (group commit), so a guess never
+    waits on the disk. Every JOURNAL_SNAPSHOT_RECORDS records the writer starts a new journal
+    segment and writes a snapshot of all scores, after which the previous segment is deleted;
+    recovery loads the snapshot and replays only the records after it.
+    A failed write is retried every period with the records queued since: they are only
+    counted as written once a write and its flush succeed, and no segment is rotated away
+    before then. If the journal cannot go on (no segment to write to), it stops and says so.
+
+    Files (path = journal):
+        path            current segment (JournalHeader + records)
+        path.old        previous segment, only until the snapshot covering it is written
+        path.snap       snapshot (SnapshotHeader + one JOURNAL_INSERT record per player)
+
+    Records carry absolute scores and are keyed by name (IDs do not survive a restart), so
+    replaying a record twice is harmless. After a restart the recovered scores wait for their
+    players: a player logging in with a recovered name gets its score back. A score waits for
+    at most JOURNAL_RECOVERED_RESTARTS restarts: snapshots carry the restarts it has waited
+    (in the type of its record, above JOURNAL_TYPE_BITS), and it is dropped at the restart
+    after the last one.
+*/
+
+#define JOURNAL_MAGIC 0x4C4E524Au           // "JRNL"
+#define SNAPSHOT_MAGIC 0x50414E53u          // "SNAP"
+#define JOURNAL_VERSION 1
+#define JOURNAL_COMMIT_MS 10                // group commit period
+#define JOURNAL_COMMIT_RECORDS 4096         // queued records that wake the writer early
+#define JOURNAL_SNAPSHOT_RECORDS (1 << 16)  // records between snapshots
+#define JOURNAL_RECOVERED_RESTARTS 10       // restarts a recovered score waits for its player
+#define JOURNAL_TYPE_BITS 16                // type bits of a record; above them, restarts waited
+
+enum JournalRecordType {
+    JOURNAL_INSERT = 1,     // player joined with a score
+    JOURNAL_UPDATE,         // player score changed
+    JOURNAL_REMOVE          // player left
+};
+
+struct JournalRecord {
+    uint32_t check;             // journalCheck of the rest of the record (a torn write fails it)
+    uint32_t type;              // JournalRecordType (snapshots: | restarts waited << JOURNAL_TYPE_BITS)
+    int32_t score;              // Score after the change
+    TCHAR name[NAME_SIZE];      // Player name
+};
+
+struct JournalHeader {
+    uint32_t magic;             // JOURNAL_MAGIC
+    uint32_t version;           // JOURNAL_VERSION
+    uint64_t base;              // Sequence number of the first record
+};
+
+struct SnapshotHeader {
+    uint32_t magic;             // SNAPSHOT_MAGIC
+    uint32_t version;           // JOURNAL_VERSION
+    uint64_t sequence;          // Every record before this one is reflected
+    uint64_t count;             // Records that follow
+};
+
+/**
+ * Checksum of a record (FNV-1a of everything after the check field)
+ */
+inline uint32_t journalCheck(const JournalRecord& r) {
+    const uint8_t* p = (const uint8_t*)&r + sizeof(r.check);
+    uint32_t h = 2166136261u;
+
+    for (size_t i = sizeof(r.check); i < sizeof(JournalRecord); ++i, ++p) {
+        h = (h ^ *p) * 16777619u;
+    }
+
+    return h;
+}
+
+/**
+ * Fill a record
+ */
+inline void journalRecord(JournalRecord& r, uint32_t type, const TCHAR* name, int32_t score) {
+    memset(&r, 0, sizeof(JournalRecord));
+    r.type = type;
+    r.score = score;
+    _tcsncpy_s(r.name, name, _TRUNCATE);
+    r.check = journalCheck(r);
+}
+
+/**
+ * Read a whole file
+ *
+ * @return false if the file does not exist or cannot be read
+ */
+inline bool journalReadFile(const TCHAR* path, std::vector<uint8_t>& bytes) {
+    LARGE_INTEGER size;
+    DWORD read = 0;
+    HANDLE file = CreateFile(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    if (!GetFileSizeEx(file, &size) || size.QuadPart > UINT32_MAX) {
+        CloseHandle(file);
+        return false;
+    }
+
+    bytes.resize((size_t)size.QuadPart);
+
+    if (!bytes.empty() && (!ReadFile(file, bytes.data(), (DWORD)bytes.size(), &read, NULL) || read != bytes.size())) {
+        CloseHandle(file);
+        return false;
+    }
+
+    CloseHandle(file);
+    return true;
+}
+
+/**
+ * Score of a previous run waiting for its player
+ */
+struct RecoveredScore {
+    int32_t score;
+    uint32_t restarts;          // restarts it has waited for its player
+};
+
+/**
+ * Crash safe journal of the player scores
+ */
+class ScoreJournal {
+public:
+    /**
+     * Copies the scores of every player into records, returns the sequence they reflect
+     * (called by the writer thread when it takes a snapshot)
+     */
+    typedef std::function<uint64_t(std::vector<JournalRecord>&)> Capture;
+
+private:
+    std::wstring path, old_path, snapshot_path, temp_path;
+    HANDLE file;                            // current segment
+    HANDLE thread;                          // writer
+    HANDLE wake;                            // commit now (auto reset)
+    volatile LONG stopping;
+    CRITICAL_SECTION lock;                  // pending, appended, recovered
+    std::vector<JournalRecord> pending;     // appended, not yet written
+    std::vector<JournalRecord> writing;     // being written by the writer (kept until written)
+    volatile LONG64 appended;               // sequence number of the next record
+    uint64_t written;                       // sequence number after the last written record
+    uint64_t snapshot_at;                   // sequence of the last snapshot
+    uint64_t segment_end;                   // bytes of the current segment holding written records
+    bool failing;                           // the last commit failed: writing is retried
+    bool rotated;                           // path.old waits for the snapshot covering it
+    volatile LONG stopped;                  // journaling given up, appends are dropped
+    std::map<std::wstring, RecoveredScore> recovered;  // scores waiting for their players
+    Capture capture;
+
+    volatile LONG64 commits;                // writes + flushes done
+    volatile LONG64 snapshots;              // snapshots written
+
+    /**
+     * Replay one segment on top of a state
+     *
+     * @param at Receives the sequence after the last valid record (if later)
+     * @return Records replayed
+     */
+    static uint64_t replay(const TCHAR* file_path, uint64_t from, std::map<std::wstring, RecoveredScore>& state, uint64_t& at) {
+        std::vector<uint8_t> bytes;
+        uint64_t replayed = 0;
+
+        if (!journalReadFile(file_path, bytes) || bytes.size() < sizeof(JournalHeader)) {
+            return 0;
+        }
+
+        const JournalHeader* h = (const JournalHeader*)bytes.data();
+
+        if (h->magic != JOURNAL_MAGIC || h->version != JOURNAL_VERSION) {
+            _tprintf(_T("Journal '%s' has an unknown format, ignored\n"), file_path);
+            return 0;
+        }
+
+        const JournalRecord* r = (const JournalRecord*)(bytes.data() + sizeof(JournalHeader));
+        size_t count = (bytes.size() - sizeof(JournalHeader)) / sizeof(JournalRecord);
+
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t sequence = h->base + i;
+
+            if (r[i].check != journalCheck(r[i])) {
+                _tprintf(_T("Journal '%s' ends with a torn record at %llu\n"), file_path, sequence);
+                break;  // anything after a torn write was never committed
+            }
+
+            if (sequence >= from) {
+                std::wstring name(r[i].name, _tcsnlen(r[i].name, NAME_SIZE));
+
+                if (r[i].type == JOURNAL_REMOVE) {
+                    state.erase(name);
+                }
+                else {
+                    state[name] = { r[i].score, 0 };    // its player was connected
+                }
+
+                ++replayed;
+            }
+
+            if (sequence + 1 > at) {
+                at = sequence + 1;
+            }
+        }
+
+        return replayed;
+    }
+
+    /**
+     * Create a segment whose first record has a given sequence number
+     */
+    bool createSegment(uint64_t base) {
+        JournalHeader h = { JOURNAL_MAGIC, JOURNAL_VERSION, base };
+        DWORD done = 0;
+
+        // shared for delete, so the segment can be renamed to path.old while still open
+        file = CreateFile(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+
+        if (file == INVALID_HANDLE_VALUE) {
+            _tprintf(_T("CreateFile %d\n"), GetLastError());
+            return false;
+        }
+
+        if (!WriteFile(file, &h, sizeof(h), &done, NULL) || done != sizeof(h) || !FlushFileBuffers(file)) {
+            _tprintf(_T("WriteFile %d\n"), GetLastError());
+            CloseHandle(file);
+            file = INVALID_HANDLE_VALUE;
+            return false;
+        }
+
+        segment_end = sizeof(h);
+        return true;
+    }
+
+    /**
+     * Go back to the segment just renamed to path.old after its successor could not be created
+     *
+     * @return false if there is no segment to write to any more
+     */
+    bool restoreSegment() {
+        LARGE_INTEGER size;
+
+        if (!MoveFileEx(old_path.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+            return false;
+        }
+
+        file = CreateFile(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+        if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &size) || !SetFilePointerEx(file, size, NULL, FILE_BEGIN)) {
+            return false;
+        }
+
+        segment_end = (uint64_t)size.QuadPart;
+        return true;
+    }
+
+    /**
+     * Give up journaling: nothing can be written any more
+     */
+    void stop(const TCHAR* why) {
+        _tprintf(_T("Journal stopped (%s, error %d): scores are no longer journaled\n"), why, GetLastError());
+
+        if (file != INVALID_HANDLE_VALUE) {
+            CloseHandle(file);
+            file = INVALID_HANDLE_VALUE;
+        }
+
+        EnterCriticalSection(&lock);
+        pending.clear();
+        InterlockedExchange(&stopped, 1);
+        LeaveCriticalSection(&lock);
+
+        writing.clear();
+    }
+
+    /**
+     * Write a snapshot (to a temporary file, then moved over the previous one)
+     */
+    bool writeSnapshot(uint64_t sequence, const std::vector<JournalRecord>& records) {
+        SnapshotHeader h = { SNAPSHOT_MAGIC, JOURNAL_VERSION, sequence, records.size() };
+        DWORD done = 0;
+        DWORD size = (DWORD)(records.size() * sizeof(JournalRecord));
+        HANDLE f = CreateFile(temp_path.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+
+        if (f == INVALID_HANDLE_VALUE) {
+            _tprintf(_T("CreateFile %d\n"), GetLastError());
+            return false;
+        }
+
+        bool ok = WriteFile(f, &h, sizeof(h), &done, NULL) && done == sizeof(h) &&
+                  (size == 0 || (WriteFile(f, records.data(), size, &done, NULL) && done == size)) &&
+                  FlushFileBuffers(f);
+
+        CloseHandle(f);
+
+        if (!ok || !MoveFileEx(temp_path.c_str(), snapshot_path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+            _tprintf(_T("Snapshot %d\n"), GetLastError());
+            return false;
+        }
+
+        snapshot_at = sequence;
+        InterlockedIncrement64(&snapshots);
+        return true;
+    }
+
+    /**
+     * Write the queued records with one write and one flush
+     * On failure the records stay in writing and are written again, with those queued
+     * since, from the same place in the segment on the next commit
+     *
+     * @return true if every record appended so far is written
+     */
+    bool commit() {
+        size_t from = writing.size();   // records before this one are checksummed already
+
+        EnterCriticalSection(&lock);
+
+        if (writing.empty()) {
+            writing.swap(pending);
+        }
+        else {
+            writing.insert(writing.end(), pending.begin(), pending.end());
+            pending.clear();
+        }
+
+        LeaveCriticalSection(&lock);
+
+        if (writing.empty()) {
+            return true;
+        }
+
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+
+        DWORD done = 0;
+        DWORD size = (DWORD)(writing.size() * sizeof(JournalRecord));
+        LARGE_INTEGER end;
+
+        // Checksums here, off the path of the appending thread
+        for (size_t i = from; i < writing.size(); ++i) {
+            writing[i].check = journalCheck(writing[i]);
+        }
+
+        // A failed write may have written part of the records: write them over it
+        end.QuadPart = (LONGLONG)segment_end;
+
+        if ((failing && !SetFilePointerEx(file, end, NULL, FILE_BEGIN)) ||
+            !WriteFile(file, writing.data(), size, &done, NULL) || done != size || !FlushFileBuffers(file)) {
+            if (!failing) {
+                _tprintf(_T("Journal WriteFile %d: %u records kept, retried every %d ms\n"), GetLastError(),
+                    (uint32_t)writing.size(), JOURNAL_COMMIT_MS);
+            }
+
+            failing = true;
+            return false;
+        }
+
+        if (failing) {
+            _tprintf(_T("Journal written again (%u records)\n"), (uint32_t)writing.size());
+        }
+
+        failing = false;
+        segment_end += size;
+        written += writing.size();
+        writing.clear();
+        InterlockedIncrement64(&commits);
+        return true;
+    }
+
+    /**
+     * Start a new segment and snapshot the scores, then drop the old segment
+     * (the new segment exists before the snapshot is taken, so together they cover everything)
+     */
+    void compact() {
+        std::vector<JournalRecord> records;
+
+        if (!commit()) {
+            return;     // the segment must hold every record before it is rotated
+        }
+
+        // path.old is only replaced once a snapshot covers it; until then the snapshot is retried
+        if (!rotated) {
+            if (!MoveFileEx(path.c_str(), old_path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+                _tprintf(_T("Journal rotation failed %d\n"), GetLastError());
+                return;     // keep appending to the current segment
+            }
+
+            CloseHandle(file);
+            file = INVALID_HANDLE_VALUE;
+
+            if (!createSegment(written)) {
+                if (!restoreSegment()) {
+                    stop(_T("no segment to write to"));
+                }
+
+                return;     // keep appending to the current segment
+            }
+
+            rotated = true;
+        }
+
+        uint64_t sequence = capture(records);
+
+        // Recovered scores still waiting for their players are kept
+        EnterCriticalSection(&lock);
+
+        for (auto& s : recovered) {
+            JournalRecord r;
+            journalRecord(r, JOURNAL_INSERT | (s.second.restarts << JOURNAL_TYPE_BITS), s.first.c_str(), s.second.score);
+            records.push_back(r);
+        }
+
+        LeaveCriticalSection(&lock);
+
+        if (writeSnapshot(sequence, records)) {
+            DeleteFile(old_path.c_str());
+            rotated = false;
+        }
+    }
+
+    /**
+     * Writer thread: group commits, and a snapshot every JOURNAL_SNAPSHOT_RECORDS
+     */
+    static void* writer(void* param) {
+        ScoreJournal* j = (ScoreJournal*)param;
+
+        while (!j->stopping && !j->stopped) {
+            WaitForSingleObject(j->wake, JOURNAL_COMMIT_MS);
+            j->commit();
+
+            if (j->written - j->snapshot_at >= JOURNAL_SNAPSHOT_RECORDS) {
+                j->compact();
+            }
+        }
+
+        if (!j->stopped && !j->commit()) {
+            _tprintf(_T("Journal: %u records could not be written\n"), (uint32_t)j->writing.size());
+        }
+
+        return NULL;
+    }
+
+public:
+    ScoreJournal() : file(INVALID_HANDLE_VALUE), thread(NULL), wake(NULL), stopping(0),
+        appended(0), written(0), snapshot_at(0), segment_end(0), failing(false), rotated(false), stopped(0),
+        commits(0), snapshots(0) {
+        InitializeCriticalSection(&lock);
+    };
+
+    ~ScoreJournal() {
+        close();
+        DeleteCriticalSection(&lock);
+    }
+
+    /**
+     * Recover the scores of a previous run and start journaling
+     * The recovered state is written as a fresh snapshot before the old segments are deleted
+     *
+     * @param journal_path Journal file
+     * @param snapshot_capture Source of the scores for snapshots
+     * @return true if journaling started
+     */
+    bool open(const TCHAR* journal_path, Capture snapshot_capture) {
+        LARGE_INTEGER start, end, frequency;
+        std::vector<uint8_t> bytes;
+        uint64_t from = 0, at = 0, loaded = 0, replayed = 0, expired = 0;
+
+        QueryPerformanceCounter(&start);
+        path = journal_path;
+        old_path = path + L".old";
+        snapshot_path = path + L".snap";
+        temp_path = path + L".snap.tmp";
+        capture = snapshot_capture;
+
+        // Snapshot first, then the records after it (old segment first)
+        if (journalReadFile(snapshot_path.c_str(), bytes) && bytes.size() >= sizeof(SnapshotHeader)) {
+            const SnapshotHeader* h = (const SnapshotHeader*)bytes.data();
+            const JournalRecord* r = (const JournalRecord*)(bytes.data() + sizeof(SnapshotHeader));
+
+            if (h->magic == SNAPSHOT_MAGIC && h->version == JOURNAL_VERSION &&
+                h->count <= (bytes.size() - sizeof(SnapshotHeader)) / sizeof(JournalRecord)) {
+                for (uint64_t i = 0; i < h->count; ++i) {
+                    recovered[std::wstring(r[i].name, _tcsnlen(r[i].name, NAME_SIZE))] = { r[i].score, r[i].type >> JOURNAL_TYPE_BITS };
+                }
+
+                from = at = h->sequence;
+                loaded = h->count;
+            }
+            else {
+                _tprintf(_T("Snapshot '%s' is invalid, ignored\n"), snapshot_path.c_str());
+            }
+        }
+
+        replayed += replay(old_path.c_str(), from, recovered, at);
+        replayed += replay(path.c_str(), from, recovered, at);
+
+        // One more restart waited by every score; those that waited too long are dropped
+        for (auto s = recovered.begin(); s != recovered.end(); ) {
+            if (++s->second.restarts > JOURNAL_RECOVERED_RESTARTS) {
+                s = recovered.erase(s);
+                ++expired;
+            }
+            else {
+                ++s;
+            }
+        }
+
+        // Start over from the recovered state: snapshot it, then drop the segments it covers
+        std::vector<JournalRecord> records;
+
+        for (auto& s : recovered) {
+            JournalRecord r;
+            journalRecord(r, JOURNAL_INSERT | (s.second.restarts << JOURNAL_TYPE_BITS), s.first.c_str(), s.second.score);
+            records.push_back(r);
+        }
+
+        if (!writeSnapshot(at, records)) {
+            return false;
+        }
+
+        DeleteFile(old_path.c_str());
+        appended = written = at;
+
+        if (!createSegment(at)) {
+            return false;
+        }
+
+        QueryPerformanceCounter(&end);
+        QueryPerformanceFrequency(&frequency);
+        _tprintf(_T("Recovered %u scores (%llu from the snapshot, %llu journal records, %llu expired) in %.1f ms\n"),
+            (uint32_t)recovered.size(), loaded, replayed, expired, 1000.0 * (end.QuadPart - start.QuadPart) / frequency.QuadPart);
+
+        if ((wake = CreateEvent(NULL, FALSE, FALSE, NULL)) == NULL) {
+            _tprintf(TEXT("CreateEvent %d"), GetLastError());
+            return false;
+        }
+
+        if ((thread = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)writer, this, 0, NULL)) == NULL) {
+            _tprintf(TEXT("CreateThread %d"), GetLastError());
+            return false;
+        }
+
+        return true;
+    }
+
+    /**
+     * Stop the writer after a last commit
+     */
+    void close() {
+        if (thread != NULL) {
+            InterlockedExchange(&stopping, 1);
+            SetEvent(wake);
+            WaitForSingleObject(thread, INFINITE);
+            CloseHandle(thread);
+            CloseHandle(wake);
+            thread = NULL;
+        }
+
+        if (file != INVALID_HANDLE_VALUE) {
+            CloseHandle(file);
+            file = INVALID_HANDLE_VALUE;
+        }
+    }
+
+    /**
+     * Queue a record (never waits on the disk)
+     *
+     * @param type JournalRecordType
+     * @param name Player name (NAME_SIZE characters, padded after the terminator)
+     * @param score Score after the change
+     */
+    void append(uint32_t type, const TCHAR* name, int32_t score) {
+        JournalRecord r;
+        r.type = type;
+        r.score = score;
+        memcpy(r.name, name, sizeof(r.name));   // names are NAME_SIZE arrays; checked by the writer
+
+        EnterCriticalSection(&lock);
+
+        if (stopped) {
+            LeaveCriticalSection(&lock);
+            return;
+        }
+
+        pending.push_back(r);
+        appended = appended + 1;
+        bool full = pending.size() >= JOURNAL_COMMIT_RECORDS;
+        LeaveCriticalSection(&lock);
+
+        if (full) {
+            SetEvent(wake);
+        }
+    }
+
+    /**
+     * Get the sequence number of the next record
+     * Appends made inside a GameData change are counted by the time the change ends
+     */
+    uint64_t sequence() const {
+        return appended;
+    }
+
+    /**
+     * Get the score recovered for a name
+     *
+     * @return Recovered score, 0 if none
+     */
+    int32_t recoveredScore(const TCHAR* name) {
+        EnterCriticalSection(&lock);
+        auto found = recovered.find(name);
+        int32_t score = found == recovered.end() ? 0 : found->second.score;
+        LeaveCriticalSection(&lock);
+        return score;
+    }
+
+    /**
+     * Forget the recovered score of a name (its player logged in with it)
+     */
+    void claim(const TCHAR* name) {
+        EnterCriticalSection(&lock);
+        recovered.erase(name);
+        LeaveCriticalSection(&lock);
+    }
+
+    /**
+     * Check if the journal is running
+     */
+    bool running() const {
+        return thread != NULL && !stopped;
+    }
+
+    /**
+     * Get the number of group commits done
+     */
+    uint64_t commitCount() const {
+        return commits;
+    }
+
+    /**
+     * Get the number of snapshots written
+     */
+    uint64_t snapshotCount() const {
+        return snapshots;
+    }
+};
+
+#endif
@@ -2,6 +2,18 @@
 
 /* project specific */
 #include "GameData.h"
+#include "WordIndex.h"
+#include "GuessKernel.h"
+#include "GuessFilter.h"
+#include "DictionaryCompiler.h"
+#include "SolutionSet.h"
+#include "ServerStats.h"
+#include "DictionaryVersion.h"
+#include "Epoch.h"
+#include "ScoreJournal.h"
+#include "ProfileStore.h"
+#include "LeaderboardSnapshot.h"
+#include "Broadcaster.h"
 
 /*
 
@@ -10,13 +22,17 @@
 */
 
 /* Synchronization objects for thread coordination and shared memory access */
-HANDLE semaphore_handle;    // Semaphore to control access to shared memory (allows MAX_PLAYERS + 2)
+HANDLE state_handle;        // Mutex held while game() changes the board or a guess is checked against it (clients read it lock free)
+HANDLE tick_handles[2];     // Named manual reset events, tick_handles[tick & 1] set when a tick is published
 HANDLE data_handle;         // Mutex to protect GameData structure from concurrent access
 HANDLE clear_handle;        // Event that signals when the game array should be cleared
 HANDLE quit_handle;         // Global quit flag event for graceful shutdown
 HANDLE fm;                  // File mapping handle for game state shared memory
-HANDLE dictionary_handle;   // File mapping handle for dictionary shared memory
-HANDLE file_handle;         // Handle for 'dictionary.txt'
+HANDLE directory_handle;    // File mapping handle for the dictionary directory (dictionaryName)
+HANDLE names_handle;        // File mapping handle for the player name table (playerNamesName)
+HANDLE page_handle;         // File mapping handle for the leaderboard page (leaderboardPageName)
+HANDLE events_handle;       // File mapping handle for the event ring (eventRingName)
+HANDLE event_handles[2];    // Named manual reset events, event_handles[head & 1] set when an event is written
 
 /* Thread handles for the three main server threads */
 HANDLE game_thread;         // Main game logic thread (generates letters)
@@ -25,11 +41,28 @@ HANDLE cli_thread;          // Command line interface thread for admin commands
 
 /* Core game state and data */
 GameData data;              // Player management and game data
+Broadcaster broadcaster;    // Delivers the packets for one player off the game logic's locks (events go to the ring)
+ScoreJournal journal;       // Crash safe journal of the scores (declared after data: closed first)
 GameState* state;           // Shared memory structure containing game state
-Dictionary* dictionary;     // Shared memory structure containing word dictionary
+DictionaryDirectory* directory;         // Generation of the dictionary image the bots should map
+DictionaryVersion* volatile current_dictionary;   // Dictionary in use, swapped by game() at a tick
+DictionaryVersion* volatile pending_dictionary;   // Built by a reload, waiting for game() to publish it
+DictionaryVersion* volatile retired_dictionary;   // Replaced by game(), waiting for readers to leave
+volatile LONG reloading = 0;    // A reload thread is running
+EpochDomain epochs;         // Readers of current_dictionary and of the leaderboard snapshot that hold no lock
+LeaderboardCache leaderboard(data, epochs);     // Formatted leaderboard for LIST and "listar"
 uint32_t INTERVAL = 2000;   // Time interval between letter generation (milliseconds)
 uint32_t LETTERS = 10;      // Number of letters of wordgame
-std::map<std::wstring, bool> word_map;  // for quick dictionary verification
+uint32_t FILTER_RATE = 100; // Target false positive rate of the guess filter (1/10000)
+BoardHistogram board;       // letter counts of state->array, kept up to date by game()
+GuessKernel guess_kernel = guessKernelScalar;   // guess normalization, picked at startup for this CPU
+ServerStats stats;          // counters for the "estatisticas" command
+bool JOURNAL = true;        // Journal the scores to journalPath (registry DIARIO = 0 turns it off)
+const TCHAR* journalPath = TEXT("scores.journal");
+ProfileStore profiles;      // Lifetime stats of every player name (used with data_handle held)
+const TCHAR* profilesPath = TEXT("profiles.dat");
+int32_t streak_id = -1;     // Player who guessed the last word (with data_handle held)
+uint32_t streak = 0;        // and how many words in a row
 
 /*
 
@@ -37,11 +70,27 @@ std::map<std::wstring, bool> word_map;  // for quick dictionary verification
 
 */
 
+/* Threads reading current_dictionary without a lock (epoch slots) */
+enum EpochReader {
+    EPOCH_LISTEN,       // handleGuess and LIST, on the listen thread
+    EPOCH_CLI           // "listar", on the admin thread
+};
+
+/* Outcome of screening a guess, before any lock is taken */
+enum GuessScreen {
+    SCREEN_INVALID,     // not an a-z word of at most MAX_WORD_LENGTH letters
+    SCREEN_FILTERED,    // surely not in the dictionary (guess filter)
+    SCREEN_CANDIDATE    // may be in the dictionary
+};
+
 /* Forward declarations for thread functions and utilities */
 void* game(void* param);
 void* _listen(void* param);
 void* cli(void* param);
-bool word_match(const TCHAR* input, const TCHAR* array);
+void* reload(void* param);
+void handleLogout(const int32_t id);
+GuessScreen screen_guess(const DictionaryVersion* dict, const Letter* input, Letter* word, LetterSignature& sig);
+int64_t word_number(const DictionaryVersion* dict, const Letter* word, const LetterSignature& sig);
 
 /* init procedures */
 
@@ -49,29 +98,31 @@ bool word_match(const TCHAR* input, const TCHAR* array);
  * Initialize shared memory, events, and synchronization objects
  * Creates:
  * - File mapping for shared GameState structure
- * - File mapping for shared Dictionary structure
+ * - Event ring the events for every player are written to, and its signals (one per head parity)
  * - Clear event (manual reset) for array clearing signal
  * - Quit event (manual reset) for shutdown coordination
- * - Semaphore for shared memory access control (MAX_PLAYERS + 2 capacity)
+ * - Mutex for the board (game() and guesses; clients read it lock free)
+ * - Named tick events (manual reset, one per tick parity) the clients wait on
+ * - Player name table the clients resolve player IDs with
  * - Mutex for GameData protection
  *
  * @return true if all objects created successfully, false otherwise
  */
-bool initShmEventsSemaphore()
+bool initShmEvents()
 {
     // Get system allocation granularity for proper memory alignment
     SYSTEM_INFO sysInfo;
     GetSystemInfo(&sysInfo);
     DWORD granularity = sysInfo.dwAllocationGranularity;
-    DWORD alignedOffset = (BUFFER_SIZE / granularity) * granularity;
+    DWORD alignedOffset = (sizeof(GameState) / granularity) * granularity;
 
-    // Create file mapping for shared memory (BUFFER_SIZE bytes for GameState)
+    // Create file mapping for shared memory (one GameState)
     fm = CreateFileMapping(
         INVALID_HANDLE_VALUE,	// create new file (not backed by disk file)
         NULL,                   // default security attributes
         PAGE_READWRITE,	        // read/write access
         0,                      // maximum object size (high-order DWORD)
-        BUFFER_SIZE,            // maximum object size (low-order DWORD)
+        sizeof(GameState),      // maximum object size (low-order DWORD)
         sharedMemoryName        // name for the mapping object
     );
 
@@ -94,38 +145,30 @@ bool initShmEventsSemaphore()
         return false;
     }
 
-    // Realign offset
-    alignedOffset = ((MAX_WORDS * MAX_WORD_LENGTH * sizeof(TCHAR)) / granularity) * granularity;
+    // Create the event ring: an event is written once, whatever the number of players
+    events_handle = CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, sizeof(EventRing), eventRingName);
 
-    // Create file mapping for dictionary shared memory
-    dictionary_handle = CreateFileMapping(
-        NULL,	                                                        // create new file mapping
-        NULL,                                                           // default security attributes
-        PAGE_READWRITE,	                                                // read/write access
-        0,                                                              // maximum object size (high-order DWORD)
-        MAX_WORDS * (MAX_WORD_LENGTH + 1) * sizeof(TCHAR),                // maximum object size (low-order DWORD) (0 = file size)
-        dictionaryName                                                  // name for the mapping object
-    );
-
-    if (dictionary_handle == INVALID_HANDLE_VALUE || dictionary_handle == NULL) {
+    if (events_handle == NULL) {
         std::cout << "CreateFileMapping " << GetLastError() << std::endl;
         return false;
     }
 
-    // Map the shared memory into this process's address space
-    dictionary = (Dictionary*)MapViewOfFile(
-        dictionary_handle,
-        FILE_MAP_ALL_ACCESS,	                                // read/write access for other processes
-        0,                                                      // file offset (high-order DWORD)
-        alignedOffset,                                          // file offset (low-order DWORD)
-        MAX_WORDS * (MAX_WORD_LENGTH  + 1) * sizeof(TCHAR)      // number of bytes to map (0 = entire file)
-    );
+    EventRing* events = (EventRing*)MapViewOfFile(events_handle, FILE_MAP_WRITE, 0, 0, sizeof(EventRing));
 
-    if (dictionary == NULL) {
+    if (events == NULL) {
         std::cout << "MapViewOfFile " << GetLastError() << std::endl;
         return false;
     }
 
+    for (int i = 0; i < 2; ++i) {
+        if ((event_handles[i] = CreateEvent(NULL, TRUE, FALSE, eventSignalNames[i])) == NULL)
+        {
+            _tprintf(TEXT("CreateEvent %d"), GetLastError());
+            return false;
+        }
+    }
+
+    data.publishEvents(events, event_handles);
 
     // Create manual reset event for array clearing signal
     if ((clear_handle = CreateEvent(NULL, TRUE, FALSE, NULL)) == NULL)
@@ -141,84 +184,149 @@ bool initShmEventsSemaphore()
         return false;
     }
 
-    // Create semaphore for shared memory access control
-    // Initial and maximum count = MAX_PLAYERS + 2 (allows game thread + listen thread + all players)
-    if ((semaphore_handle = CreateSemaphore(NULL, MAX_PLAYERS + 2, MAX_PLAYERS + 2, updatedSemaphoreName)) == NULL)
+    // Create mutex for the board: only server threads take it, clients never make a tick wait
+    if ((state_handle = CreateMutex(NULL, FALSE, NULL)) == NULL)
     {
-        _tprintf(TEXT("CreateSemaphore %d"), GetLastError());
+        _tprintf(TEXT("CreateMutex %d"), GetLastError());
         return false;
     }
 
+    // Create the tick events: one SetEvent wakes every client, instead of one event per player
+    for (int i = 0; i < 2; ++i) {
+        if ((tick_handles[i] = CreateEvent(NULL, TRUE, FALSE, tickEventNames[i])) == NULL)
+        {
+            _tprintf(TEXT("CreateEvent %d"), GetLastError());
+            return false;
+        }
+    }
+
     // Create mutex for protecting GameData structure
     if ((data_handle = CreateMutex(NULL, FALSE, NULL)) == NULL)
     {
         _tprintf(TEXT("CreateMutex %d"), GetLastError());
         return false;
     }
+
+    // Create the player name table (one entry per player slot, sized by the capacity)
+    size_t names_size = playerNameTableSize(data.capacity());
+    names_handle = CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, (DWORD)names_size, playerNamesName);
+
+    if (names_handle == NULL) {
+        std::cout << "CreateFileMapping " << GetLastError() << std::endl;
+        return false;
+    }
+
+    PlayerNameTable* names = (PlayerNameTable*)MapViewOfFile(names_handle, FILE_MAP_WRITE, 0, 0, names_size);
+
+    if (names == NULL) {
+        std::cout << "MapViewOfFile " << GetLastError() << std::endl;
+        return false;
+    }
+
+    data.publishNames(names);
+
+    // Create the leaderboard page (top players and every score, read by the clients)
+    size_t page_size = leaderboardPageSize(data.capacity());
+    page_handle = CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, (DWORD)page_size, leaderboardPageName);
+
+    if (page_handle == NULL) {
+        std::cout << "CreateFileMapping " << GetLastError() << std::endl;
+        return false;
+    }
+
+    LeaderboardPage* page = (LeaderboardPage*)MapViewOfFile(page_handle, FILE_MAP_WRITE, 0, 0, page_size);
+
+    if (page == NULL) {
+        std::cout << "MapViewOfFile " << GetLastError() << std::endl;
+        return false;
+    }
+
+    data.publishLeaderboard(page);
+    return true;
 }
 
-/* Initialize dictionary contents */
+/* Initialize score journal */
 
-bool initDictionary() {
-    int i, j;
-    FILE* inputFile;
-    TCHAR buffer[BUFFER_SIZE];
-
-    // Initialize dictionary array
-    for (i = 0; i < MAX_WORDS; i++) {
-        for (j = 0; j <= MAX_WORD_LENGTH; j++) {
-            dictionary->words[i][j] = _T('\0');
-        }
+/**
+ * Recover the scores of the previous run and journal every change from now on
+ * Recovered scores are given back when their players log in again
+ *
+ * @return true if journaling started (or is turned off), false otherwise
+ */
+bool initJournal() {
+    if (!JOURNAL) {
+        return true;
     }
 
-    _tprintf(_T("Loading dictionary from text file...\n"));
+    if (!journal.open(journalPath, [](std::vector<JournalRecord>& records) { return data.journalState(records); })) {
+        return false;
+    }
 
-    // Open dictionary file as regular text file
-    if (_tfopen_s(&inputFile, _T("words.txt"), _T("r")) != 0) {
-        _tprintf(_T("Error: Could not open 'words.txt' file\n"));
-        
+    data.journalTo(&journal);
+    return true;
+}
+
+/* Initialize broadcaster */
+
+/**
+ * Start the I/O threads that deliver the packets for one player (exit orders) to its client
+ *
+ * @return true on success, false otherwise
+ */
+bool initBroadcaster() {
+    if (!broadcaster.start(BROADCAST_THREADS)) {
         return false;
     }
 
-    // Read words line by line
-    i = 0;
-    while (i < MAX_WORDS && _fgetts(buffer, BUFFER_SIZE, inputFile) != NULL) {
-        // Remove newline character if present
-        int len = _tcslen(buffer);
-        if (len > 0 && (buffer[len - 1] == _T('\n') || buffer[len - 1] == _T('\r'))) {
-            buffer[len - 1] = _T('\0');
-            len--;
-        }
-        if (len > 1 && buffer[len - 1] == _T('\r')) {
-            buffer[len - 1] = _T('\0');
-            len--;
-        }
+    data.broadcastThrough(&broadcaster);
+    return true;
+}
 
-        // Skip empty lines
-        if (len == 0) {
-            continue;
-        }
+/* Initialize player profiles */
 
-        // Truncate word if longer than MAX_WORD_LENGTH
-        if (len > MAX_WORD_LENGTH) {
-            buffer[MAX_WORD_LENGTH] = _T('\0');
-            len = MAX_WORD_LENGTH;
-        }
+/**
+ * Open the profile store; profiles are read in as their players log in
+ *
+ * @return true on success, false otherwise
+ */
+bool initProfiles() {
+    return profiles.open(profilesPath);
+}
 
-        // Copy word to shared memory
-        _tcscpy_s(dictionary->words[i], MAX_WORD_LENGTH + 1, buffer);
+/* Initialize dictionary contents */
 
-#ifdef DEBUG
-        _tprintf(_T("Loaded word %d: %s\n"), i, dictionary->words[i]);
-#endif
+/**
+ * Load the dictionary and share it with the bots
+ * Creates the dictionaryName directory the bots read the current generation from,
+ * then loads generation 1 ('words.dict' when present, else the built-in words)
+ *
+ * @return true if the dictionary is mapped and indexed, false otherwise
+ */
+bool initDictionary() {
+    directory_handle = CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, sizeof(DictionaryDirectory), dictionaryName);
 
-        // load word into hashmap for fast lookup
-        word_map[dictionary->words[i]] = true;
+    if (directory_handle == NULL) {
+        std::cout << "CreateFileMapping " << GetLastError() << std::endl;
+        return false;
+    }
+
+    directory = (DictionaryDirectory*)MapViewOfFile(directory_handle, FILE_MAP_WRITE, 0, 0, sizeof(DictionaryDirectory));
+
+    if (directory == NULL) {
+        std::cout << "MapViewOfFile " << GetLastError() << std::endl;
+        return false;
+    }
 
-        i++;
+    if ((current_dictionary = loadDictionaryVersion(NULL, 1, FILTER_RATE / 10000.0)) == NULL) {
+        return false;
     }
 
-    fclose(inputFile);
+    InterlockedExchange(&directory->generation, current_dictionary->generation);
+
+    // pick the guess kernel once, every guess goes through it
+    const TCHAR* kernel_name;
+    guess_kernel = selectGuessKernel(&kernel_name);
+    _tprintf(_T("Guess kernel: %s\n"), kernel_name);
     return true;
 }
 
@@ -264,15 +372,29 @@ Login_Return_Type handleLogin(const TCHAR* name) {
 
     WaitForSingleObject(data_handle, INFINITE);  // Acquire exclusive access to GameData
 
-    Login_Return_Type res = data.insert(name);  // Try to insert new player entry
+    int32_t saved = journal.recoveredScore(name);   // score of the previous run, if any
+    Login_Return_Type res = data.insert(name, saved);  // Try to insert new player entry
+
+    if (res.flag == LOGIN) {
+        TCHAR stored[NAME_SIZE];
+        PlayerProfile* profile;
+
+        journal.claim(name);
+
+        // Profile of the name as stored (truncated to NAME_SIZE)
+        if (data.playerName(res.id, stored) && (profile = profiles.create(stored)) != NULL) {
+            profile->sessions += 1;
+        }
+    }
 
     ReleaseMutex(data_handle);                   // Release GameData access
     
     // Announce new player, if accepted
     if (res.flag == LOGIN) {
+        leaderboard.refresh();
         Packet p = { 0 };
         p.code = PLAYER_LOGIN;
-        _tcscpy_s(p.buffer, (ARRAY_SIZE + 2) * sizeof(TCHAR), name);
+        p.id = res.id;      // clients resolve the name in the name table
 
         WaitForSingleObject(data_handle, INFINITE);  // Acquire exclusive access to GameData
         
@@ -290,15 +412,64 @@ Packet handleScoreRequest(int32_t id) {
     Packet p = { 0 };
     p.code = SCORE;
 
-    WaitForSingleObject(data_handle, INFINITE);
-    score = data.score(id);
-    ReleaseMutex(data_handle);
+    score = data.score(id);     // lock free read, no wait behind broadcasts
 
     p.id = score < 0 ? 0 : score;
 
     return p;
 }
 
+/**
+ * Handle leaderboard position request
+ * Answered from the leaderboard tree in O(log n) without taking data_handle
+ *
+ * @param id Player ID asking
+ * @return RANK packet (id = rank, 0 if the player does not exist)
+ */
+Packet handleRankRequest(int32_t id) {
+    Packet p = { 0 };
+    PlayerStanding s;
+    p.code = RANK;
+
+    if (data.standing(id, s)) {
+        p.id = s.rank;
+        p.rank.players = s.players;
+        p.rank.score = s.score;
+        p.rank.next = s.next;
+    }
+
+    return p;
+}
+
+/**
+ * Handle leaderboard request
+ * Sends the latest leaderboard snapshot unless the client already has its version;
+ * no lock and no formatting (the snapshot is kept formatted by refresh())
+ *
+ * @param pipe Pipe of the asking client
+ * @param known Leaderboard version the client has (0 if none)
+ */
+void handleListRequest(HANDLE pipe, uint32_t known) {
+    LeaderboardSnapshot s;
+    Packet p = { 0 };
+    p.code = LIST;
+    p.list.version = known;
+
+    if (leaderboard.copy(EPOCH_LISTEN, known, s)) {
+        p.list.version = s.version;
+        p.list.length = (uint32_t)s.text.size();
+    }
+
+    if (!WriteFile(pipe, &p, sizeof(Packet), NULL, NULL)) {
+        _tprintf(TEXT("WriteFile %d"), GetLastError());
+        return;
+    }
+
+    if (p.list.length > 0 && !WriteFile(pipe, s.text.c_str(), p.list.length * sizeof(TCHAR), NULL, NULL)) {
+        _tprintf(TEXT("WriteFile %d"), GetLastError());
+    }
+}
+
 /**
  * Handle player logout by name
  * Removes player from GameData and broadcasts departure to all clients
@@ -308,7 +479,6 @@ Packet handleScoreRequest(int32_t id) {
 void handleLogout(const TCHAR* name) {
     Packet p = { 0 };
     p.code = PLAYER_LOGOUT;
-    _tcsncpy_s(p.buffer, name, ARRAY_SIZE + 1);
 
     Packet exit_order;
     ZeroMemory(&exit_order, sizeof(Packet));
@@ -323,6 +493,7 @@ void handleLogout(const TCHAR* name) {
 
     if (player_id != -1) 
     {
+        p.id = player_id;   // the name table entry outlives the player until its slot is reused
         data.send(player_id, exit_order);
         data.remove(name);
         data.broadcast(p, player_id);  // Announce departure to all connected clients
@@ -330,6 +501,7 @@ void handleLogout(const TCHAR* name) {
     }
     
     ReleaseMutex(data_handle);
+    leaderboard.refresh();
 }
 
 /**
@@ -341,75 +513,169 @@ void handleLogout(const TCHAR* name) {
 void handleLogout(const int32_t id) {
     Packet p = { 0 };
     p.code = PLAYER_LOGOUT;
-    const TCHAR* name = data.playerName(id);
-
-    if (name == NULL) { // Player does not exist
-        return;
-    }
+    p.id = id;
+    TCHAR name[NAME_SIZE];
 
     Packet exit_order = { 0 };
     exit_order.code = LOGOUT;
 
+    // Thread-safe player removal: the pipe handler and the admin can race on the same ID
+    WaitForSingleObject(data_handle, INFINITE);
+
+    if (!data.playerName(id, name) || data.byName(name) != id) { // Player already removed
+        ReleaseMutex(data_handle);
+        return;
+    }
+
     std::wcout << L"Removing " << name << L" ID: " << id << L"\n";
-    _tcsncpy_s(p.buffer, name, ARRAY_SIZE + 1);
 
-    // Thread-safe player removal
-    WaitForSingleObject(data_handle, INFINITE);
-    
     data.send(id, exit_order);
-    data.remove(name);
-    data.broadcast(p);  // Announce departure to all connected clients
+    data.remove(id);
+    data.broadcast(p, id);  // Announce departure to all connected clients
 
     ReleaseMutex(data_handle);
+    leaderboard.refresh();
+}
+
+/**
+ * Count a guessed word in the lifetime stats of a player
+ * Call with data_handle held
+ *
+ * @param gameId Player ID who guessed the word
+ */
+void updateProfile(int32_t gameId) {
+    TCHAR name[NAME_SIZE];
+    PlayerProfile* profile;
+
+    streak = (streak_id == gameId) ? streak + 1 : 1;
+    streak_id = gameId;
+
+    if (data.playerName(gameId, name) && (profile = profiles.find(name)) != NULL) {
+        profile->words += 1;
+        profile->total_score += 1;
+        profile->best_streak = streak > profile->best_streak ? streak : profile->best_streak;
+    }
+}
+
+/**
+ * Announce a player taking the lead (MVP) or entering the top LEADERBOARD_TOP (TOP_RANK)
+ * Only transitions are announced: the ranks come from the update, nothing is scanned
+ * Call with data_handle held
+ *
+ * @param id Player ID whose score changed
+ * @param score New score
+ * @param change Ranks before and after the change
+ */
+void announceRankChange(int32_t id, int32_t score, const RankChange& change) {
+    Packet p = { 0 };
+    p.id = id;
+    p.standing.score = score;
+    p.standing.rank = (int32_t)change.after;
+
+    if (change.after == 1 && change.before != 1) {
+        p.code = MVP;
+    }
+    else if (change.after <= LEADERBOARD_TOP && change.before > LEADERBOARD_TOP) {
+        p.code = TOP_RANK;
+    }
+    else {
+        return;
+    }
+
+    data.broadcast(p);
 }
 
 /**
  * Handle word guess from a player
  * Validates the guess against current letter array and updates score if correct
- * Uses both semaphore (for shared memory) and mutex (for GameData) synchronization
+ * Uses both the state mutex (for the board) and data mutex (for GameData) synchronization;
+ * the guess is normalized and screened by the guess filter before either is taken,
+ * inside an epoch so a dictionary reload cannot free the filter under it.
+ * A guess made against a board that has been solved since is stale: it is rejected
+ * without validation (checked again under the state mutex, without data_handle, where a
+ * board solved but not cleared yet rejects every guess)
  *
  * @param gameId Player ID making the guess
- * @param buffer Word guess from the player
+ * @param letters Word guess from the player (letter codes)
+ * @param boardEpoch Board epoch the guess was made against (0 if unknown: not checked)
  */
-void handleGuess(int32_t gameId, const TCHAR* buffer) {
-    std::wstring guess;
-    const TCHAR* word = buffer;
-    const TCHAR* name = NULL;
+void handleGuess(int32_t gameId, const Letter* letters, uint32_t boardEpoch) {
     bool announceGuess = false;
-    int32_t i = 0, score = 0;
-
-    // Acquire shared memory access and GameData access
-    WaitForSingleObject(semaphore_handle, INFINITE);
-    WaitForSingleObject(data_handle, INFINITE);
+    int32_t score = 0;
+    RankChange change;
+    Letter word[GUESS_KERNEL_WIDTH];
+    LetterSignature sig;
+    LARGE_INTEGER locked, unlocked;
 
-    // Validate player exists
-    if ((name = data.playerName(gameId)) == NULL) {
+    // Validate player exists (lock free read of GameData)
+    if (data.score(gameId) < 0) {
 #ifdef DEBUG
         std::cout << "Player does not exist. ID: " << gameId << "\n";
 #endif
-        ReleaseSemaphore(semaphore_handle, 1, NULL);
-        ReleaseMutex(data_handle);
         return;
     }
 
-    // Convert buffer to wstring for processing
-    for (; i < BUFFER_SIZE; ++i) {
-        if (word[i] == TEXT('\0')) {
-            break;
-        }
+    if (boardEpoch != 0 && boardEpoch != state->epoch) {
+        InterlockedIncrement64(&stats.stale_guesses);
+        return;
+    }
+
+    // No lock needed: the kernel and the filter only read the guess and immutable data
+    epochs.enter(EPOCH_LISTEN);
+    DictionaryVersion* dict = current_dictionary;
+    GuessScreen screen = screen_guess(dict, letters, word, sig);
 
-        guess += (char)buffer[i];
+    // Acquire shared memory access and GameData access
+    WaitForSingleObject(state_handle, INFINITE);
+
+    // Solved while waiting (the board epoch only moves under the state mutex), or solved and
+    // not cleared yet: a copy taken since has the new epoch but still the old letters
+    if ((boardEpoch != 0 && boardEpoch != state->epoch) || WaitForSingleObject(clear_handle, 0) == WAIT_OBJECT_0) {
+        InterlockedIncrement64(&stats.stale_guesses);
+        ReleaseMutex(state_handle);
+        epochs.leave(EPOCH_LISTEN);
+        return;
     }
-    
-    // Check if guess is valid (non-empty and matches available letters)
-    if (!guess.empty() && word_match(guess.c_str(), state->array))
+
+    WaitForSingleObject(data_handle, INFINITE);
+    QueryPerformanceCounter(&locked);
+
+    // A reload published while waiting: the board's solutions are those of the new dictionary
+    if (current_dictionary != dict) {
+        dict = current_dictionary;
+        screen = screen_guess(dict, letters, word, sig);
+    }
+
+    stats.guesses += 1;
+
+    if (screen == SCREEN_FILTERED) {
+        stats.filter_rejects += 1;
+    }
+
+    // Word number in the dictionary (-1 if not a word)
+    int64_t w = (screen == SCREEN_CANDIDATE) ? word_number(dict, word, sig) : -1;
+
+    if (screen == SCREEN_CANDIDATE && w < 0) {
+        stats.filter_false_positives += 1;
+    }
+
+    // Check if guess is valid (one of the words the board can form)
+    // (the player may have left while waiting: update fails and nothing is announced)
+    if (dict->solutions.contains(w) && data.update(gameId, 1, &change))
     {
-        data.update(gameId, 1);     // Award point to player
+        stats.hits += 1;
 
         announceGuess = true;       // Boolean flag for announcing guess
 
         score = data.score(gameId); // For announcing new score
 
+        updateProfile(gameId);
+
+        // Solved: guesses at this board are stale from now on, not from the tick that clears it
+        InterlockedIncrement(&state->sequence);
+        state->epoch += 1;
+        InterlockedIncrement(&state->sequence);
+
         SetEvent(clear_handle);     // Signal game thread to clear array
     }
 
@@ -417,19 +683,26 @@ void handleGuess(int32_t gameId, const TCHAR* buffer) {
     if (announceGuess) {
         Packet p = { 0 };
         p.code = GUESS;
-        p.id = score;
-        _tcsncpy_s(p.buffer, name, ARRAY_SIZE + 1);
+        p.id = gameId;
+        p.score = score;
 
         data.broadcast(p);
+        announceRankChange(gameId, score, change);
     }
 
+    QueryPerformanceCounter(&unlocked);
+    stats.guess_lock_ticks += unlocked.QuadPart - locked.QuadPart;
+
     // Release GameData
     ReleaseMutex(data_handle);
-    // Release semaphore
-    ReleaseSemaphore(semaphore_handle, 1, NULL);
+    // Release shared memory
+    ReleaseMutex(state_handle);
+    epochs.leave(EPOCH_LISTEN);
 
-    
-    return;
+    // Outside the epoch: refresh may wait for readers
+    if (announceGuess) {
+        leaderboard.refresh();
+    }
 }
 
 /* aux procedures */
@@ -440,12 +713,12 @@ void handleGuess(int32_t gameId, const TCHAR* buffer) {
  *
  * @param array Letter array to display
  */
-void display(const TCHAR* array, int arraySize) {
+void display(const Letter* array, int arraySize) {
     for (int i = 0; i < arraySize; ++i) {
-        if (array[i] == 0) {
+        if (array[i] >= LETTER_COUNT) {
             std::wcout << L" _ ";  // Empty position
         }
-        else std::wcout << L" " << array[i] << L" ";  // Letter
+        else std::wcout << L" " << letterToChar(array[i]) << L" ";  // Letter
     }
 
     std::wcout << L"\n";
@@ -453,59 +726,51 @@ void display(const TCHAR* array, int arraySize) {
 
 /**
  * Clear/reset the letter array
- * Sets all positions to null character
+ * Sets all positions to LETTER_NONE
  *
  * @param array Array to clear
  */
-void clear(TCHAR* array) {
-    memset(array, 0, ARRAY_SIZE * sizeof(TCHAR));
+void clear(Letter* array) {
+    memset(array, LETTER_NONE, BOARD_SIZE * sizeof(Letter));
 }
 
 /**
- * Check if a word can be formed from available letters
- * Uses frequency counting to ensure word doesn't use more letters than available
+ * Normalize a guess with the guess kernel and screen it with the guess filter
+ * Reads no game state, so it runs before handleGuess takes any lock
  *
- * @param input Word to check
- * @param array Available letters array
- * @return true if word can be formed, false otherwise
- * @throws std::runtime_error if either parameter is NULL
+ * @param dict Dictionary in use (kept alive by the caller's epoch)
+ * @param input Guess (read for GUESS_KERNEL_WIDTH letters, as a packet buffer)
+ * @param word Receives the checked guess (GUESS_KERNEL_WIDTH letters)
+ * @param sig Receives the letter signature of word
+ * @return SCREEN_CANDIDATE if word may be in the dictionary
+ * @throws std::runtime_error if input is NULL
  */
-bool word_match(const TCHAR* input, const TCHAR* array) {
-    if (array == NULL || input == NULL) {
-        throw std::runtime_error("array == NULL || input == NULL");
+GuessScreen screen_guess(const DictionaryVersion* dict, const Letter* input, Letter* word, LetterSignature& sig) {
+    if (input == NULL) {
+        throw std::runtime_error("input == NULL");
     }
 
-    int t[26] = { 0 };  // Frequency table for letters a-z
-    int len = _tcslen(input);
-
-    // Count available letters
-    for (int i = 0; i < ARRAY_SIZE; ++i) {
-        t[array[i] - L'a'] += 1;
-    }
-
-    // Check if input word can be formed
-    for (int i = 0; i < len; ++i) {
-        TCHAR c = input[i];
-        int f = t[c - L'a'];
-
-        f -= 1;
-        if (f < 0) {
-            return false;  // Not enough of this letter available
-        }
-
-        t[c - L'a'] = f;
+    // Only words of letter codes, at most MAX_WORD_LENGTH of them, can be in the dictionary
+    if (!guess_kernel(input, word, sig)) {
+        return SCREEN_INVALID;
     }
 
-    std::wstring temp(input);
+    // One cache line tells most non-words apart
+    return dict->filter.mayContain(word) ? SCREEN_CANDIDATE : SCREEN_FILTERED;
+}
 
-    // input exists in the dictionary
-    if (word_map.find(temp) != word_map.end()) {
-        return true;
-    }
-    else {
-        // close, but no cigar
-        return false;
-    }
+/**
+ * Find a screened guess in the dictionary
+ * One probe of the signature index (or the perfect hash of the built-in dictionary),
+ * with no allocation; the result is then tested against the board's solution set
+ *
+ * @param dict Dictionary in use
+ * @param word Checked guess (screen_guess output)
+ * @param sig Letter signature of word
+ * @return Word number, -1 if word is not in the dictionary
+ */
+int64_t word_number(const DictionaryVersion* dict, const Letter* word, const LetterSignature& sig) {
+    return dict->embedded ? embeddedFind(word) : dict->index.find(word, sig);
 }
 
 /**
@@ -515,35 +780,87 @@ bool word_match(const TCHAR* input, const TCHAR* array) {
  */
 void initCmds(std::map<std::wstring, cmd>& cmds) {
     const HANDLE this_data_handle = data_handle;
-    const HANDLE this_semaphore_handle = semaphore_handle;
+    const HANDLE this_state_handle = state_handle;
 
     // "listar" - List all players and their scores
-    cmds[TEXT("listar")] = [this_data_handle](const TCHAR* args) {
+    cmds[TEXT("listar")] = [](const TCHAR* args) {
+        LeaderboardSnapshot s;
+
+        if (leaderboard.copy(EPOCH_CLI, 0, s)) {
+            std::wcout << s.text;  // Display leaderboard (kept formatted, no lock)
+        }
+        };
+
+    // "estatisticas" - Show board and guess counters
+    cmds[TEXT("estatisticas")] = [this_data_handle, this_state_handle](const TCHAR* args) {
+        WaitForSingleObject(this_state_handle, INFINITE);
         WaitForSingleObject(this_data_handle, INFINITE);
-        std::wcout << data.str();  // Display leaderboard
+        stats.print(current_dictionary->filter);   // not swapped while the state mutex is held
+
+        if (journal.running()) {
+            std::wcout << L"Diario: " << journal.sequence() << L" registos, " << journal.commitCount() << L" escritas, " << journal.snapshotCount() << L" snapshots\n";
+        }
         ReleaseMutex(this_data_handle);
+        ReleaseMutex(this_state_handle);
         };
 
-    // "excluir" - Exclude/remove a player by name
-    cmds[TEXT("excluir")] = [this_data_handle](const TCHAR* args) {
+    // "perfil" - Show the lifetime stats of a player name
+    cmds[TEXT("perfil")] = [this_data_handle](const TCHAR* args) {
         WaitForSingleObject(this_data_handle, INFINITE);
-        handleLogout(args);
+        const PlayerProfile* profile = profiles.find(args);
+
+        if (profile == NULL) {
+            std::wcout << L"Sem perfil: " << args << L"\n";
+        }
+        else {
+            std::wcout << profile->name << L": " << profile->total_score << L" pontos, " << profile->words << L" palavras, "
+                << profile->sessions << L" sessoes, melhor sequencia " << profile->best_streak << L"\n";
+        }
         ReleaseMutex(this_data_handle);
+        };
+
+    // "excluir" - Exclude/remove a player by name
+    cmds[TEXT("excluir")] = [](const TCHAR* args) {
+        handleLogout(args);     // takes data_handle itself (holding it here would stall the leaderboard refresh)
         std::wcout << TEXT("Goodbye ") << args << "\n";
         };
 
     // "acelerar" - Accelerate game (decrease time interval, minimum 1000ms)
-    cmds[TEXT("acelerar")] = [this_semaphore_handle](const TCHAR* args) {
-        WaitForSingleObject(this_semaphore_handle, INFINITE);
+    cmds[TEXT("acelerar")] = [this_state_handle](const TCHAR* args) {
+        WaitForSingleObject(this_state_handle, INFINITE);
         INTERVAL = (INTERVAL - 1000) < 1000 ? 1000 : INTERVAL - 1000;
-        ReleaseSemaphore(this_semaphore_handle, 1, NULL);
+        ReleaseMutex(this_state_handle);
         };
 
     // "travar" - Brake/slow down game (increase time interval)
-    cmds[TEXT("travar")] = [this_semaphore_handle](const TCHAR* args) {
-        WaitForSingleObject(this_semaphore_handle, INFINITE);
+    cmds[TEXT("travar")] = [this_state_handle](const TCHAR* args) {
+        WaitForSingleObject(this_state_handle, INFINITE);
         INTERVAL = INTERVAL + 1000;
-        ReleaseSemaphore(this_semaphore_handle, 1, NULL);
+        ReleaseMutex(this_state_handle);
+        };
+
+    // "recarregar" - Reload the dictionary in the background (optional word list or compiled dictionary)
+    cmds[TEXT("recarregar")] = [](const TCHAR* args) {
+        HANDLE reload_thread;
+        TCHAR* path = NULL;
+
+        if (InterlockedCompareExchange(&reloading, 1, 0) != 0) {
+            std::wcout << L"Recarregamento em curso\n";
+            return;
+        }
+
+        if (_tcslen(args) > 0) {
+            path = _tcsdup(args);   // freed by the reload thread
+        }
+
+        if ((reload_thread = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)reload, path, 0, NULL)) == NULL) {
+            _tprintf(TEXT("CreateThread %d"), GetLastError());
+            free(path);
+            InterlockedExchange(&reloading, 0);
+            return;
+        }
+
+        CloseHandle(reload_thread);
         };
 
     // "bot" - Launch bot process
@@ -582,12 +899,12 @@ void initCmds(std::map<std::wstring, cmd>& cmds) {
                 &pi
             )) {
                 std::cout << "bot CreateProcess " << GetLastError() << "\n";
-                ReleaseSemaphore(this_data_handle, 1, NULL);
+                ReleaseMutex(this_data_handle);
                 return;
             }
         }
 
-        ReleaseSemaphore(this_data_handle, 1, NULL);
+        ReleaseMutex(this_data_handle);
      };
 }
 
@@ -596,7 +913,8 @@ void initCmds(std::map<std::wstring, cmd>& cmds) {
 /**
  * Main game thread - Core game logic
  * Continuously generates random letters and updates shared game state
- * Synchronizes with clients using semaphore mechanism
+ * Publishes the board to the clients through its seqlock and the tick events: it never
+ * waits for a client, so a tick costs the same whatever the number (or state) of players
  *
  * @param param Unused thread parameter
  * @return NULL when thread exits
@@ -605,33 +923,77 @@ void* game(void* param) {
     int i = 0;  // Current position in letter array (wraps around)
     uint32_t updated_interval;
     srand(time(NULL));      // Initialize random seed
+    InterlockedIncrement(&state->sequence);
     clear(state->array);    // Start with empty array
+    board.clear();          // No letters on the board
     state->t = LETTERS;     // Assign max array length
+    state->epoch += 1;      // First board
+    InterlockedIncrement(&state->sequence);
 
     while (WaitForSingleObject(quit_handle, 0) != WAIT_OBJECT_0)    // Continue until quit signal
     {
-        // Lock entire system by acquiring all semaphore permits
-        // This ensures no clients are reading shared memory during update
+        // Lock the board: no guess is checked against it during the update
 #ifdef DEBUG
-        std::cout << "Waiting for semaphore..." << std::endl;
+        std::cout << "Waiting for state mutex..." << std::endl;
 #endif
 
-        for (int i = 0; i < MAX_PLAYERS + 2; ++i) {
-            WaitForSingleObject(semaphore_handle, INFINITE);    // Acquire all locks, semaphore count -> 0
-        }
+        WaitForSingleObject(state_handle, INFINITE);
 
 #ifdef DEBUG
-        std::cout << "Semaphore locked" << std::endl;
+        std::cout << "State locked" << std::endl;
 #endif
 
         // Check if array should be cleared (correct guess was made)
-        if (WaitForSingleObject(clear_handle, 0) == WAIT_OBJECT_0) {
-            clear(state->array);        // Reset letter array
+        bool cleared = WaitForSingleObject(clear_handle, 0) == WAIT_OBJECT_0;
+
+        if (cleared) {
+            board.clear();              // Reset letter counts
             ResetEvent(clear_handle);   // Reset the clear signal
         }
 
         // Update game state with new random letter
-        state->array[i] = (TCHAR)(L'a' + (TCHAR)(rand() % (L'z' + 1 - L'a')));
+        Letter letter = (Letter)(rand() % LETTER_COUNT);
+        board.place(cleared ? LETTER_NONE : state->array[i], letter);
+
+        // Write the board for the clients: readers copying it meanwhile retry, none is waited for
+        uint32_t tick = state->tick + 1;
+        ResetEvent(tick_handles[(tick + 1) & 1]);  // rearmed first: a client that copies this tick waits on it
+        InterlockedIncrement(&state->sequence);
+
+        if (cleared) {
+            clear(state->array);        // Reset letter array (the guess that solved it moved the epoch)
+        }
+
+        state->array[i] = letter;
+        state->tick = tick;
+
+        // Log the change for clients applying changes instead of copying the board
+        BoardDelta& change = state->log[tick % BOARD_LOG_SIZE];
+        change.tick = tick;
+        change.position = (uint8_t)i;
+        change.letter = letter;
+        change.flags = cleared ? BOARD_CLEARED : 0;
+        InterlockedIncrement(&state->sequence);
+
+        // Publish a reloaded dictionary: no guess holds the state mutex, so none is between lookup and score
+        DictionaryVersion* next = (DictionaryVersion*)InterlockedExchangePointer((PVOID volatile*)&pending_dictionary, NULL);
+
+        if (next != NULL) {
+            retired_dictionary = (DictionaryVersion*)InterlockedExchangePointer((PVOID volatile*)&current_dictionary, next);
+            InterlockedExchange(&directory->generation, next->generation);    // bots remap on their next guess
+        }
+
+        // Every word the new board can form
+        current_dictionary->solutions.rebuild(current_dictionary->image, board.sig);
+        stats.ticks += 1;
+        stats.solutions = current_dictionary->solutions.count();
+
+        if (stats.solutions == 0) {
+            stats.unsolvable_ticks += 1;
+#ifdef DEBUG
+            std::cout << "Board has no solution" << std::endl;
+#endif
+        }
         updated_interval = INTERVAL;
 
 #ifdef DEBUG
@@ -642,11 +1004,13 @@ void* game(void* param) {
         std::cout << "Updating..." << std::endl;
 #endif
 
-        data.updateAllClients();  // Signal all clients to refresh their game state
-        ReleaseSemaphore(semaphore_handle, MAX_PLAYERS + 2, NULL);    // Release all permits, allow client access
+        ReleaseMutex(state_handle);     // Allow guesses
+
+        // Signal all clients to refresh their game state
+        SetEvent(tick_handles[tick & 1]);
 
 #ifdef DEBUG
-        std::cout << "Release semaphore" << std::endl;
+        std::cout << "Release state mutex" << std::endl;
 #endif
 
         i = (i + 1) % state->t;          // Move to next position (circular)
@@ -744,7 +1108,15 @@ void* _listen(void* param)
             break;
         }
 
-        _tprintf_s(L"Packet received: (%d, %d, %s)\n", input->code, input->id, input->buffer);
+        if (input->code == GUESS) {
+            TCHAR text[GUESS_SIZE];
+            lettersToText(input->letters, text, GUESS_SIZE);
+            _tprintf_s(L"Packet received: (%d, %d, %s)\n", input->code, input->id, text);
+        }
+        else {
+            input->buffer[NAME_SIZE - 1] = TEXT('\0');     // names are read as text below
+            _tprintf_s(L"Packet received: (%d, %d, %s)\n", input->code, input->id, input->buffer);
+        }
 
         // Process packet based on type
         switch (input->code)
@@ -774,9 +1146,24 @@ void* _listen(void* param)
 
             break;
 
+        case LIST:
+            // Handle leaderboard request
+            handleListRequest(pipe_handle, (*input).list.version);
+            break;
+
+        case RANK:
+            // Handle leaderboard position request
+            output[0] = handleRankRequest((*input).id);
+
+            if (!WriteFile(pipe_handle, &output[0], sizeof(Packet), NULL, NULL)) {
+                _tprintf(TEXT("WriteFile %d"), GetLastError());
+            }
+
+            break;
+
         case GUESS:
             // Handle word guess
-            handleGuess((*input).id, (*input).buffer);
+            handleGuess((*input).id, (*input).guess.letters, (*input).guess.epoch);
 
             // Send acknowledgment back to client
             if (!WriteFile(pipe_handle, input, sizeof(Packet), NULL, NULL)) {
@@ -849,9 +1236,56 @@ void* cli(void* param)
 }
 
 
+/**
+ * Dictionary reload thread, started by the "recarregar" command
+ * Builds a complete new dictionary version with nothing locked, hands it to game()
+ * to be published at the next tick, then frees the old version once no guess can
+ * still be reading it (epoch based reclamation). Guesses never wait for a reload.
+ *
+ * @param param Path of a word list or compiled dictionary (malloc'd), NULL for the startup dictionary
+ * @return NULL when thread exits
+ */
+void* reload(void* param) {
+    TCHAR* path = (TCHAR*)param;
+    DictionaryVersion* old = NULL;
+    DictionaryVersion* next = loadDictionaryVersion(path, current_dictionary->generation + 1, FILTER_RATE / 10000.0);
+
+    free(path);
+
+    if (next == NULL) {
+        std::wcout << L"Dicionario nao recarregado\n";
+        InterlockedExchange(&reloading, 0);
+        return NULL;
+    }
+
+    InterlockedExchangePointer((PVOID volatile*)&pending_dictionary, next);
+
+    // Wait for game() to swap it in
+    while ((old = (DictionaryVersion*)InterlockedExchangePointer((PVOID volatile*)&retired_dictionary, NULL)) == NULL) {
+        if (WaitForSingleObject(quit_handle, 50) == WAIT_OBJECT_0) {
+            // Shutting down: free it unless game() published it after all
+            if (InterlockedCompareExchangePointer((PVOID volatile*)&pending_dictionary, NULL, next) == next) {
+                destroyDictionaryVersion(next);
+                InterlockedExchange(&reloading, 0);
+                return NULL;
+            }
+
+            // game() took it: the version it replaced is retired right after, freed below
+            YieldProcessor();
+        }
+    }
+
+    // Guesses screened before the swap may still use the old filter
+    epochs.synchronize();
+    destroyDictionaryVersion(old);
+
+    std::wcout << L"Dicionario recarregado: geracao " << next->generation << L", " << next->image->words << L" palavras\n";
+    InterlockedExchange(&reloading, 0);
+    return NULL;
+}
 
 /*
-    For getting dword values from register, namely MAXLETRAS and RITMO
+    For getting dword values from register, namely MAXLETRAS, RITMO, FILTRO, JOGADORES and DIARIO
 */
 
 int dwordFromRegistryKey(const TCHAR* subKey, const TCHAR* valueName) {
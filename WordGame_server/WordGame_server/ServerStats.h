@@ -0,0 +1,63 @@
+#pragma once
+
+#ifndef _SERVERSTATS_H_
+#define _SERVERSTATS_H_
+
+#include "..\..\wordgame_common.h"
+#include "GuessFilter.h"
+
+/**
+ * Server counters, shown by the "estatisticas" admin command
+ * Board counters are written by the game thread while it holds the state mutex,
+ * guess counters by handleGuess while it holds the state mutex and data_handle;
+ * the admin command takes both to read them (but for stale_guesses, counted atomically:
+ * the first check of a guess counts it without a lock)
+ */
+struct ServerStats {
+    uint64_t ticks;             // Letters placed
+    uint64_t unsolvable_ticks;  // Ticks that left a board no word can be formed from
+    uint32_t solutions;         // Words that can be formed from the current board
+    uint64_t guesses;           // Guesses received from valid players
+    uint64_t hits;              // Correct guesses
+    uint64_t filter_rejects;    // Guesses the guess filter ruled out
+    uint64_t filter_false_positives;    // Guesses the guess filter let through that are not words
+    uint64_t guess_lock_ticks;  // Time handleGuess held data_handle (performance counter ticks)
+    volatile LONG64 stale_guesses;      // Guesses made against a board solved since, rejected without validation
+
+    ServerStats() : ticks(0), unsolvable_ticks(0), solutions(0), guesses(0), hits(0),
+        filter_rejects(0), filter_false_positives(0), guess_lock_ticks(0), stale_guesses(0) {};
+
+    /**
+     * Print counters to the console
+     *
+     * @param filter Guess filter, for its size and target rate
+     */
+    void print(const GuessFilter& filter) const {
+        LARGE_INTEGER frequency;
+        uint64_t negatives = filter_rejects + filter_false_positives;
+
+        std::wcout << L"Ticks: " << ticks << L" (sem solucao: " << unsolvable_ticks << L")\n";
+        std::wcout << L"Solucoes no tabuleiro: " << solutions << L"\n";
+        std::wcout << L"Tentativas: " << guesses << L" Acertos: " << hits;
+
+        if (guesses > 0) {
+            std::wcout << L" (" << (100.0 * hits / guesses) << L"%)";
+        }
+
+        std::wcout << L"\n";
+        std::wcout << L"Tentativas sobre um tabuleiro antigo (rejeitadas sem validacao): " << stale_guesses << L"\n";
+        std::wcout << L"Filtro: " << filter.size() << L" bytes, falsos positivos " << (100.0 * filter.targetRate()) << L"% (alvo)";
+
+        if (negatives > 0) {
+            std::wcout << L" " << (100.0 * filter_false_positives / negatives) << L"% (medido, " << filter_rejects << L" rejeitadas)";
+        }
+
+        std::wcout << L"\n";
+
+        if (guesses > 0 && QueryPerformanceFrequency(&frequency)) {
+            std::wcout << L"Tempo com data_handle por tentativa: " << (1e6 * guess_lock_ticks / frequency.QuadPart / guesses) << L" us\n";
+        }
+    }
+};
+
+#endif
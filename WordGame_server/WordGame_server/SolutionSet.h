@@ -0,0 +1,73 @@
+#pragma once
+
+#ifndef _SOLUTIONSET_H_
+#define _SOLUTIONSET_H_
+
+#include "..\..\wordgame_common.h"
+#include "WordIndex.h"
+#include <vector>
+
+/**
+ * Every dictionary word that can be formed from the current board
+ * Rebuilt by the game thread each time the board changes with a walk of the dictionary
+ * DAWG that only follows letters still left on the board, so the cost depends on the
+ * prefixes the board can spell, not on the size of the dictionary.
+ * Membership is one bit per dictionary word; the list of set bits makes clearing cheap.
+ */
+class SolutionSet {
+    std::vector<uint64_t> bits;     // one bit per dictionary word
+    std::vector<uint32_t> words;    // word numbers currently in the set
+
+    void add(uint32_t w) {
+        bits[w >> 6] |= 1ULL << (w & 63);
+        words.push_back(w);
+    }
+
+public:
+    /**
+     * Size the set for a dictionary, empty
+     *
+     * @param d Dictionary image
+     */
+    void reset(const DictionaryHeader* d) {
+        bits.assign((d->words + 63) / 64, 0);
+        words.clear();
+    }
+
+    /**
+     * Recompute the set for a board
+     *
+     * @param d Dictionary image (sized with reset)
+     * @param board Letter signature of the board
+     */
+    void rebuild(const DictionaryHeader* d, const LetterSignature& board) {
+        uint8_t counts[26];
+
+        for (uint32_t w : words) {
+            bits[w >> 6] &= ~(1ULL << (w & 63));
+        }
+        words.clear();
+
+        memcpy(counts, board.counts, sizeof(counts));
+        dawgWalk(d, counts, [this](uint32_t w) { add(w); });
+    }
+
+    /**
+     * Check if a word can be formed from the board
+     *
+     * @param w Word number, -1 (not a word) is never in the set
+     * @return true if the word is a solution
+     */
+    bool contains(int64_t w) const {
+        return w >= 0 && (uint64_t)w < bits.size() * 64 && (bits[w >> 6] >> (w & 63)) & 1;
+    }
+
+    /**
+     * Get number of solutions (0: the board cannot form any word)
+     */
+    uint32_t count() const {
+        return (uint32_t)words.size();
+    }
+};
+
+#endif
@@ -9,8 +9,17 @@ void safeClose(HANDLE h) {
 int _tmain(int argc, TCHAR* argv[])
 {
     bool threaded = false;    
+
+    // Offline mode: compile a word list into a dictionary file and exit
+    if (argc == 4 && !_tcscmp(argv[1], L"-compilar")) {
+        return compileDictionaryFile(argv[2], argv[3]) ? 0 : 1;
+    }
+
     int ritmo = dwordFromRegistryKey(L"SOFTWARE\\TrabSO2", L"RITMO");
     int maxletras = dwordFromRegistryKey(L"SOFTWARE\\TrabSO2", L"MAXLETRAS");
+    int filtro = dwordFromRegistryKey(L"SOFTWARE\\TrabSO2", L"FILTRO");
+    int jogadores = dwordFromRegistryKey(L"SOFTWARE\\TrabSO2", L"JOGADORES");
+    int diario = dwordFromRegistryKey(L"SOFTWARE\\TrabSO2", L"DIARIO");
 
     if (maxletras > 0) {
         LETTERS = (maxletras < 6) ? 6 : (maxletras > 12 ? 12 : maxletras);  // 6 <= LETTERS <= 12
@@ -20,9 +29,22 @@ int _tmain(int argc, TCHAR* argv[])
         INTERVAL = ritmo * 1000;   // 1000 <= INTERVAL
     }   // else use default value
 
-    if (initShmEventsSemaphore()) {
+    if (filtro > 0) {
+        FILTER_RATE = filtro > 5000 ? 5000 : filtro;    // 0.01% <= FILTER_RATE <= 50%
+    }   // else use default value
+
+    if (jogadores > 0) {
+        data.setCapacity(jogadores > MAX_PLAYERS_LIMIT ? MAX_PLAYERS_LIMIT : jogadores);    // 1 <= players <= MAX_PLAYERS_LIMIT
+    }   // else use default value (MAX_PLAYERS)
 
-        if (initDictionary()) {
+    if (diario == 0) {
+        JOURNAL = false;
+    }   // else journal the scores
+
+    if (initShmEvents()) {
+
+        if (initJournal() && initProfiles() && initDictionary() && initBroadcaster()) {
+            leaderboard.refresh();  // first (empty) snapshot for LIST
             
             if (initThreads()) {
                 threaded = true;
@@ -38,17 +60,32 @@ int _tmain(int argc, TCHAR* argv[])
     }
     
     data.warnLeave();   // inform all clients of server shutdown
+    broadcaster.stop(); // deliver what is still queued for single players
+    journal.close();    // last group commit; connected players keep their scores for the next run
+    profiles.close();   // write back the profiles still in memory
 
     UnmapViewOfFile(fm);
     CloseHandle(fm);
-    UnmapViewOfFile(dictionary_handle);
-    CloseHandle(dictionary_handle);
-    CloseHandle(file_handle);
+
+    while (reloading) {
+        Sleep(10);      // a reload still running frees the version it replaced
+    }
+
+    destroyDictionaryVersion(current_dictionary);
+    UnmapViewOfFile(directory);
+    CloseHandle(directory_handle);
+    CloseHandle(names_handle);
+    CloseHandle(page_handle);
+    CloseHandle(events_handle);
     CloseHandle(game_thread);
     CloseHandle(cli_thread);
     CloseHandle(listen_thread);
     CloseHandle(clear_handle);
-    CloseHandle(semaphore_handle);
+    CloseHandle(state_handle);
+    CloseHandle(tick_handles[0]);
+    CloseHandle(tick_handles[1]);
+    CloseHandle(event_handles[0]);
+    CloseHandle(event_handles[1]);
     CloseHandle(quit_handle);
     return 0;
 }
@@ -0,0 +1,276 @@
+#pragma once
+
+#ifndef _WORDINDEX_H_
+#define _WORDINDEX_H_
+
+#include "..\..\wordgame_common.h"
+#include "..\..\wordgame_dictionary.h"
+#include "EmbeddedDictionary.h"
+
+/**
+ * Letter count signature of a word (or of the board)
+ * One byte per letter a-z (26 used, 6 padding bytes always 0),
+ * packed into four 64 bit lanes so it can be hashed and compared a lane at a time
+ */
+union LetterSignature {
+    uint64_t lanes[4];
+    uint8_t counts[32];
+};
+
+// High bit of every byte, used to compare letter counts without unpacking them
+const uint64_t SIGNATURE_HIGH_BITS = 0x8080808080808080ULL;
+
+/**
+ * Build the letter signature of a word
+ * Only words of at most MAX_WORD_LENGTH letters have a signature
+ *
+ * @param word LETTER_NONE terminated letters
+ * @param sig Signature to fill
+ * @return true if the word has a signature, false otherwise
+ */
+inline bool signatureFromLetters(const Letter* word, LetterSignature& sig) {
+    memset(&sig, 0, sizeof(LetterSignature));
+
+    for (int i = 0; word[i] != LETTER_NONE; ++i) {
+        if (i >= MAX_WORD_LENGTH || word[i] >= LETTER_COUNT) {
+            return false;   // too long, or not a letter
+        }
+
+        sig.counts[word[i]] += 1;
+    }
+
+    return true;
+}
+
+/**
+ * Compare two LETTER_NONE terminated words
+ */
+inline bool lettersEqual(const Letter* a, const Letter* b) {
+    int i = 0;
+
+    while (a[i] != LETTER_NONE && a[i] == b[i]) {
+        ++i;
+    }
+
+    return a[i] == b[i];
+}
+
+/**
+ * Check if two signatures are equal (same letters, same counts)
+ */
+inline bool signatureEquals(const LetterSignature& a, const LetterSignature& b) {
+    return ((a.lanes[0] ^ b.lanes[0]) | (a.lanes[1] ^ b.lanes[1]) |
+            (a.lanes[2] ^ b.lanes[2]) | (a.lanes[3] ^ b.lanes[3])) == 0;
+}
+
+/**
+ * Check if a word can be formed from the letters of the board
+ * Subtracts every byte of the word from the byte of the board with the high bit set:
+ * the high bit survives only if word count <= board count (counts are always < 128)
+ *
+ * @param word Signature of the word
+ * @param board Signature of the board
+ * @return true if no letter is used more times than the board has it
+ */
+inline bool signatureFits(const LetterSignature& word, const LetterSignature& board) {
+    uint64_t fits = SIGNATURE_HIGH_BITS;
+
+    for (int i = 0; i < 4; ++i) {
+        fits &= (board.lanes[i] | SIGNATURE_HIGH_BITS) - word.lanes[i];
+    }
+
+    return fits == SIGNATURE_HIGH_BITS;
+}
+
+/**
+ * Hash a signature (multiply-xorshift over the four lanes)
+ */
+inline uint64_t signatureHash(const LetterSignature& sig) {
+    uint64_t h = 0x9E3779B97F4A7C15ULL;
+
+    for (int i = 0; i < 4; ++i) {
+        h = (h ^ sig.lanes[i]) * 0xBF58476D1CE4E5B9ULL;
+        h ^= h >> 31;
+    }
+
+    return h;
+}
+
+/**
+ * Letter histogram of the board
+ * Kept up to date by the game thread as letters are placed and cleared,
+ * so guesses never have to recount state->array
+ */
+struct BoardHistogram {
+    LetterSignature sig;
+
+    BoardHistogram() { clear(); }
+
+    /**
+     * Forget every letter (board was cleared)
+     */
+    void clear() {
+        memset(&sig, 0, sizeof(LetterSignature));
+    }
+
+    /**
+     * Account for a letter written over a board position
+     *
+     * @param previous Letter that was in the position (LETTER_NONE if empty)
+     * @param letter New letter in the position
+     */
+    void place(Letter previous, Letter letter) {
+        if (previous < LETTER_COUNT) {
+            sig.counts[previous] -= 1;
+        }
+
+        if (letter < LETTER_COUNT) {
+            sig.counts[letter] += 1;
+        }
+    }
+};
+
+/*
+    The embedded words are text (lowercase, null terminated) while guesses are letter codes;
+    the embedded dictionary functions take either, hashing letter codes in both cases
+*/
+constexpr uint32_t embeddedCode(TCHAR c) { return (uint32_t)(c - L'a'); }
+constexpr uint32_t embeddedCode(Letter c) { return c; }
+constexpr bool embeddedEnd(TCHAR c) { return c == TEXT('\0'); }
+constexpr bool embeddedEnd(Letter c) { return c == LETTER_NONE; }
+
+/**
+ * Seeded FNV-1a hash of the letter codes of a word (same function as gen_embedded_dictionary.py)
+ *
+ * @param seed Bucket seed, 0 to find the bucket
+ * @param word Null terminated text or LETTER_NONE terminated letters
+ * @return 32 bit hash
+ */
+template <typename C>
+constexpr uint32_t embeddedHash(uint32_t seed, const C* word) {
+    uint32_t h = seed != 0 ? seed : 0x811C9DC5u;
+
+    for (int i = 0; !embeddedEnd(word[i]); ++i) {
+        h = (h ^ embeddedCode(word[i])) * 0x01000193u;
+    }
+
+    return h;
+}
+
+/**
+ * Compare an embedded word with a word at compile time
+ */
+template <typename C>
+constexpr bool embeddedEquals(const TCHAR* a, const C* b) {
+    int i = 0;
+
+    while (!embeddedEnd(a[i]) && !embeddedEnd(b[i]) && embeddedCode(a[i]) == embeddedCode(b[i])) {
+        ++i;
+    }
+
+    return embeddedEnd(a[i]) && embeddedEnd(b[i]);
+}
+
+/**
+ * Find a word in the dictionary built into the server (EmbeddedDictionary.h)
+ * Minimal perfect hash: the bucket's seed (or direct slot) gives the only slot the word
+ * can be in, so membership is at most two hashes and one compare
+ *
+ * @param word Null terminated lowercase text or LETTER_NONE terminated letters
+ * @return Word number (same order as the compiled image), -1 if not in the embedded dictionary
+ */
+template <typename C>
+constexpr int64_t embeddedFind(const C* word) {
+    if (EMBEDDED_WORDS == 0) {
+        return -1;
+    }
+
+    int32_t seed = embedded_seeds[embeddedHash(0, word) % EMBEDDED_WORDS];
+    uint32_t slot = seed < 0 ? (uint32_t)(-seed - 1) : embeddedHash((uint32_t)seed, word) % EMBEDDED_WORDS;
+
+    return embeddedEquals(embedded_words[embedded_slots[slot]], word) ? embedded_slots[slot] : -1;
+}
+
+static_assert(EMBEDDED_WORDS == 0 || embeddedFind(embedded_words[EMBEDDED_WORDS - 1]) == EMBEDDED_WORDS - 1,
+    "EmbeddedDictionary.h does not match embeddedHash, run gen_embedded_dictionary.py");
+
+/**
+ * Dictionary lookup index keyed by letter signature
+ * View over the index section of a compiled dictionary image: a flat open addressing
+ * table (linear probing, load factor <= 0.5) built offline by the dictionary compiler.
+ * Anagrams share a signature, so a probe also compares the word itself.
+ * Lookups never allocate and nothing is copied out of the image.
+ */
+class WordIndex {
+    const DictionaryHeader* image;
+    const DictionarySlot* slots;
+    uint64_t mask;
+
+    static const DictionarySlot* emptySlots() {
+        static const DictionarySlot none = { 0, 0 };
+        return &none;
+    }
+
+public:
+    WordIndex() : image(NULL), slots(emptySlots()), mask(0) {};
+
+    /**
+     * Find the slot holding word (or the empty slot where it would go)
+     *
+     * @param slots Index slots (power of two count)
+     * @param mask Slot count - 1
+     * @param word Word to look for
+     * @param hash Signature hash of word
+     * @param at Function returning the word stored for a word number
+     * @return Slot position
+     */
+    template <typename WordAt>
+    static uint64_t probe(const DictionarySlot* slots, uint64_t mask, const Letter* word, uint64_t hash, WordAt at) {
+        uint64_t i = hash & mask;
+
+        while (slots[i].word != 0) {
+            const DictionarySlot& s = slots[i];
+
+            if (s.hash == (uint32_t)hash && lettersEqual(at(s.word - 1), word)) {
+                break;
+            }
+
+            i = (i + 1) & mask;
+        }
+
+        return i;
+    }
+
+    /**
+     * Use the index of a compiled dictionary image
+     *
+     * @param d Validated image (must outlive the index)
+     */
+    void attach(const DictionaryHeader* d) {
+        image = d;
+        slots = dictionaryIndex(d);
+        mask = d->index_slots - 1;
+    }
+
+    /**
+     * Find a word in the dictionary
+     *
+     * @param word LETTER_NONE terminated letters
+     * @param sig Signature of word (see signatureFromLetters)
+     * @return Word number, -1 if the word was not indexed
+     */
+    int64_t find(const Letter* word, const LetterSignature& sig) const {
+        const DictionaryHeader* d = image;
+        return (int64_t)slots[probe(slots, mask, word, signatureHash(sig),
+            [d](uint32_t i) { return dictionaryWord(d, i); })].word - 1;
+    }
+
+    /**
+     * Get number of indexed words
+     */
+    uint32_t size() const {
+        return image == NULL ? 0 : image->words;
+    }
+};
+
+#endif
@@ -0,0 +1,380 @@
+#pragma once
+
+#ifndef _WORDLISTLOADER_H_
+#define _WORDLISTLOADER_H_
+
+#include "..\..\wordgame_common.h"
+#include <vector>
+#include <algorithm>
+
+/*
+    Word list loader: the file is mapped and cut into chunks at line boundaries. Worker threads
+    (one per processor) validate, lowercase and pack the words of each chunk into buckets by
+    their first two letters; then each bucket is gathered from all chunks, sorted and
+    deduplicated on its own. Buckets are disjoint key ranges, so the result is just the
+    buckets in order: no merge pass, and nothing is allocated per word.
+*/
+
+#define WORD_LIST_MAX_THREADS 32            // at most one worker per processor, up to this
+#define WORD_LIST_CHUNKS_PER_THREAD 4       // smaller chunks even out uneven lines
+#define WORD_LIST_MIN_CHUNK (1 << 20)       // bytes; smaller files get fewer chunks
+#define WORD_LIST_BUCKETS (1 << 10)         // two letters of 5 bits
+#define WORD_LIST_PROGRESS_STEP (1 << 22)   // bytes a worker parses between progress updates
+#define WORD_LIST_PROGRESS_MS 250           // console progress period
+
+/**
+ * Word packed into 64 bits: letter i (code + 1) in bits 5 * (MAX_WORD_LENGTH - 1 - i),
+ * unused positions 0. Keys sort in the same order as the words.
+ */
+typedef uint64_t WordKey;
+
+static_assert(5 * MAX_WORD_LENGTH <= 64, "packed words must fit 64 bits");
+
+/**
+ * Get letter i of a word key, LETTER_NONE past the end of the word
+ */
+inline Letter wordKeyLetter(WordKey key, size_t i) {
+    if (i >= MAX_WORD_LENGTH) {
+        return LETTER_NONE;
+    }
+
+    uint32_t c = (uint32_t)(key >> (5 * (MAX_WORD_LENGTH - 1 - i))) & 31;
+    return c == 0 ? LETTER_NONE : (Letter)(c - 1);
+}
+
+/**
+ * Get the number of letters of a word key
+ */
+inline size_t wordKeyLength(WordKey key) {
+    size_t len = 0;
+
+    while (wordKeyLetter(key, len) != LETTER_NONE) {
+        ++len;
+    }
+
+    return len;
+}
+
+/**
+ * Unpack a word key
+ *
+ * @param key Word key
+ * @param letters Receives the LETTER_NONE terminated letters (MAX_WORD_LENGTH + 1)
+ * @return Number of letters
+ */
+inline size_t wordKeyLetters(WordKey key, Letter* letters) {
+    size_t len = 0;
+
+    while ((letters[len] = wordKeyLetter(key, len)) != LETTER_NONE) {
+        ++len;
+    }
+
+    return len;
+}
+
+/**
+ * Pack a word
+ *
+ * @param text Word (either case)
+ * @param len Characters in text
+ * @param key Receives the key
+ * @return false if the word is empty, longer than MAX_WORD_LENGTH or has a character outside a-z/A-Z
+ */
+template <typename C>
+inline bool wordKeyFromText(const C* text, size_t len, WordKey& key) {
+    key = 0;
+
+    if (len == 0 || len > MAX_WORD_LENGTH) {
+        return false;
+    }
+
+    for (size_t i = 0; i < len; ++i) {
+        uint32_t c = (uint32_t)((text[i] | 0x20) - 'a');    // only A-Z and a-z land in a-z
+
+        if (c >= LETTER_COUNT) {
+            return false;
+        }
+
+        key |= (WordKey)(c + 1) << (5 * (MAX_WORD_LENGTH - 1 - i));
+    }
+
+    return true;
+}
+
+/**
+ * Sort and remove duplicate keys
+ */
+inline void wordKeysSortUnique(std::vector<WordKey>& keys) {
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+}
+
+/**
+ * Bucket of a key: its first two letters, so buckets are disjoint ranges in key order
+ */
+inline uint32_t wordKeyBucket(WordKey key) {
+    return (uint32_t)(key >> (5 * (MAX_WORD_LENGTH - 2)));
+}
+
+/**
+ * One chunk of the mapped word list and the words its worker found, by bucket
+ */
+struct WordListChunk {
+    const char* begin;
+    const char* end;                // begin and end are at line starts (or the end of the file)
+    std::vector<WordKey> buckets[WORD_LIST_BUCKETS];
+    uint64_t lines;
+};
+
+/**
+ * Everything the loader threads share
+ */
+struct WordListLoad {
+    std::vector<WordListChunk> chunks;
+    std::vector<WordKey> buckets[WORD_LIST_BUCKETS];    // merged buckets, sorted and without duplicates
+    volatile LONG next;             // next chunk (parse) or bucket (sort) to take
+    volatile LONG64 parsed;         // bytes parsed by all workers (progress)
+};
+
+/**
+ * Parse one chunk: validate, lowercase and pack every line into its bucket
+ */
+void parseWordListChunk(WordListChunk& chunk, volatile LONG64* parsed) {
+    const char* p = chunk.begin;
+    const char* reported = p;
+
+    while (p < chunk.end) {
+        const char* eol = (const char*)memchr(p, '\n', chunk.end - p);
+        const char* next = eol == NULL ? chunk.end : eol + 1;
+        size_t len = (eol == NULL ? chunk.end : eol) - p;
+        WordKey key;
+
+        // Same rules as the console: trailing '\r' dropped, anything else must be a letter
+        while (len > 0 && p[len - 1] == '\r') {
+            --len;
+        }
+
+        if (wordKeyFromText(p, len, key)) {
+            chunk.buckets[wordKeyBucket(key)].push_back(key);
+        }
+
+        chunk.lines += 1;
+        p = next;
+
+        if (p - reported >= WORD_LIST_PROGRESS_STEP) {
+            InterlockedExchangeAdd64(parsed, p - reported);
+            reported = p;
+        }
+    }
+
+    InterlockedExchangeAdd64(parsed, p - reported);
+}
+
+/**
+ * Worker, first pass: parse chunks until none is left
+ *
+ * @param param WordListLoad
+ */
+void* wordListParser(void* param) {
+    WordListLoad* load = (WordListLoad*)param;
+    LONG i;
+
+    while ((i = InterlockedIncrement(&load->next) - 1) < (LONG)load->chunks.size()) {
+        parseWordListChunk(load->chunks[i], &load->parsed);
+    }
+
+    return NULL;
+}
+
+/**
+ * Worker, second pass: gather each bucket from every chunk, sort it and drop duplicates
+ *
+ * @param param WordListLoad
+ */
+void* wordListSorter(void* param) {
+    WordListLoad* load = (WordListLoad*)param;
+    LONG b;
+
+    while ((b = InterlockedIncrement(&load->next) - 1) < WORD_LIST_BUCKETS) {
+        std::vector<WordKey>& bucket = load->buckets[b];
+        size_t size = 0;
+
+        for (WordListChunk& c : load->chunks) {
+            size += c.buckets[b].size();
+        }
+
+        bucket.reserve(size);
+
+        for (WordListChunk& c : load->chunks) {
+            bucket.insert(bucket.end(), c.buckets[b].begin(), c.buckets[b].end());
+            std::vector<WordKey>().swap(c.buckets[b]);
+        }
+
+        wordKeysSortUnique(bucket);
+    }
+
+    return NULL;
+}
+
+/**
+ * Run a loader pass on up to 'count' threads (the calling thread is one of them)
+ *
+ * @param proc wordListParser or wordListSorter
+ * @param load Shared state (next is reset here)
+ * @param count Number of threads
+ * @param progress Total bytes for the console progress, 0 for none
+ */
+void runWordListPass(void* (*proc)(void*), WordListLoad* load, DWORD count, LONG64 progress) {
+    HANDLE threads[WORD_LIST_MAX_THREADS];
+    DWORD started = 0;
+
+    load->next = 0;
+
+    for (; started + 1 < count; ++started) {
+        if ((threads[started] = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)proc, load, 0, NULL)) == NULL) {
+            _tprintf(TEXT("CreateThread %d\n"), GetLastError());
+            break;      // the threads that did start (and this one) do the work
+        }
+    }
+
+    proc(load);
+
+    while (started > 0 && WaitForMultipleObjects(started, threads, TRUE, WORD_LIST_PROGRESS_MS) == WAIT_TIMEOUT) {
+        if (progress > 0) {
+            _tprintf(_T("\rReading word list... %3u%%"), (uint32_t)(100 * load->parsed / progress));
+        }
+    }
+
+    for (DWORD i = 0; i < started; ++i) {
+        CloseHandle(threads[i]);
+    }
+}
+
+/**
+ * Read a word list (one word per line)
+ * Words are lowercased; empty lines, words longer than MAX_WORD_LENGTH
+ * and words with characters outside a-z are skipped
+ *
+ * @param path Text file to read
+ * @param keys Receives the words, sorted and without duplicates
+ * @return true if the file could be read, false otherwise
+ */
+bool readWordList(const TCHAR* path, std::vector<WordKey>& keys) {
+    LARGE_INTEGER size = { 0 }, start, stop, frequency;
+    SYSTEM_INFO sysInfo;
+    uint64_t lines = 0;
+    size_t words = 0;
+
+    QueryPerformanceCounter(&start);
+    keys.clear();
+
+    HANDLE file = CreateFile(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+    if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &size)) {
+        _tprintf(_T("Error: Could not open '%s' file\n"), path);
+
+        if (file != INVALID_HANDLE_VALUE) {
+            CloseHandle(file);
+        }
+        return false;
+    }
+
+    if (size.QuadPart == 0) {
+        CloseHandle(file);      // nothing to map
+        return true;
+    }
+
+    HANDLE mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    const char* text = mapping == NULL ? NULL : (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+    if (text == NULL) {
+        std::cout << "MapViewOfFile " << GetLastError() << std::endl;
+
+        if (mapping != NULL) {
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+        return false;
+    }
+
+    // One thread per processor, but no chunk smaller than WORD_LIST_MIN_CHUNK
+    GetSystemInfo(&sysInfo);
+    DWORD threads = std::min<DWORD>(sysInfo.dwNumberOfProcessors, WORD_LIST_MAX_THREADS);
+    uint64_t count = std::min<uint64_t>(size.QuadPart / WORD_LIST_MIN_CHUNK + 1, WORD_LIST_CHUNKS_PER_THREAD * threads);
+
+    WordListLoad* load = new WordListLoad();
+    const char* end = text + size.QuadPart;
+    const char* at = text;
+
+    load->chunks.resize(count);
+    load->parsed = 0;
+
+    for (uint64_t i = 0; i < count; ++i) {
+        const char* cut = std::max(at, text + size.QuadPart * (i + 1) / count);
+
+        // move the cut past the end of its line
+        if (cut < end) {
+            const char* eol = (const char*)memchr(cut, '\n', end - cut);
+            cut = eol == NULL ? end : eol + 1;
+        }
+
+        load->chunks[i].begin = at;
+        load->chunks[i].end = cut;
+        load->chunks[i].lines = 0;
+        at = cut;
+    }
+
+    runWordListPass(wordListParser, load, std::min<DWORD>(threads, (DWORD)count), size.QuadPart);
+    runWordListPass(wordListSorter, load, threads, 0);
+
+    UnmapViewOfFile(text);
+    CloseHandle(mapping);
+    CloseHandle(file);
+
+    // Buckets are consecutive key ranges: concatenated in order they are sorted
+    for (const WordListChunk& c : load->chunks) {
+        lines += c.lines;
+    }
+
+    for (const std::vector<WordKey>& b : load->buckets) {
+        words += b.size();
+    }
+
+    keys.reserve(words);
+
+    for (const std::vector<WordKey>& b : load->buckets) {
+        keys.insert(keys.end(), b.begin(), b.end());
+    }
+
+    delete load;
+
+    QueryPerformanceCounter(&stop);
+    QueryPerformanceFrequency(&frequency);
+    _tprintf(_T("\rRead %u words (%llu lines, %llu bytes) in %.1f ms with %u threads\n"),
+        (uint32_t)keys.size(), lines, (uint64_t)size.QuadPart,
+        1000.0 * (stop.QuadPart - start.QuadPart) / frequency.QuadPart, threads);
+    return true;
+}
+
+/**
+ * Pack words that are already text (the built-in dictionary)
+ *
+ * @param words Words
+ * @param count Number of words
+ * @param keys Receives the valid words, sorted and without duplicates
+ */
+void wordKeysFromList(const TCHAR* const* words, size_t count, std::vector<WordKey>& keys) {
+    keys.clear();
+
+    for (size_t i = 0; i < count; ++i) {
+        WordKey key;
+
+        if (wordKeyFromText(words[i], _tcslen(words[i]), key)) {
+            keys.push_back(key);
+        }
+    }
+
+    wordKeysSortUnique(keys);
+}
+
+#endif
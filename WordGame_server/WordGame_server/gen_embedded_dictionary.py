@@ -0,0 +1,152 @@
+"""
+    Generates EmbeddedDictionary.h from words.txt (pre-build step of WordGame_server)
+
+    The header holds the word list as a constexpr table plus a minimal perfect hash
+    (hash and displace): every word maps to its own slot in [0, n) with one or two
+    hashes, so membership is one hash and one compare with no runtime loading.
+
+    usage: python gen_embedded_dictionary.py words.txt EmbeddedDictionary.h
+"""
+
+import os
+import sys
+
+MAX_WORD_LENGTH = 12    # must match wordgame_common.h
+FNV_OFFSET = 0x811C9DC5
+FNV_PRIME = 0x01000193
+
+
+def embedded_hash(seed: int, word: str) -> int:
+    """
+        FNV-1a over letter codes (a = 0), seeded; must match embeddedHash() in the header
+    """
+    h = seed if seed != 0 else FNV_OFFSET
+
+    for c in word:
+        h = ((h ^ (ord(c) - ord("a"))) * FNV_PRIME) & 0xFFFFFFFF
+
+    return h
+
+
+def read_words(path: str) -> list:
+    """
+        Same rules as readWordList(): lowercase, a-z only, at most MAX_WORD_LENGTH, sorted, unique
+    """
+    words = set()
+
+    with open(path, "r", encoding="latin-1") as f:
+        for line in f:
+            word = line.strip("\r\n").lower()
+
+            if 0 < len(word) <= MAX_WORD_LENGTH and all("a" <= c <= "z" for c in word):
+                words.add(word)
+
+    return sorted(words)
+
+
+def perfect_hash(words: list):
+    """
+        Hash and displace: place the largest buckets first, searching a seed per bucket
+        that sends all of its words to free slots. Single word buckets go straight to a
+        free slot, stored as -(slot + 1).
+    """
+    n = len(words)
+    buckets = [[] for _ in range(n)]
+
+    for i, w in enumerate(words):
+        buckets[embedded_hash(0, w) % n].append(i)
+
+    seeds = [0] * n
+    slots = [-1] * n
+    order = sorted(range(n), key=lambda b: -len(buckets[b]))
+    b = 0
+
+    while b < n and len(buckets[order[b]]) > 1:
+        bucket = buckets[order[b]]
+        seed = 1
+
+        while True:
+            taken = set()
+
+            for i in bucket:
+                s = embedded_hash(seed, words[i]) % n
+
+                if slots[s] != -1 or s in taken:
+                    break
+
+                taken.add(s)
+            else:
+                break
+
+            seed += 1
+
+        for i in bucket:
+            slots[embedded_hash(seed, words[i]) % n] = i
+
+        seeds[order[b]] = seed
+        b += 1
+
+    free = [s for s in range(n) if slots[s] == -1]
+
+    while b < n and len(buckets[order[b]]) == 1:
+        s = free.pop()
+        slots[s] = buckets[order[b]][0]
+        seeds[order[b]] = -(s + 1)
+        b += 1
+
+    return seeds, slots
+
+
+def generate(words: list) -> str:
+    seeds, slots = perfect_hash(words)
+    out = []
+
+    out.append("#pragma once")
+    out.append("")
+    out.append("#ifndef _EMBEDDEDDICTIONARY_H_")
+    out.append("#define _EMBEDDEDDICTIONARY_H_")
+    out.append("")
+    out.append("/* Generated by gen_embedded_dictionary.py from words.txt, do not edit */")
+    out.append("")
+    out.append('#include "..\\..\\wordgame_common.h"')
+    out.append("")
+    out.append("#define EMBEDDED_WORDS %d" % len(words))
+    out.append("")
+    out.append("// Sorted words")
+    out.append("constexpr const TCHAR* embedded_words[EMBEDDED_WORDS > 0 ? EMBEDDED_WORDS : 1] = {")
+    out.extend('    L"%s",' % w for w in words or [""])
+    out.append("};")
+    out.append("")
+    out.append("// Seed per bucket (bucket = hash(0, word) % EMBEDDED_WORDS), or -(slot + 1) for single word buckets")
+    out.append("constexpr int32_t embedded_seeds[EMBEDDED_WORDS > 0 ? EMBEDDED_WORDS : 1] = {")
+    out.extend("    %d," % s for s in seeds or [0])
+    out.append("};")
+    out.append("")
+    out.append("// Word number held by each slot")
+    out.append("constexpr uint32_t embedded_slots[EMBEDDED_WORDS > 0 ? EMBEDDED_WORDS : 1] = {")
+    out.extend("    %d," % s for s in slots or [0])
+    out.append("};")
+    out.append("")
+    out.append("#endif")
+    return "\n".join(out) + "\n"
+
+
+def main():
+    if len(sys.argv) != 3:
+        print(__doc__)
+        sys.exit(1)
+
+    text = generate(read_words(sys.argv[1]))
+
+    # Only touch the header when the words changed, so the server is not rebuilt for nothing
+    if os.path.exists(sys.argv[2]):
+        with open(sys.argv[2], "r") as f:
+            if f.read() == text:
+                return
+
+    with open(sys.argv[2], "w", newline="\n") as f:
+        f.write(text)
+
+
+if __name__ == "__main__":
+    main()
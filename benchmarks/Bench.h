@@ -0,0 +1,143 @@
+#pragma once
+
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include "..\wordgame_common.h"
+#undef DEBUG    // the server headers log every operation under DEBUG
+
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <cstdio>
+
+/*
+    Shared helpers of the benchmarks
+    Each benchmark is a console program built from one .cpp (a project of WordGame_server.sln,
+    settings in Benchmark.props) that includes the server headers it measures and, where the
+    change replaced a structure, a copy of the old one to compare against. Times are wall clock
+    from QueryPerformanceCounter; only those of a Release|x64 build run on the target machine
+    are worth quoting.
+*/
+
+/**
+ * Current time in nanoseconds
+ */
+inline double nowNs() {
+    static double scale = 0;
+    LARGE_INTEGER t;
+
+    if (scale == 0) {
+        QueryPerformanceFrequency(&t);
+        scale = 1e9 / (double)t.QuadPart;
+    }
+
+    QueryPerformanceCounter(&t);
+    return (double)t.QuadPart * scale;
+}
+
+/**
+ * Time a loop of n operations
+ *
+ * @param n Number of operations fn performs
+ * @param fn Runs the operations
+ * @return Nanoseconds per operation (best of three runs)
+ */
+template <class F>
+double nsPerOp(size_t n, F fn) {
+    double best = 1e300;
+
+    for (int run = 0; run < 3; ++run) {
+        double start = nowNs();
+        fn();
+        best = (std::min)(best, (nowNs() - start) / (double)n);
+    }
+
+    return best;
+}
+
+/**
+ * Latency samples with percentiles
+ */
+class Samples {
+    std::vector<double> v;
+    bool sorted = true;
+
+public:
+    void add(double x) {
+        v.push_back(x);
+        sorted = false;
+    }
+
+    void merge(const Samples& other) {
+        v.insert(v.end(), other.v.begin(), other.v.end());
+        sorted = false;
+    }
+
+    size_t size() const { return v.size(); }
+
+    double percentile(double p) {
+        if (v.empty()) {
+            return 0;
+        }
+
+        if (!sorted) {
+            std::sort(v.begin(), v.end());
+            sorted = true;
+        }
+
+        size_t i = (size_t)(p / 100.0 * (double)(v.size() - 1) + 0.5);
+        return v[i];
+    }
+
+    double mean() const {
+        double sum = 0;
+
+        for (double x : v) {
+            sum += x;
+        }
+
+        return v.empty() ? 0 : sum / (double)v.size();
+    }
+
+    /**
+     * Print mean, p50, p99 and max, scaled to the given unit
+     *
+     * @param label Row label
+     * @param unit Nanoseconds per printed unit (1000 for us)
+     */
+    void print(const char* label, double unit = 1000) {
+        printf("%-34s avg %9.2f  p50 %9.2f  p99 %9.2f  max %9.2f\n", label,
+            mean() / unit, percentile(50) / unit, percentile(99) / unit, percentile(100) / unit);
+    }
+};
+
+/**
+ * Busy wait, to stand for work that keeps the CPU (a broadcast, parsing a request)
+ *
+ * @param ns Nanoseconds to spin
+ */
+inline void spinNs(double ns) {
+    double end = nowNs() + ns;
+
+    while (nowNs() < end) {
+        YieldProcessor();
+    }
+}
+
+/**
+ * Random letter codes, LETTER_NONE terminated
+ *
+ * @param rng Generator
+ * @param word Receives the letters (len + 1 bytes)
+ * @param len Number of letters
+ */
+inline void randomLetters(std::mt19937& rng, Letter* word, int len) {
+    for (int i = 0; i < len; ++i) {
+        word[i] = (Letter)(rng() % LETTER_COUNT);
+    }
+
+    word[len] = LETTER_NONE;
+}
+
+#endif
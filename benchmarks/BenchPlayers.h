@@ -0,0 +1,90 @@
+#pragma once
+
+#ifndef _BENCHPLAYERS_H_
+#define _BENCHPLAYERS_H_
+
+#include "Bench.h"
+#include "..\WordGame_server\WordGame_server\GameData.h"
+
+/*
+    Players for the GameData benchmarks
+    GameData::insert only accepts a player whose client pipe exists, so every benchmark
+    player gets a pipe instance named after it. Nobody connects to these instances.
+*/
+
+/**
+ * Name of benchmark player i
+ *
+ * @param name Receives the name (NAME_SIZE characters)
+ */
+inline void benchPlayerName(uint32_t i, TCHAR* name) {
+    _stprintf_s(name, NAME_SIZE, TEXT("b%u"), i);
+}
+
+/**
+ * Client pipes of the benchmark players
+ */
+class BenchPipes {
+    std::vector<HANDLE> pipes;
+
+public:
+    /**
+     * Create the pipes of players 0 .. n - 1
+     *
+     * @return false if a pipe cannot be created
+     */
+    bool create(uint32_t n) {
+        TCHAR name[NAME_SIZE], path[2 * ARRAY_SIZE + 2];
+
+        for (uint32_t i = (uint32_t)pipes.size(); i < n; ++i) {
+            benchPlayerName(i, name);
+            _stprintf_s(path, TEXT("%s%s"), TEXT("\\\\.\\pipe\\"), name);
+
+            HANDLE h = CreateNamedPipe(path, PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED, PIPE_TYPE_BYTE | PIPE_WAIT,
+                PIPE_UNLIMITED_INSTANCES, sizeof(Packet) * 64, sizeof(Packet) * 64, 0, NULL);
+
+            if (h == INVALID_HANDLE_VALUE) {
+                _tprintf(TEXT("CreateNamedPipe %s %d\n"), path, GetLastError());
+                return false;
+            }
+
+            pipes.push_back(h);
+        }
+
+        return true;
+    }
+
+    ~BenchPipes() {
+        for (HANDLE h : pipes) {
+            CloseHandle(h);
+        }
+    }
+};
+
+/**
+ * Log in players 0 .. n - 1
+ *
+ * @param data Store to fill
+ * @param ids Receives the player IDs
+ * @return false if a login fails
+ */
+inline bool benchLogin(GameData& data, uint32_t n, std::vector<int32_t>& ids) {
+    TCHAR name[NAME_SIZE];
+    ids.clear();
+
+    for (uint32_t i = 0; i < n; ++i) {
+        benchPlayerName(i, name);
+        Login_Return_Type r = data.insert(name);
+
+        if (r.flag != LOGIN) {
+            printf("login of player %u failed (%d)\n", i, r.flag);
+            return false;
+        }
+
+        ids.push_back(r.id);
+    }
+
+    return true;
+}
+
+#endif
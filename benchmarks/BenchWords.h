@@ -0,0 +1,107 @@
+#pragma once
+
+#ifndef _BENCHWORDS_H_
+#define _BENCHWORDS_H_
+
+#include "Bench.h"
+#include "..\WordGame_server\WordGame_server\WordListLoader.h"
+#include "..\WordGame_server\WordGame_server\DictionaryCompiler.h"
+
+/*
+    Word lists and boards for the dictionary benchmarks
+    The server's own list is small, so the benchmarks also build a dense random list: words
+    drawn mostly from eight letters, which makes boards that form thousands of words.
+*/
+
+#define BENCH_WORDS_FILE TEXT("..\\WordGame_server\\WordGame_server\\words.txt")
+
+/**
+ * Letter drawn like the dense list draws them (7 in 10 from the first eight letters)
+ */
+inline Letter denseLetter(std::mt19937& rng) {
+    return (Letter)(rng() % 10 < 7 ? rng() % 8 : rng() % LETTER_COUNT);
+}
+
+/**
+ * Build a dense random word list
+ *
+ * @param rng Generator
+ * @param count Words to draw (duplicates are dropped)
+ * @param keys Receives the words, sorted
+ */
+inline void denseWordList(std::mt19937& rng, size_t count, std::vector<WordKey>& keys) {
+    TCHAR text[MAX_WORD_LENGTH + 1];
+    keys.clear();
+
+    for (size_t i = 0; i < count; ++i) {
+        int len = 2 + rng() % 9;
+        WordKey key;
+
+        for (int j = 0; j < len; ++j) {
+            text[j] = (TCHAR)(TEXT('a') + denseLetter(rng));
+        }
+
+        if (wordKeyFromText(text, len, key)) {
+            keys.push_back(key);
+        }
+    }
+
+    wordKeysSortUnique(keys);
+}
+
+/**
+ * Read the server's word list (or the one named on the command line)
+ *
+ * @return false if the file cannot be read
+ */
+inline bool benchWordList(int argc, TCHAR* argv[], std::vector<WordKey>& keys) {
+    const TCHAR* path = argc > 1 ? argv[1] : BENCH_WORDS_FILE;
+
+    if (!readWordList(path, keys)) {
+        _tprintf(TEXT("cannot read %s\n"), path);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Draw a board
+ *
+ * @param rng Generator
+ * @param letters Number of letters on the board
+ * @param dense Draw like the dense list, else uniformly
+ * @return Letter signature of the board
+ */
+inline LetterSignature randomBoard(std::mt19937& rng, int letters, bool dense) {
+    BoardHistogram h;
+
+    for (int i = 0; i < letters; ++i) {
+        h.place(LETTER_NONE, dense ? denseLetter(rng) : (Letter)(rng() % LETTER_COUNT));
+    }
+
+    return h.sig;
+}
+
+/**
+ * Compile a word list into a dictionary image
+ *
+ * @param ms Receives the compile time in milliseconds
+ * @return Image header, NULL if the list does not compile
+ */
+inline const DictionaryHeader* benchCompile(const std::vector<WordKey>& keys, std::vector<uint8_t>& image, double* ms = NULL) {
+    double start = nowNs();
+
+    if (!compileDictionary(keys, image)) {
+        printf("the word list does not compile\n");
+        return NULL;
+    }
+
+    if (ms != NULL) {
+        *ms = (nowNs() - start) / 1e6;
+    }
+
+    return (const DictionaryHeader*)image.data();
+}
+
+#endif
@@ -0,0 +1,207 @@
+/*
+    Board change log check
+    Checks gameStateUpdate against boards written as the server writes them (seqlock, log
+    entry; the epoch moved by the guess that solves the board, the next tick clearing it):
+    - 1,000,000 updates of a client copy after random numbers of ticks (sometimes more than
+      the log holds) and random solves: the copy must equal the shared board, and its epoch
+      must be stale exactly when a board was solved after it was taken (what handleGuess
+      rejects)
+    - a writer thread ticking and solving while a reader updates its copy: every copy must
+      be the board the writer recorded for the copy's tick, with its epoch or the next
+    Then times a whole copy against one tick applied from the log.
+*/
+
+#include "Bench.h"
+
+#define READS 1000000
+#define POSITIONS 12            // positions in play, as the server's default
+#define CONCURRENT_TICKS 2000000
+#define HISTORY 65536           // boards the writer records for the concurrent reader
+#define TIMED 10000000
+
+struct Board {
+    Letter array[BOARD_SIZE];
+    uint32_t epoch;             // when the tick was written (a solve may move it before the next)
+};
+
+static GameState state;
+static Board history[HISTORY];  // board of tick n in history[n % HISTORY]
+static volatile int64_t sink;
+static int failures = 0;
+
+static void check(bool ok, const char* what, size_t i) {
+    if (!ok && failures++ < 10) {
+        printf("failed: %s (%zu)\n", what, i);
+    }
+}
+
+static void resetState() {
+    memset(&state, 0, sizeof(GameState));
+    memset(state.array, LETTER_NONE, sizeof(state.array));
+    state.t = POSITIONS;
+    state.epoch = 1;
+}
+
+/**
+ * The epoch move of handleGuess when a guess solves the board
+ */
+static void solveBoard() {
+    InterlockedIncrement(&state.sequence);
+    state.epoch += 1;
+    InterlockedIncrement(&state.sequence);
+}
+
+/**
+ * One tick as game() writes it, recorded in the history before it is published
+ */
+static void writeTick(uint32_t i, Letter letter, bool cleared) {
+    uint32_t tick = state.tick + 1;
+    Board& h = history[tick % HISTORY];
+
+    memcpy(h.array, state.array, sizeof(h.array));
+    h.epoch = state.epoch;
+
+    if (cleared) {
+        memset(h.array, LETTER_NONE, sizeof(h.array));
+    }
+
+    h.array[i] = letter;
+
+    InterlockedIncrement(&state.sequence);
+
+    if (cleared) {
+        memset(state.array, LETTER_NONE, sizeof(state.array));
+    }
+
+    state.array[i] = letter;
+    state.tick = tick;
+
+    BoardDelta& change = state.log[tick % BOARD_LOG_SIZE];
+    change.tick = tick;
+    change.position = (uint8_t)i;
+    change.letter = letter;
+    change.flags = cleared ? BOARD_CLEARED : 0;
+    InterlockedIncrement(&state.sequence);
+}
+
+static void checkUpdates() {
+    std::mt19937 rng(25);
+    GameState board = { 0 };
+    uint64_t copies = 0, applied = 0, stale = 0;
+    uint32_t position = 0;
+    bool solved = false;
+
+    resetState();
+
+    for (size_t k = 0; k < READS; ++k) {
+        // Mostly a few ticks behind, every hundredth read more than the log holds
+        uint32_t ticks = rng() % (k % 100 == 0 ? 40 : 4);
+        bool solvedSince = false;
+
+        for (uint32_t j = 0; j < ticks; ++j) {
+            writeTick(position, (Letter)(rng() % LETTER_COUNT), solved);
+            position = (position + 1) % POSITIONS;
+            solved = false;
+
+            if (rng() % 8 == 0) {
+                solveBoard();   // the next tick clears it
+                solved = solvedSince = true;
+            }
+        }
+
+        // A guess made against the copy is stale exactly when a board was solved since
+        if (board.epoch != 0) {
+            check((board.epoch != state.epoch) == solvedSince, "stale epoch", k);
+            stale += board.epoch != state.epoch;
+        }
+
+        int changes = gameStateUpdate(&state, board);
+
+        if (changes < 0) {
+            copies += 1;
+        }
+        else {
+            applied += changes;
+        }
+
+        check(memcmp(board.array, state.array, sizeof(board.array)) == 0 && board.tick == state.tick &&
+            board.epoch == state.epoch && board.t == state.t, "copy matches the board", k);
+    }
+
+    printf("%d updates: %llu changes applied, %llu whole copies, %llu copies stale\n", READS,
+        (unsigned long long)applied, (unsigned long long)copies, (unsigned long long)stale);
+}
+
+void* writerThreadProc(void*) {
+    std::mt19937 rng(250);
+    bool solved = false;
+
+    for (uint32_t k = 0; k < CONCURRENT_TICKS; ++k) {
+        writeTick(k % POSITIONS, (Letter)(rng() % LETTER_COUNT), solved);
+        solved = rng() % 8 == 0;
+
+        if (solved) {
+            solveBoard();
+        }
+    }
+
+    return NULL;
+}
+
+static void checkConcurrent() {
+    GameState board = { 0 };
+    uint64_t reads = 0, copies = 0, skipped = 0;
+
+    resetState();
+
+    HANDLE writer = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)writerThreadProc, NULL, 0, NULL);
+
+    while (WaitForSingleObject(writer, 0) == WAIT_TIMEOUT) {
+        copies += gameStateUpdate(&state, board) < 0;
+        reads += 1;
+
+        const Board& h = history[board.tick % HISTORY];
+        bool same = memcmp(board.array, h.array, sizeof(h.array)) == 0 && (board.epoch == h.epoch || board.epoch == h.epoch + 1);
+
+        // Only if the writer cannot have recorded over this tick meanwhile (the reader held up that long)
+        if (state.tick - board.tick >= HISTORY - 1) {
+            skipped += 1;
+            continue;
+        }
+
+        check(board.tick == 0 || same, "concurrent copy matches its tick", (size_t)reads);
+    }
+
+    CloseHandle(writer);
+    printf("%u ticks written while reading: %llu updates, %llu whole copies, %llu not checked\n", CONCURRENT_TICKS,
+        (unsigned long long)reads, (unsigned long long)copies, (unsigned long long)skipped);
+}
+
+int _tmain(int, TCHAR*[]) {
+    checkUpdates();
+    checkConcurrent();
+
+    // Whole copy against one tick applied from the log
+    GameState board = { 0 };
+    resetState();
+
+    double whole = nsPerOp(TIMED, [&] {
+        for (int k = 0; k < TIMED; ++k) {
+            gameStateRead(&state, board);
+            sink += board.tick;
+        }
+    });
+
+    gameStateUpdate(&state, board);
+
+    double update = nsPerOp(TIMED, [&] {
+        for (int k = 0; k < TIMED; ++k) {
+            writeTick(k % POSITIONS, (Letter)(k % LETTER_COUNT), false);
+            sink += gameStateUpdate(&state, board);
+        }
+    });
+
+    printf("GameState %zu bytes: whole copy %.1f ns, one tick written and applied %.1f ns\n", sizeof(GameState), whole, update);
+    printf("%s\n", failures == 0 ? "ok" : "FAILED");
+    return failures != 0;
+}
@@ -0,0 +1,162 @@
+/*
+    Board seqlock benchmark
+    1000 reader threads wake on every tick, as the clients' update threads do, and copy the
+    board. Times the tick write of game() (board, tick and log entry) over 200 ticks:
+    - before the change: under the state mutex, which the readers take to copy the board
+    - now: through the seqlock, the readers copying with gameStateRead
+    each with and without one reader that stalls for 50 ms on every tenth tick (holding the
+    mutex before the change). Every copy is checked: its log entry for its tick must be the
+    letter on its board, so a torn copy is caught.
+    Usage: BoardSeqlockBench [readers]
+*/
+
+#include "Bench.h"
+
+#define TICKS 200
+#define POSITIONS 12            // positions in play, as the server's default
+#define TICK_INTERVAL 5         // ms between ticks
+#define STALL 50                // ms the stalling reader takes on every tenth tick
+
+static GameState state;
+static HANDLE signals[2];
+static HANDLE state_mutex;
+static volatile LONG quitting = 0;
+static volatile LONG torn = 0;
+static volatile LONG copies = 0;
+static int failures = 0;
+static bool seqlock;
+static bool stalling;
+
+void* readerThreadProc(void* param) {
+    bool stalls = stalling && param != NULL;
+    uint32_t seen = 0;
+    GameState board;
+
+    while (!quitting) {
+        if (WaitForSingleObject(signals[(seen + 1) & 1], 100) == WAIT_TIMEOUT) {
+            continue;
+        }
+
+        if (seqlock) {
+            gameStateRead(&state, board);
+
+            if (stalls && board.tick % 10 == 0) {
+                Sleep(STALL);
+            }
+        }
+        else {
+            WaitForSingleObject(state_mutex, INFINITE);
+            memcpy(&board, &state, sizeof(GameState));
+
+            if (stalls && board.tick % 10 == 0) {
+                Sleep(STALL);
+            }
+
+            ReleaseMutex(state_mutex);
+        }
+
+        const BoardDelta& change = board.log[board.tick % BOARD_LOG_SIZE];
+
+        if (board.tick != 0 && (change.tick != board.tick || board.array[change.position] != change.letter)) {
+            InterlockedIncrement(&torn);
+        }
+
+        InterlockedIncrement(&copies);
+        seen = board.tick;
+    }
+
+    return NULL;
+}
+
+/**
+ * One tick as game() writes it, rearming the event the next tick sets
+ */
+static void writeTick(uint32_t i, Letter letter) {
+    uint32_t tick = state.tick + 1;
+    ResetEvent(signals[(tick + 1) & 1]);
+
+    if (seqlock) {
+        InterlockedIncrement(&state.sequence);
+    }
+    else {
+        WaitForSingleObject(state_mutex, INFINITE);
+    }
+
+    state.array[i] = letter;
+    state.tick = tick;
+
+    BoardDelta& change = state.log[tick % BOARD_LOG_SIZE];
+    change.tick = tick;
+    change.position = (uint8_t)i;
+    change.letter = letter;
+    change.flags = 0;
+
+    if (seqlock) {
+        InterlockedIncrement(&state.sequence);
+    }
+    else {
+        ReleaseMutex(state_mutex);
+    }
+}
+
+static void run(uint32_t readers, bool useSeqlock, bool withStall) {
+    std::vector<HANDLE> threads(readers);
+    Samples write;
+    std::mt19937 rng(24);
+
+    seqlock = useSeqlock;
+    stalling = withStall;
+    quitting = 0;
+    torn = 0;
+    copies = 0;
+    memset(&state, 0, sizeof(GameState));
+    memset(state.array, LETTER_NONE, sizeof(state.array));
+    state.t = POSITIONS;
+    state.epoch = 1;
+    ResetEvent(signals[0]);
+    ResetEvent(signals[1]);
+
+    for (uint32_t i = 0; i < readers; ++i) {
+        // the first reader is the one that stalls
+        threads[i] = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)readerThreadProc, i == 0 ? &state : NULL, 0, NULL);
+    }
+
+    Sleep(300);     // every reader is waiting
+
+    for (uint32_t k = 0; k < TICKS; ++k) {
+        double start = nowNs();
+        writeTick(k % POSITIONS, (Letter)(rng() % LETTER_COUNT));
+        write.add(nowNs() - start);
+
+        SetEvent(signals[state.tick & 1]);
+        Sleep(TICK_INTERVAL);
+    }
+
+    InterlockedExchange(&quitting, 1);
+
+    for (HANDLE t : threads) {
+        WaitForSingleObject(t, INFINITE);
+        CloseHandle(t);
+    }
+
+    printf("%u readers, %s%s: %ld copies, %ld torn\n", readers, useSeqlock ? "seqlock" : "state mutex",
+        withStall ? ", one reader stalling" : "", copies, torn);
+    write.print("  tick write (us)");
+    failures += torn != 0;
+}
+
+int _tmain(int argc, TCHAR* argv[]) {
+    uint32_t readers = argc > 1 ? (uint32_t)_tcstoul(argv[1], NULL, 10) : 1000;
+
+    signals[0] = CreateEvent(NULL, TRUE, FALSE, NULL);
+    signals[1] = CreateEvent(NULL, TRUE, FALSE, NULL);
+    state_mutex = CreateMutex(NULL, FALSE, NULL);
+
+    run(readers, false, false);
+    run(readers, false, true);
+    run(readers, true, false);
+    run(readers, true, true);
+
+    printf("%s\n", failures == 0 ? "ok" : "FAILED");
+    return failures != 0;
+}
@@ -0,0 +1,254 @@
+/*
+    Broadcaster benchmark
+    20 and 1000 live clients plus one stalled client that connects and never reads, each a
+    thread serving its own named pipe. Every round sends each player a packet of its own
+    (as the exit orders are; events for every player go to the shared event ring, see
+    EventRingBench) and waits until every live client has its packet:
+    - through the Broadcaster: how long the sends take to return and the delivery delay
+      of the live clients
+    - as before the change, writing to each client from send(): the rounds it gets
+      through before the stalled client's buffer is full and it blocks for good
+    Usage: BroadcasterBench [rounds at 20 clients]
+*/
+
+#include "BenchPlayers.h"
+#include "..\WordGame_server\WordGame_server\Broadcaster.h"
+
+#define ROUND_TIMEOUT 5000      // ms a round may take before the sends count as blocked
+
+struct BenchClient {
+    TCHAR name[NAME_SIZE];
+    HANDLE pipe;
+    HANDLE thread;
+    bool stalled;               // connects and never reads
+};
+
+static volatile LONG received = 0;
+static volatile LONG expected = 0;
+static volatile LONG stopping = 0;
+static HANDLE all_received;
+static HANDLE release_stalled;
+
+void* clientThreadProc(void* param) {
+    BenchClient* c = (BenchClient*)param;
+
+    while (ConnectNamedPipe(c->pipe, NULL) || GetLastError() == ERROR_PIPE_CONNECTED) {
+        Packet p;
+        DWORD n = 0;
+
+        if (c->stalled) {
+            WaitForSingleObject(release_stalled, INFINITE);
+            DisconnectNamedPipe(c->pipe);
+            return NULL;
+        }
+
+        while (ReadFile(c->pipe, &p, sizeof(Packet), &n, NULL) && n == sizeof(Packet)) {
+            if (InterlockedIncrement(&received) == expected) {
+                SetEvent(all_received);
+            }
+        }
+
+        DisconnectNamedPipe(c->pipe);
+
+        if (stopping) {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Clients and their players: n live ones, then the stalled one
+ */
+struct BenchGame {
+    std::vector<BenchClient> clients;
+    std::vector<int32_t> ids;
+    GameData data;
+
+    BenchGame(uint32_t n) : clients(n + 1), data(n + 1) {
+        stopping = 0;
+        ResetEvent(release_stalled);
+
+        for (uint32_t i = 0; i <= n; ++i) {
+            BenchClient& c = clients[i];
+            TCHAR path[2 * ARRAY_SIZE + 2];
+
+            benchPlayerName(i, c.name);
+            _stprintf_s(path, TEXT("%s%s"), TEXT("\\\\.\\pipe\\"), c.name);
+            c.stalled = i == n;
+            c.pipe = CreateNamedPipe(path, PIPE_ACCESS_DUPLEX, PIPE_TYPE_BYTE | PIPE_WAIT, 1,
+                CLIENT_PIPE_BUFFER, CLIENT_PIPE_BUFFER, 0, NULL);
+            c.thread = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)clientThreadProc, &c, 0, NULL);
+
+            Login_Return_Type r = data.insert(c.name);
+            ids.push_back(r.id);
+        }
+    }
+
+    /**
+     * Log everybody out and let the client threads end
+     */
+    void end() {
+        InterlockedExchange(&stopping, 1);
+        SetEvent(release_stalled);
+
+        for (int32_t id : ids) {
+            data.remove(id);
+        }
+    }
+
+    void join() {
+        for (BenchClient& c : clients) {
+            WaitForSingleObject(c.thread, ROUND_TIMEOUT);
+            CloseHandle(c.thread);
+            CloseHandle(c.pipe);
+        }
+    }
+};
+
+/**
+ * A packet for each player, the stalled one too
+ */
+static void sendEach(GameData& data, const std::vector<int32_t>& ids, Packet& p) {
+    for (int32_t id : ids) {
+        data.send(id, p);
+    }
+}
+
+/**
+ * Rounds of sends; false if a round did not reach every live client in time
+ */
+static bool sendRounds(GameData& data, const std::vector<int32_t>& ids, int rounds, Samples& call, Samples& delivery, int& done) {
+    Packet p = { 0 };
+    p.code = GUESS;
+
+    for (done = 0; done < rounds; ++done) {
+        received = 0;
+        expected = (LONG)ids.size() - 1;
+        ResetEvent(all_received);
+        p.standing.score = done;
+
+        double start = nowNs();
+        sendEach(data, ids, p);
+        double returned = nowNs();
+
+        if (WaitForSingleObject(all_received, ROUND_TIMEOUT) != WAIT_OBJECT_0) {
+            return false;
+        }
+
+        call.add(returned - start);
+        delivery.add(nowNs() - start);
+    }
+
+    return true;
+}
+
+static void runBroadcaster(uint32_t n, int rounds) {
+    BenchGame* game = new BenchGame(n);
+    Broadcaster* broadcaster = new Broadcaster();
+    Samples call, delivery;
+    int done = 0;
+
+    broadcaster->start(BROADCAST_THREADS);
+    game->data.broadcastThrough(broadcaster);
+
+    bool ok = sendRounds(game->data, game->ids, rounds, call, delivery, done);
+
+    printf("%4u clients + 1 stalled, Broadcaster: %s\n", n, ok ? "every round delivered" : "blocked");
+    call.print("  sends return (us)");
+    delivery.print("  every live client has its packet (us)");
+
+    game->end();
+    delete broadcaster;     // writes what is left, closes the connections
+    game->join();
+    delete game;
+}
+
+/* Rounds run by a thread of their own, since a send() written directly can block for good */
+struct DirectRounds {
+    GameData* data;
+    std::vector<int32_t> ids;
+    int rounds;
+    volatile LONG done;
+    Samples call, delivery;
+};
+
+void* directRoundsThreadProc(void* param) {
+    DirectRounds* d = (DirectRounds*)param;
+    Packet p = { 0 };
+    p.code = GUESS;
+
+    for (int r = 0; r < d->rounds; ++r) {
+        received = 0;
+        expected = (LONG)d->ids.size() - 1;
+        ResetEvent(all_received);
+        p.standing.score = r;
+
+        double start = nowNs();
+        sendEach(*d->data, d->ids, p);
+        double returned = nowNs();
+
+        if (WaitForSingleObject(all_received, ROUND_TIMEOUT) != WAIT_OBJECT_0) {
+            break;
+        }
+
+        d->call.add(returned - start);
+        d->delivery.add(nowNs() - start);
+        InterlockedIncrement(&d->done);
+    }
+
+    return NULL;
+}
+
+static void runDirect(uint32_t n, int rounds) {
+    BenchGame* game = new BenchGame(n);
+    DirectRounds* d = new DirectRounds();
+    LONG seen = -1;
+
+    d->data = &game->data;
+    d->ids = game->ids;
+    d->rounds = rounds;
+    d->done = 0;
+
+    HANDLE thread = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)directRoundsThreadProc, d, 0, NULL);
+
+    // Wait while rounds keep completing
+    while (WaitForSingleObject(thread, ROUND_TIMEOUT) == WAIT_TIMEOUT) {
+        if (d->done == seen) {
+            // send() is stuck writing to the stalled client: the game and the thread are left as they are
+            printf("%4u clients + 1 stalled, written from send(): blocked for good after %ld rounds\n", n, d->done);
+            d->call.print("  sends return (us)");
+            d->delivery.print("  every live client has its packet (us)");
+            return;
+        }
+
+        seen = d->done;
+    }
+
+    printf("%4u clients + 1 stalled, written from send(): %ld rounds delivered\n", n, d->done);
+    d->call.print("  sends return (us)");
+    CloseHandle(thread);
+    game->end();
+    game->join();
+    delete game;
+    delete d;
+}
+
+int _tmain(int argc, TCHAR* argv[]) {
+    int rounds = argc > 1 ? (int)_tcstoul(argv[1], NULL, 10) : 2000;
+    const uint32_t clients[] = { 20, 1000 };
+
+    all_received = CreateEvent(NULL, TRUE, FALSE, NULL);
+    release_stalled = CreateEvent(NULL, TRUE, FALSE, NULL);
+
+    for (uint32_t n : clients) {
+        int r = n >= 1000 ? rounds / 10 : rounds;
+
+        runBroadcaster(n, r);
+    }
+
+    // Last: a blocked broadcast leaves its threads behind
+    runDirect(20, rounds);
+    return 0;
+}
@@ -0,0 +1,178 @@
+/*
+    DAWG benchmark
+    Time to find every word a board can form with the DAWG walk the server uses, against the
+    walk it replaced: every sub-multiset of the board letters looked up as an anagram class
+    in a signature index, behind a bitmap of the signatures in the dictionary. Both must find
+    the same words. Also reports the size of the DAWG in the image next to the index.
+*/
+
+#include "BenchWords.h"
+#include <unordered_map>
+
+#define BOARDS 2000
+
+/**
+ * The sub-multiset rebuild, kept here to compare against
+ */
+class SubsetSolutions {
+    std::vector<uint64_t> screen;       // one bit per signature hash bucket with some word in it
+    uint64_t screen_mask;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> classes;   // signature hash -> anagrams
+    uint32_t letters[MAX_WORD_LENGTH];
+
+    void enumerate(const LetterSignature& board, LetterSignature& sub, int at, int present, int size, std::vector<uint32_t>& out) const {
+        if (at == present) {
+            uint64_t hash = signatureHash(sub);
+            uint64_t h = (hash >> 32) & screen_mask;
+
+            if (size > 0 && (screen[h >> 6] >> (h & 63)) & 1) {
+                auto c = classes.find(hash);
+
+                if (c != classes.end()) {
+                    out.insert(out.end(), c->second.begin(), c->second.end());
+                }
+            }
+            return;
+        }
+
+        uint32_t letter = letters[at];
+
+        for (uint8_t c = 0; c <= board.counts[letter]; ++c) {
+            sub.counts[letter] = c;
+            enumerate(board, sub, at + 1, present, size + c, out);
+        }
+
+        sub.counts[letter] = 0;
+    }
+
+public:
+    void reset(const DictionaryHeader* d) {
+        uint64_t size = 64;
+
+        while (size < 16 * (uint64_t)d->words) {
+            size <<= 1;
+        }
+
+        screen.assign(size / 64, 0);
+        screen_mask = size - 1;
+        classes.clear();
+
+        for (uint32_t i = 0; i < d->words; ++i) {
+            LetterSignature sig;
+            signatureFromLetters(dictionaryWord(d, i), sig);
+
+            uint64_t hash = signatureHash(sig);
+            uint64_t h = (hash >> 32) & screen_mask;
+            screen[h >> 6] |= 1ULL << (h & 63);
+            classes[hash].push_back(i);
+        }
+    }
+
+    void rebuild(const LetterSignature& board, std::vector<uint32_t>& out) {
+        LetterSignature sub;
+        int present = 0;
+
+        for (uint32_t c = 0; c < LETTER_COUNT; ++c) {
+            if (board.counts[c] != 0 && present < MAX_WORD_LENGTH) {
+                letters[present++] = c;
+            }
+        }
+
+        memset(&sub, 0, sizeof(LetterSignature));
+        out.clear();
+        enumerate(board, sub, 0, present, 0, out);
+    }
+};
+
+/**
+ * Words built from common syllables: shared prefixes and suffixes, like a real language
+ */
+static void syllableWordList(std::mt19937& rng, size_t count, std::vector<WordKey>& keys) {
+    static const TCHAR* syllables[] = { TEXT("re"), TEXT("in"), TEXT("con"), TEXT("de"), TEXT("pro"),
+        TEXT("ment"), TEXT("tion"), TEXT("er"), TEXT("ing"), TEXT("ed"), TEXT("al"), TEXT("ly"), TEXT("ness"),
+        TEXT("st"), TEXT("a"), TEXT("o"), TEXT("ex"), TEXT("un"), TEXT("pre"), TEXT("ter"), TEXT("ba"),
+        TEXT("lo"), TEXT("ca"), TEXT("mi"), TEXT("sa"), TEXT("ti") };
+    const size_t n = sizeof(syllables) / sizeof(syllables[0]);
+    keys.clear();
+
+    for (size_t i = 0; i < count; ++i) {
+        std::wstring word;
+        WordKey key;
+
+        for (int j = 2 + rng() % 3; j > 0; --j) {
+            word += syllables[rng() % n];
+        }
+
+        if (wordKeyFromText(word.c_str(), word.size(), key)) {
+            keys.push_back(key);
+        }
+    }
+
+    wordKeysSortUnique(keys);
+}
+
+static bool run(const char* label, const std::vector<WordKey>& keys, std::mt19937& rng) {
+    std::vector<uint8_t> image;
+    double build;
+    const DictionaryHeader* d = benchCompile(keys, image, &build);
+    SubsetSolutions subsets;
+    std::vector<uint32_t> walked, found;
+    Samples dawg, subset;
+    uint64_t solutions = 0;
+
+    if (d == NULL) {
+        return false;
+    }
+
+    subsets.reset(d);
+
+    for (int b = 0; b < BOARDS; ++b) {
+        LetterSignature board = randomBoard(rng, MAX_WORD_LENGTH, true);
+        uint8_t counts[26];
+        double start = nowNs();
+
+        walked.clear();
+        memcpy(counts, board.counts, sizeof(counts));
+        dawgWalk(d, counts, [&](uint32_t w) { walked.push_back(w); });
+        dawg.add(nowNs() - start);
+
+        start = nowNs();
+        subsets.rebuild(board, found);
+        subset.add(nowNs() - start);
+
+        std::sort(walked.begin(), walked.end());
+        std::sort(found.begin(), found.end());
+
+        if (walked != found) {
+            printf("%s: board %d, the walks disagree\n", label, b);
+            return false;
+        }
+
+        solutions += walked.size();
+    }
+
+    printf("%s: %u words, image %u KB (index %u KB, DAWG %u edges, %u KB), compiled in %.1f ms\n",
+        label, d->words, d->size / 1024, d->index_slots * (uint32_t)sizeof(DictionarySlot) / 1024,
+        d->dawg_edges, d->dawg_edges * 8 / 1024, build);
+    printf("  %.0f solutions per 12-letter board, both walks agree\n", (double)solutions / BOARDS);
+    dawg.print("  DAWG walk (us)");
+    subset.print("  sub-multisets (us)");
+    return true;
+}
+
+int _tmain(int argc, TCHAR* argv[]) {
+    std::mt19937 rng(6);
+    std::vector<WordKey> keys;
+
+    if (!benchWordList(argc, argv, keys) || !run("word list", keys, rng)) {
+        return 1;
+    }
+
+    syllableWordList(rng, 300000, keys);
+    if (!run("syllable list", keys, rng)) {
+        return 1;
+    }
+
+    denseWordList(rng, 200000, keys);
+    return run("dense list", keys, rng) ? 0 : 1;
+}
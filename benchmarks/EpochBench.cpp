@@ -0,0 +1,83 @@
+/*
+    Epoch reclamation stress test and benchmark
+    Reader threads keep entering the domain, loading a shared pointer and checking the object
+    behind it, while the writer swaps the pointer, synchronizes and then poisons the old
+    object (it is never freed, so a late reader is caught instead of crashing). No reader may
+    ever see a poisoned object. Reports the cost of a read section and of synchronize().
+*/
+
+#include "Bench.h"
+#include "..\WordGame_server\WordGame_server\Epoch.h"
+
+#define READERS 4
+#define SWAPS 2000
+#define CHECKS 50
+
+struct Version {
+    volatile LONG alive;
+};
+
+static EpochDomain domain;
+static Version* volatile current;
+static volatile LONG stop = 0;
+static volatile LONG64 reads = 0;
+static volatile LONG64 retired = 0;    // reads that saw a poisoned version
+
+void* readerThreadProc(void* param) {
+    int reader = (int)(intptr_t)param;
+    LONG64 n = 0, bad = 0;
+
+    while (!stop) {
+        domain.enter(reader);
+        Version* v = current;
+
+        for (int k = 0; k < CHECKS; ++k) {
+            bad += v->alive != 1;
+        }
+
+        domain.leave(reader);
+        ++n;
+    }
+
+    InterlockedExchangeAdd64(&reads, n);
+    InterlockedExchangeAdd64(&retired, bad);
+    return NULL;
+}
+
+int _tmain(int, TCHAR*[]) {
+    HANDLE threads[READERS];
+    Samples sync;
+
+    // Read section alone
+    current = new Version{ 1 };
+    double section = nsPerOp(1000000, [] {
+        for (int i = 0; i < 1000000; ++i) {
+            domain.enter(0);
+            Version* v = current;
+            (void)v->alive;
+            domain.leave(0);
+        }
+    });
+
+    for (int r = 0; r < READERS; ++r) {
+        threads[r] = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)readerThreadProc, (LPVOID)(intptr_t)r, 0, NULL);
+    }
+
+    for (int i = 0; i < SWAPS; ++i) {
+        Version* old = (Version*)InterlockedExchangePointer((PVOID volatile*)&current, new Version{ 1 });
+        double start = nowNs();
+
+        domain.synchronize();
+        sync.add(nowNs() - start);
+        old->alive = 0;     // poisoned, not freed
+    }
+
+    InterlockedExchange(&stop, 1);
+    WaitForMultipleObjects(READERS, threads, TRUE, INFINITE);
+
+    printf("%d readers, %d swaps: %lld read sections, %lld saw a retired version\n",
+        READERS, SWAPS, (long long)reads, (long long)retired);
+    printf("read section (enter, load, leave): %.1f ns\n", section);
+    sync.print("synchronize (us)");
+    return retired != 0;
+}
@@ -0,0 +1,164 @@
+/*
+    Event ring benchmark
+    Cost of GameData::broadcast writing to the shared event ring at 20, 1000 and
+    MAX_PLAYERS_LIMIT players, while reader threads follow the ring the way the client's
+    events thread does (read at their own cursor, wait on the parity event of the next
+    write). Four readers are fast; one sleeps after every event and falls behind. The
+    writer broadcasts in bursts smaller than the ring and lets the fast readers catch up
+    between bursts. Each broadcast() is timed on its own; on a single core the readers it
+    wakes can preempt it, which shows in the tail rather than the median. Checks that the readers see
+    the events in order and that the slow one detects its overruns.
+    Usage: EventRingBench [events per run]
+*/
+
+#include "BenchPlayers.h"
+
+#define READERS 5              // the last one is slow
+#define BURST 256              // events written before the fast readers catch up
+
+static EventRing ring;
+static HANDLE signals[2];
+static volatile LONG writing = 0;
+static volatile LONG64 events = 0;
+static int failures = 0;
+
+struct ReaderState {
+    bool slow;
+    volatile LONG64 cursor;     // next event to read
+    uint64_t read;
+    uint64_t overruns;
+    uint64_t lost;
+    bool ordered;
+};
+
+void* readerThreadProc(void* param) {
+    ReaderState* r = (ReaderState*)param;
+    uint64_t cursor = 0;
+    int64_t last = -1;
+    bool gap = false;
+    EventSlot e;
+
+    while (writing || cursor < (uint64_t)events) {
+        EventRingRead x = eventRingRead(&ring, cursor, e);
+
+        if (x == EVENT_PENDING) {
+            WaitForSingleObject(signals[(cursor + 1) & 1], 100);
+            continue;
+        }
+
+        if (x == EVENT_OVERRUN) {
+            uint64_t head = (uint64_t)ring.head;
+            r->overruns += 1;
+            r->lost += head - cursor;
+            cursor = head;
+            gap = true;
+            InterlockedExchange64(&r->cursor, (LONG64)cursor);
+            continue;
+        }
+
+        // Scores count the events: one more each, or further on after an overrun
+        int64_t n = e.packet.score;
+        r->ordered = r->ordered && (gap ? n > last : n == last + 1);
+        last = n;
+        gap = false;
+        cursor += 1;
+        r->read += 1;
+        InterlockedExchange64(&r->cursor, (LONG64)cursor);
+
+        if (r->slow) {
+            Sleep(1);
+        }
+    }
+
+    return NULL;
+}
+
+static void run(uint32_t players, int64_t count) {
+    GameData data(players);
+    std::vector<int32_t> ids;
+    ReaderState readers[READERS];
+    HANDLE threads[READERS];
+
+    memset(&ring, 0, sizeof(ring));
+    ResetEvent(signals[0]);
+    ResetEvent(signals[1]);
+
+    if (!benchLogin(data, players, ids)) {
+        return;
+    }
+
+    data.publishEvents(&ring, signals);
+    writing = 1;
+    events = count;
+
+    for (int i = 0; i < READERS; ++i) {
+        readers[i] = { i == READERS - 1, 0, 0, 0, 0, true };
+        threads[i] = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)readerThreadProc, &readers[i], 0, NULL);
+    }
+
+    Packet p = { 0 };
+    p.code = GUESS;
+
+    Samples call;
+
+    for (int64_t i = 0; i < count; ) {
+        for (int64_t end = (std::min)(i + BURST, count); i < end; ++i) {
+            p.score = (int32_t)i;
+
+            double start = nowNs();
+            data.broadcast(p);
+            call.add(nowNs() - start);
+        }
+
+        for (int r = 0; r < READERS - 1; ++r) {
+            while (readers[r].cursor < i) {
+                Sleep(0);
+            }
+        }
+    }
+
+    InterlockedExchange(&writing, 0);
+    WaitForMultipleObjects(READERS, threads, TRUE, INFINITE);
+
+    bool ordered = true;
+    uint64_t fast = UINT64_MAX;
+
+    for (int i = 0; i < READERS; ++i) {
+        CloseHandle(threads[i]);
+        ordered = ordered && readers[i].ordered;
+
+        if (!readers[i].slow) {
+            fast = (std::min)(fast, readers[i].read);
+        }
+    }
+
+    const ReaderState& slow = readers[READERS - 1];
+    printf("%5u players: events in order: %s; fast readers got %llu of %lld; slow reader %llu overruns, %llu events lost\n",
+        players, ordered ? "yes" : "NO", (unsigned long long)fast, (long long)count, (unsigned long long)slow.overruns,
+        (unsigned long long)slow.lost);
+    call.print("  broadcast (ns)", 1);
+
+    if (!ordered || fast != (uint64_t)count || slow.overruns == 0) {
+        failures += 1;
+    }
+}
+
+int _tmain(int argc, TCHAR* argv[]) {
+    int64_t count = argc > 1 ? _tcstoul(argv[1], NULL, 10) : 200000;
+    BenchPipes pipes;
+    const uint32_t players[] = { 20, 1000, MAX_PLAYERS_LIMIT };
+
+    signals[0] = CreateEvent(NULL, TRUE, FALSE, NULL);
+    signals[1] = CreateEvent(NULL, TRUE, FALSE, NULL);
+
+    if (!pipes.create(MAX_PLAYERS_LIMIT)) {
+        return 1;
+    }
+
+    for (uint32_t n : players) {
+        run(n, count);
+    }
+
+    printf("%s\n", failures == 0 ? "ok" : "FAILED");
+    return failures != 0;
+}
@@ -0,0 +1,115 @@
+/*
+    Guess filter benchmark
+    A flood of random 3 to 8 letter guesses with 5% real words, checked the way handleGuess
+    checks them. Reports the size of the filter, its measured false positive rate against the
+    target (no word may ever be rejected), the cost of a probe, and the work left under the
+    lock per guess (index lookup and solution test) with and without the filter in front.
+*/
+
+#include "BenchWords.h"
+#include "..\WordGame_server\WordGame_server\GuessFilter.h"
+#include "..\WordGame_server\WordGame_server\SolutionSet.h"
+
+#define GUESSES 200000
+
+static bool run(const char* label, const std::vector<WordKey>& keys, double rate, std::mt19937& rng) {
+    std::vector<uint8_t> image;
+    const DictionaryHeader* d = benchCompile(keys, image);
+    std::vector<Letter> guesses(GUESSES * GUESS_SIZE);
+    std::vector<LetterSignature> sigs(GUESSES);
+    WordIndex index;
+    GuessFilter filter;
+    SolutionSet set;
+    uint64_t words = 0, passed = 0, wrong = 0;
+    uint64_t sink = 0;
+
+    if (d == NULL) {
+        return false;
+    }
+
+    index.attach(d);
+    filter.build(d, rate);
+    set.reset(d);
+    set.rebuild(d, randomBoard(rng, MAX_WORD_LENGTH, true));
+
+    for (int i = 0; i < GUESSES; ++i) {
+        Letter* g = &guesses[i * GUESS_SIZE];
+
+        if (rng() % 20 == 0) {
+            const Letter* w = dictionaryWord(d, rng() % d->words);
+            size_t len = 0;
+
+            while ((g[len] = w[len]) != LETTER_NONE) {
+                ++len;
+            }
+        }
+        else {
+            randomLetters(rng, g, 3 + rng() % 6);
+        }
+
+        signatureFromLetters(g, sigs[i]);
+    }
+
+    // Accuracy
+    for (int i = 0; i < GUESSES; ++i) {
+        const Letter* g = &guesses[i * GUESS_SIZE];
+        bool word = index.find(g, sigs[i]) >= 0;
+        bool may = filter.mayContain(g);
+
+        words += word;
+        passed += may && !word;
+        wrong += word && !may;
+    }
+
+    if (wrong != 0) {
+        printf("%s: the filter rejected %llu words\n", label, (unsigned long long)wrong);
+        return false;
+    }
+
+    // Cost
+    double probe = nsPerOp(GUESSES, [&] {
+        for (int i = 0; i < GUESSES; ++i) sink += filter.mayContain(&guesses[i * GUESS_SIZE]);
+    });
+    double unscreened = nsPerOp(GUESSES, [&] {
+        for (int i = 0; i < GUESSES; ++i) sink += set.contains(index.find(&guesses[i * GUESS_SIZE], sigs[i]));
+    });
+    double screened = nsPerOp(GUESSES, [&] {
+        for (int i = 0; i < GUESSES; ++i) {
+            if (filter.mayContain(&guesses[i * GUESS_SIZE])) {
+                sink += set.contains(index.find(&guesses[i * GUESS_SIZE], sigs[i]));
+            }
+        }
+    }) - probe;
+
+    printf("%s: %u words, target %.2f%%: filter %llu bytes, false positives %.2f%% of %llu non-words, no word rejected\n",
+        label, d->words, rate * 100, (unsigned long long)filter.size(),
+        100.0 * passed / (GUESSES - words), (unsigned long long)(GUESSES - words));
+    printf("  probe %.1f ns, work under the lock %.1f ns -> %.1f ns per guess\n", probe, unscreened, screened);
+    return sink != 0;
+}
+
+int _tmain(int argc, TCHAR* argv[]) {
+    std::mt19937 rng(7);
+    std::vector<WordKey> keys;
+    const double rates[] = { 0.05, 0.01, 0.001 };
+
+    if (!benchWordList(argc, argv, keys)) {
+        return 1;
+    }
+
+    for (double r : rates) {
+        if (!run("word list", keys, r, rng)) {
+            return 1;
+        }
+    }
+
+    denseWordList(rng, 200000, keys);
+
+    for (double r : rates) {
+        if (!run("dense list", keys, r, rng)) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
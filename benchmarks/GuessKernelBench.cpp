@@ -0,0 +1,88 @@
+/*
+    Guess kernel benchmark
+    Time per guess of the scalar kernel against the SSE2 kernel over a mix of guesses like the
+    ones the server receives: words of 3 to 12 letters, plus some with a byte that is not a
+    letter code and some with no terminator in the window. Both kernels must agree on every one.
+*/
+
+#include "Bench.h"
+#include "..\WordGame_server\WordGame_server\GuessKernel.h"
+
+#define GUESSES 4096
+#define ROUNDS 200
+
+static Letter guesses[GUESSES][GUESS_SIZE];
+
+static size_t wordLength(const Letter* word) {
+    size_t len = 0;
+
+    while (word[len] != LETTER_NONE) {
+        ++len;
+    }
+
+    return len;
+}
+
+/**
+ * Run a kernel over every guess
+ *
+ * @return Number of valid guesses plus the sum of their counts (keeps the work alive)
+ */
+static uint64_t runKernel(GuessKernel kernel) {
+    uint64_t sink = 0;
+    Letter word[GUESS_SIZE];
+    LetterSignature sig;
+
+    for (int i = 0; i < GUESSES; ++i) {
+        if (kernel(guesses[i], word, sig)) {
+            sink += 1 + sig.lanes[0] + sig.lanes[1] + sig.lanes[2];
+        }
+    }
+
+    return sink;
+}
+
+int _tmain(int, TCHAR*[]) {
+    std::mt19937 rng(2);
+
+    for (int i = 0; i < GUESSES; ++i) {
+        int len = 3 + rng() % (MAX_WORD_LENGTH - 2);
+        memset(guesses[i], 0, GUESS_SIZE);
+        randomLetters(rng, guesses[i], len);
+
+        switch (rng() % 20) {
+        case 0:     // not a letter code
+            guesses[i][rng() % len] = (Letter)(LETTER_COUNT + rng() % 200);
+            break;
+        case 1:     // no terminator in the window
+            memset(guesses[i], 1, GUESS_SIZE);
+            break;
+        }
+    }
+
+    // Both kernels must agree
+    for (int i = 0; i < GUESSES; ++i) {
+        Letter a[GUESS_SIZE], b[GUESS_SIZE];
+        LetterSignature sa, sb;
+        bool ra = guessKernelScalar(guesses[i], a, sa);
+        bool rb = guessKernelSSE2(guesses[i], b, sb);
+
+        if (ra != rb || (ra && (!signatureEquals(sa, sb) || memcmp(a, b, wordLength(a) + 1) != 0))) {
+            printf("kernels disagree on guess %d\n", i);
+            return 1;
+        }
+    }
+
+    uint64_t sink = 0;
+    double scalar = nsPerOp((size_t)GUESSES * ROUNDS, [&] {
+        for (int r = 0; r < ROUNDS; ++r) sink += runKernel(guessKernelScalar);
+    });
+    double sse2 = nsPerOp((size_t)GUESSES * ROUNDS, [&] {
+        for (int r = 0; r < ROUNDS; ++r) sink += runKernel(guessKernelSSE2);
+    });
+
+    printf("%d guesses, kernels agree\n", GUESSES);
+    printf("scalar  %6.1f ns per guess\n", scalar);
+    printf("SSE2    %6.1f ns per guess\n", sse2);
+    return sink == 0;    // no valid guess: the mix is broken
+}
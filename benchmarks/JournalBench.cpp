@@ -0,0 +1,317 @@
+/*
+    Score journal benchmark
+    - Recovery time: a journal of 1M records over 10k players with no snapshot, then a
+      snapshot of the 10k players plus a 1000 record tail; a score nobody claims must be
+      kept for JOURNAL_RECOVERED_RESTARTS restarts, then dropped
+    - Cost of journaling to the thread calling GameData::update (wall and CPU time)
+    - Replay check: a child process (this program with "child") logs players in and keeps
+      updating their scores, and is killed at a random moment; the recovered scores must be
+      those after some prefix of its changes, and no later than its last change
+    Files are created in the current directory and deleted at the end.
+    Usage: JournalBench [kills]
+*/
+
+#include "BenchPlayers.h"
+
+#define PLAYERS MAX_PLAYERS_LIMIT
+#define RECORDS 1000000
+#define TAIL 1000
+#define UPDATES 2000000
+#define KILL_PLAYERS 1000       // players of the child, whose changes cross several snapshots
+
+static const TCHAR* recoverPath = TEXT("bench_recover.journal");
+static const TCHAR* updatePath = TEXT("bench_update.journal");
+static const TCHAR* killPath = TEXT("bench_kill.journal");
+static const TCHAR* progressName = TEXT("Local\\bench_journal_progress");
+
+static int failures = 0;
+
+static void check(bool ok, const char* what, size_t i) {
+    if (!ok && failures++ < 10) {
+        printf("failed: %s (%zu)\n", what, i);
+    }
+}
+
+/**
+ * Delete a journal and its snapshot
+ */
+static void removeJournal(const TCHAR* path) {
+    const TCHAR* suffixes[] = { TEXT(""), TEXT(".old"), TEXT(".snap"), TEXT(".snap.tmp") };
+    TCHAR file[MAX_PATH];
+
+    for (const TCHAR* s : suffixes) {
+        _stprintf_s(file, TEXT("%s%s"), path, s);
+        DeleteFile(file);
+    }
+}
+
+/**
+ * Snapshot source of a journal opened only to recover
+ */
+static uint64_t noCapture(std::vector<JournalRecord>& records) {
+    records.clear();
+    return 0;
+}
+
+/**
+ * CPU time of the calling thread in nanoseconds
+ */
+static double threadCpuNs() {
+    FILETIME created, exited, kernel, user;
+    GetThreadTimes(GetCurrentThread(), &created, &exited, &kernel, &user);
+    return 100.0 * ((double)(((uint64_t)kernel.dwHighDateTime << 32) | kernel.dwLowDateTime) +
+        (double)(((uint64_t)user.dwHighDateTime << 32) | user.dwLowDateTime));
+}
+
+/**
+ * Recovery from a long journal, then from a snapshot and a short tail
+ */
+static bool benchRecovery(GameData& data, const std::vector<int32_t>& ids) {
+    TCHAR name[NAME_SIZE];
+    std::vector<JournalRecord> records(RECORDS);
+    JournalHeader h = { JOURNAL_MAGIC, JOURNAL_VERSION, 0 };
+    DWORD done = 0;
+
+    removeJournal(recoverPath);
+
+    // Player i % PLAYERS joins, then its score goes up by one per round
+    for (uint32_t i = 0; i < RECORDS; ++i) {
+        benchPlayerName(i % PLAYERS, name);
+        journalRecord(records[i], i < PLAYERS ? JOURNAL_INSERT : JOURNAL_UPDATE, name, (int32_t)(i / PLAYERS));
+    }
+
+    HANDLE file = CreateFile(recoverPath, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    DWORD size = (DWORD)(records.size() * sizeof(JournalRecord));
+
+    if (file == INVALID_HANDLE_VALUE || !WriteFile(file, &h, sizeof(h), &done, NULL) ||
+        !WriteFile(file, records.data(), size, &done, NULL) || done != size) {
+        printf("cannot write %ls\n", recoverPath);
+        return false;
+    }
+
+    CloseHandle(file);
+
+    int32_t last = (int32_t)((RECORDS - 1) / PLAYERS);
+    double start = nowNs();
+    {
+        ScoreJournal journal;
+        check(journal.open(recoverPath, noCapture), "open a long journal", 0);
+        printf("replay of %d records over %d players: %.1f ms\n", RECORDS, PLAYERS, (nowNs() - start) / 1e6);
+
+        benchPlayerName(PLAYERS - 1, name);
+        check(journal.recoveredScore(name) == last, "score after replay", 0);
+    }
+
+    // The journal now starts from a snapshot; add a tail of updates by one player
+    {
+        ScoreJournal journal;
+        benchPlayerName(1, name);
+        check(journal.open(recoverPath, [&data](std::vector<JournalRecord>& r) { return data.journalState(r); }), "reopen", 0);
+        data.journalTo(&journal);
+        data.remove(ids[1]);
+        int32_t id = data.insert(name, journal.recoveredScore(name)).id;
+        journal.claim(name);
+
+        for (int i = 1; i < TAIL; ++i) {
+            data.update(id, 1);
+        }
+
+        journal.close();
+        data.journalTo(NULL);
+    }
+
+    start = nowNs();
+    {
+        ScoreJournal journal;
+        check(journal.open(recoverPath, noCapture), "open a snapshot and a tail", 0);
+        printf("snapshot of %d players + %d record tail: %.1f ms\n", PLAYERS, TAIL, (nowNs() - start) / 1e6);
+        check(journal.recoveredScore(name) == last + TAIL - 1, "score after the tail", 0);
+    }
+
+    // A score nobody claims waits JOURNAL_RECOVERED_RESTARTS restarts (three so far), then is dropped
+    benchPlayerName(PLAYERS - 1, name);
+
+    for (int i = 4; i <= JOURNAL_RECOVERED_RESTARTS; ++i) {
+        ScoreJournal journal;
+        check(journal.open(recoverPath, noCapture) && journal.recoveredScore(name) == last, "score kept while it waits", i);
+    }
+
+    {
+        ScoreJournal journal;
+        check(journal.open(recoverPath, noCapture) && journal.recoveredScore(name) == 0, "score dropped after it waited", 0);
+    }
+
+    removeJournal(recoverPath);
+    return true;
+}
+
+/**
+ * Cost of journaling to the updating thread
+ */
+static void benchUpdates(GameData& data, const std::vector<int32_t>& ids, bool journaled) {
+    ScoreJournal journal;
+    std::mt19937 rng(11);
+
+    removeJournal(updatePath);
+
+    if (journaled) {
+        journal.open(updatePath, [&data](std::vector<JournalRecord>& r) { return data.journalState(r); });
+        data.journalTo(&journal);
+    }
+
+    double wall = nowNs(), cpu = threadCpuNs();
+
+    for (int i = 0; i < UPDATES; ++i) {
+        data.update(ids[rng() % ids.size()], 1);
+    }
+
+    wall = nowNs() - wall;
+    cpu = threadCpuNs() - cpu;
+
+    printf("journal %-3s %d updates: %6.0f ns wall, %6.0f ns CPU per update\n", journaled ? "on" : "off",
+        UPDATES, wall / UPDATES, cpu / UPDATES);
+
+    if (journaled) {
+        journal.close();        // the writer may be taking a snapshot from data
+        data.journalTo(NULL);
+        printf("  %llu commits, %llu snapshots\n", (unsigned long long)journal.commitCount(),
+            (unsigned long long)journal.snapshotCount());
+    }
+
+    removeJournal(updatePath);
+}
+
+/**
+ * Child of the replay check: logs KILL_PLAYERS players in, then raises their scores one
+ * by one in turn until killed, counting its changes in the progress mapping
+ */
+static int runChild(const TCHAR* path) {
+    HANDLE mapping = CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, sizeof(LONG64), progressName);
+    volatile LONG64* made = mapping == NULL ? NULL : (volatile LONG64*)MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(LONG64));
+    BenchPipes pipes;
+    GameData data(KILL_PLAYERS);
+    ScoreJournal journal;
+    std::vector<int32_t> ids;
+
+    if (made == NULL || !pipes.create(KILL_PLAYERS) ||
+        !journal.open(path, [&data](std::vector<JournalRecord>& r) { return data.journalState(r); })) {
+        return 1;
+    }
+
+    data.journalTo(&journal);
+
+    if (!benchLogin(data, KILL_PLAYERS, ids)) {
+        return 1;
+    }
+
+    InterlockedExchange64(made, KILL_PLAYERS);
+
+    for (uint64_t u = 0; ; ++u) {
+        data.update(ids[u % KILL_PLAYERS], 1);
+        InterlockedExchange64(made, (LONG64)(KILL_PLAYERS + u + 1));
+    }
+}
+
+/**
+ * Kill a child mid-write and check what it left
+ *
+ * @param lost Receives the changes made by the child and not recovered
+ * @return false if the child did not start
+ */
+static bool killAndRecover(const TCHAR* exe, volatile LONG64* made, DWORD after_ms, int64_t& lost) {
+    TCHAR cmd[2 * MAX_PATH];
+    STARTUPINFO si = { sizeof(si) };
+    PROCESS_INFORMATION pi;
+    TCHAR name[NAME_SIZE];
+
+    removeJournal(killPath);
+    InterlockedExchange64(made, 0);
+    _stprintf_s(cmd, TEXT("\"%s\" child %s"), exe, killPath);
+
+    if (!CreateProcess(NULL, cmd, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi)) {
+        printf("CreateProcess %lu\n", GetLastError());
+        return false;
+    }
+
+    while (*made < KILL_PLAYERS && WaitForSingleObject(pi.hProcess, 1) == WAIT_TIMEOUT) {
+    }
+
+    Sleep(after_ms);
+    TerminateProcess(pi.hProcess, 1);
+    WaitForSingleObject(pi.hProcess, INFINITE);
+    CloseHandle(pi.hProcess);
+    CloseHandle(pi.hThread);
+
+    if (*made < KILL_PLAYERS) {
+        printf("the child exited before logging its players in\n");
+        return false;
+    }
+
+    // The changes are: every login, then update u raises player u % KILL_PLAYERS
+    ScoreJournal journal;
+    std::vector<int32_t> scores(KILL_PLAYERS);
+    int64_t updates = 0;
+
+    check(journal.open(killPath, noCapture), "recover after the kill", 0);
+
+    for (uint32_t i = 0; i < KILL_PLAYERS; ++i) {
+        benchPlayerName(i, name);
+        scores[i] = journal.recoveredScore(name);
+        updates += scores[i];
+    }
+
+    for (uint32_t i = 0; i < KILL_PLAYERS; ++i) {
+        int32_t expected = (int32_t)(updates / KILL_PLAYERS + (i < updates % KILL_PLAYERS ? 1 : 0));
+        check(scores[i] == expected, "scores of a prefix of the changes", i);
+    }
+
+    int64_t total = *made - KILL_PLAYERS;
+    check(updates <= total + 1, "nothing recovered that was not made", 0);     // the last one may be journaled before it is counted
+    journal.close();
+    removeJournal(killPath);
+
+    printf("  killed after %4lu ms: %9lld updates made, %9lld recovered\n", after_ms, (long long)total, (long long)updates);
+    lost = (std::max)(lost, total - updates);
+    return true;
+}
+
+int _tmain(int argc, TCHAR* argv[]) {
+    if (argc > 2 && _tcscmp(argv[1], TEXT("child")) == 0) {
+        return runChild(argv[2]);
+    }
+
+    int kills = argc > 1 ? (int)_tcstoul(argv[1], NULL, 10) : 10;
+    TCHAR exe[MAX_PATH];
+    BenchPipes pipes;
+    GameData data(PLAYERS);
+    std::vector<int32_t> ids;
+    std::mt19937 rng(13);
+
+    if (!pipes.create(PLAYERS) || !benchLogin(data, PLAYERS, ids) || !benchRecovery(data, ids)) {
+        return 1;
+    }
+
+    benchUpdates(data, ids, false);
+    benchUpdates(data, ids, true);
+
+    // Replay check
+    HANDLE mapping = CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, sizeof(LONG64), progressName);
+    volatile LONG64* made = mapping == NULL ? NULL : (volatile LONG64*)MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(LONG64));
+    int64_t lost = 0;
+
+    if (made == NULL || GetModuleFileName(NULL, exe, MAX_PATH) == 0) {
+        return 1;
+    }
+
+    printf("replay check, %d kills:\n", kills);
+
+    for (int i = 0; i < kills; ++i) {
+        check(killAndRecover(exe, made, 50 + rng() % 400, lost), "child ran", i);
+    }
+
+    printf("at most %lld updates lost (queued, not yet committed when killed)\n", (long long)lost);
+    UnmapViewOfFile((LPCVOID)made);
+    CloseHandle(mapping);
+    printf("%s\n", failures == 0 ? "ok" : "FAILED");
+    return failures != 0;
+}
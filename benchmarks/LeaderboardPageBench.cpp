@@ -0,0 +1,109 @@
+/*
+    Leaderboard page benchmark
+    Cost the shared leaderboard page adds to a score change at 20 and MAX_PLAYERS_LIMIT
+    players (GameData::update without and with a published page), and the cost of the
+    client reads that replaced the pipe requests: the top of the leaderboard and one score.
+    Checks the page against GameData: the top, every score, and a player who left.
+*/
+
+#include "BenchPlayers.h"
+
+#define UPDATES 200000
+
+static volatile int64_t sink;
+static int failures = 0;
+
+static void check(bool ok, const char* what, size_t i) {
+    if (!ok && failures++ < 10) {
+        printf("failed: %s (%zu)\n", what, i);
+    }
+}
+
+/**
+ * Time score changes, with or without a page
+ *
+ * @return Nanoseconds per update
+ */
+static double updateCost(uint32_t players, LeaderboardPage* page) {
+    GameData data(players);
+    std::vector<int32_t> ids;
+
+    if (page != NULL) {
+        data.publishLeaderboard(page);
+    }
+
+    if (!benchLogin(data, players, ids)) {
+        check(false, "login", players);
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < players; ++i) {
+        data.update(ids[i], (int32_t)(i % 97));
+    }
+
+    double ns = nsPerOp(UPDATES, [&] {
+        for (uint32_t r = 0; r < UPDATES; ++r) {
+            data.update(ids[(r * 7919u) % players], 1);
+        }
+    });
+
+    if (page == NULL) {
+        return ns;
+    }
+
+    // The page matches the store
+    LeaderboardTop top;
+    std::vector<LeaderboardEntry> leaders;
+
+    leaderboardPageTop(page, top);
+    data.leaders(LEADERBOARD_TOP, leaders);
+    check(top.count == leaders.size() && top.players == players && top.version == data.version() + 1, "top header", players);
+
+    for (size_t i = 0; i < leaders.size() && i < top.count; ++i) {
+        check(top.entries[i].score == leaders[i].score && _tcscmp(top.entries[i].name, leaders[i].name) == 0, "top entry", i);
+    }
+
+    for (uint32_t i = 0; i < players; ++i) {
+        check(leaderboardPageScore(page, ids[i]) == data.score(ids[i]), "score", i);
+    }
+
+    data.remove(ids[0]);
+    check(leaderboardPageScore(page, ids[0]) == -1, "player who left", players);
+
+    // Client reads
+    double topNs = nsPerOp(UPDATES, [&] {
+        for (uint32_t r = 0; r < UPDATES; ++r) {
+            leaderboardPageTop(page, top);
+            sink += top.count;
+        }
+    });
+
+    double scoreNs = nsPerOp(UPDATES, [&] {
+        for (uint32_t r = 0; r < UPDATES; ++r) {
+            sink += leaderboardPageScore(page, ids[1 + r % (players - 1)]);
+        }
+    });
+
+    printf("%5u players: client reads of the top %.0f ns, of a score %.1f ns\n", players, topNs, scoreNs);
+    return ns;
+}
+
+int _tmain(int, TCHAR*[]) {
+    BenchPipes pipes;
+    const uint32_t players[] = { 20, MAX_PLAYERS_LIMIT };
+
+    if (!pipes.create(MAX_PLAYERS_LIMIT)) {
+        return 1;
+    }
+
+    for (uint32_t n : players) {
+        std::vector<uint8_t> memory(leaderboardPageSize(n));
+        double without = updateCost(n, NULL);
+        double with = updateCost(n, (LeaderboardPage*)memory.data());
+
+        printf("%5u players: score update %.0f ns without the page, %.0f ns with it\n", n, without, with);
+    }
+
+    printf("%s\n", failures == 0 ? "ok" : "FAILED");
+    return failures != 0;
+}
@@ -0,0 +1,95 @@
+/*
+    Leaderboard snapshot benchmark
+    Cost of answering a LIST request at 20, 1000 and MAX_PLAYERS_LIMIT players: formatting
+    the leaderboard (what "listar" did on every call), copying the cached snapshot, and a
+    request whose version is already the latest (nothing copied). Also times a score
+    change followed by refresh(). Checks that the snapshot matches GameData::str().
+*/
+
+#include "BenchPlayers.h"
+#include "..\WordGame_server\WordGame_server\LeaderboardSnapshot.h"
+
+static volatile int64_t sink;
+static int failures = 0;
+
+static void check(bool ok, const char* what, size_t i) {
+    if (!ok && failures++ < 10) {
+        printf("failed: %s (%zu)\n", what, i);
+    }
+}
+
+static void run(uint32_t players) {
+    GameData data(players);
+    EpochDomain epochs;
+    LeaderboardCache cache(data, epochs);
+    std::vector<int32_t> ids;
+
+    if (!benchLogin(data, players, ids)) {
+        check(false, "login", players);
+        return;
+    }
+
+    for (uint32_t i = 0; i < players; ++i) {
+        data.update(ids[i], (int32_t)(i % 97));
+    }
+
+    cache.refresh();
+
+    LeaderboardSnapshot first, second;
+    check(cache.copy(0, 0, first) && first.text == data.str(), "snapshot matches str()", players);
+    check(!cache.copy(0, first.version, second), "nothing copied when up to date", players);
+
+    data.update(ids[0], 5);
+    cache.refresh();
+    check(cache.copy(0, first.version, second) && second.text == data.str() && second.version > first.version,
+        "new snapshot after a change", players);
+
+    size_t runs = players >= MAX_PLAYERS_LIMIT ? 200 : 2000;
+
+    double format = nsPerOp(runs, [&] {
+        for (size_t r = 0; r < runs; ++r) {
+            sink += data.str().size();
+        }
+    });
+
+    double copy = nsPerOp(runs, [&] {
+        for (size_t r = 0; r < runs; ++r) {
+            LeaderboardSnapshot s;
+            cache.copy(0, 0, s);
+            sink += s.text.size();
+        }
+    });
+
+    double unchanged = nsPerOp(runs, [&] {
+        for (size_t r = 0; r < runs; ++r) {
+            LeaderboardSnapshot s;
+            sink += cache.copy(0, second.version, s);
+        }
+    });
+
+    double refresh = nsPerOp(runs, [&] {
+        for (size_t r = 0; r < runs; ++r) {
+            data.update(ids[r % players], 1);
+            cache.refresh();
+        }
+    });
+
+    printf("%5u players, %7zu chars: format %8.1f us, copy %6.1f us, unchanged %.3f us, update + refresh %8.1f us\n",
+        players, second.text.size(), format / 1000, copy / 1000, unchanged / 1000, refresh / 1000);
+}
+
+int _tmain(int, TCHAR*[]) {
+    BenchPipes pipes;
+    const uint32_t players[] = { 20, 1000, MAX_PLAYERS_LIMIT };
+
+    if (!pipes.create(MAX_PLAYERS_LIMIT)) {
+        return 1;
+    }
+
+    for (uint32_t n : players) {
+        run(n);
+    }
+
+    printf("%s\n", failures == 0 ? "ok" : "FAILED");
+    return failures != 0;
+}
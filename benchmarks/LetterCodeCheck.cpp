@@ -0,0 +1,98 @@
+/*
+    Letter code check
+    Not a timing: checks the 1-byte letter encoding end to end. Prints the packet and board
+    sizes, runs the scalar and SSE2 guess kernels over random buffers (they must agree), and
+    takes every word of the built-in list through text -> letter codes -> index, embedded
+    hash, filter and back to text.
+*/
+
+#include "BenchWords.h"
+#include "..\WordGame_server\WordGame_server\GuessFilter.h"
+
+#define BUFFERS 2000000
+
+static int failures = 0;
+
+static void check(bool ok, const char* what, size_t i) {
+    if (!ok && failures++ < 10) {
+        printf("failed: %s (%zu)\n", what, i);
+    }
+}
+
+int _tmain(int, TCHAR*[]) {
+    std::mt19937 rng(9);
+    uint64_t valid = 0;
+
+    printf("Packet %zu bytes, GameState %zu bytes\n", sizeof(Packet), sizeof(GameState));
+
+    // Kernels agree on arbitrary bytes: mostly letters, some terminators, some garbage
+    for (size_t k = 0; k < BUFFERS; ++k) {
+        Letter g[GUESS_SIZE], a[GUESS_SIZE], b[GUESS_SIZE];
+        LetterSignature sa, sb;
+
+        for (Letter& x : g) {
+            int c = rng() % 40;
+            x = c < 28 ? (Letter)(rng() % LETTER_COUNT) : c < 36 ? LETTER_NONE : (Letter)rng();
+        }
+
+        bool ra = guessKernelScalar(g, a, sa);
+        bool rb = guessKernelSSE2(g, b, sb);
+        check(ra == rb, "kernels agree", k);
+
+        if (ra && rb) {
+            size_t n = 0;
+
+            while (g[n] != LETTER_NONE) {
+                ++n;
+            }
+
+            check(n <= MAX_WORD_LENGTH && memcmp(a, b, n + 1) == 0 && signatureEquals(sa, sb), "same word", k);
+            ++valid;
+        }
+    }
+
+    printf("kernels agree on %d random buffers (%llu valid guesses)\n", BUFFERS, (unsigned long long)valid);
+
+    // Every built-in word through the dictionary
+    std::vector<WordKey> keys;
+    std::vector<uint8_t> image;
+    wordKeysFromList(embedded_words, EMBEDDED_WORDS, keys);
+
+    const DictionaryHeader* d = benchCompile(keys, image);
+    WordIndex index;
+    GuessFilter filter;
+
+    if (d == NULL || !dictionaryValid(d, image.size())) {
+        printf("the built-in list does not compile\n");
+        return 1;
+    }
+
+    index.attach(d);
+    filter.build(d, 0.01);
+
+    for (size_t i = 0; i < EMBEDDED_WORDS; ++i) {
+        Letter l[GUESS_SIZE];
+        TCHAR text[GUESS_SIZE];
+        LetterSignature sig;
+
+        check(lettersFromText(embedded_words[i], l, GUESS_SIZE) && signatureFromLetters(l, sig), "encode", i);
+
+        int64_t w = index.find(l, sig);
+        check(w >= 0 && lettersEqual(dictionaryWord(d, (uint32_t)w), l), "index", i);
+        check(embeddedFind(l) == (int64_t)i && embeddedFind(embedded_words[i]) == (int64_t)i, "embedded hash", i);
+        check(filter.mayContain(l), "filter", i);
+
+        lettersToText(l, text, GUESS_SIZE);
+        check(_tcscmp(text, embedded_words[i]) == 0, "decode", i);
+    }
+
+    Letter bad[GUESS_SIZE];
+    check(!lettersFromText(TEXT("ab1"), bad, GUESS_SIZE), "reject a digit", 0);
+    check(!lettersFromText(TEXT(""), bad, GUESS_SIZE), "reject an empty guess", 0);
+    check(!lettersFromText(TEXT("abcdefghijklmnop"), bad, GUESS_SIZE), "reject a long guess", 0);
+    check(lettersFromText(TEXT("AbC"), bad, GUESS_SIZE) && bad[0] == 0 && bad[2] == 2 && bad[3] == LETTER_NONE, "fold case", 0);
+
+    printf("%u built-in words: index, embedded hash, filter and text agree\n", d->words);
+    printf("%s\n", failures == 0 ? "ok" : "FAILED");
+    return failures != 0;
+}
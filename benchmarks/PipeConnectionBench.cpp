@@ -0,0 +1,168 @@
+/*
+    Client connection benchmark
+    Time until every client has a broadcast packet, with 20 and 1000 clients, each a thread
+    serving its own named pipe the way the client's pipe thread does:
+    - old: the server opens the pipe for every packet, writes, waits on an ack read (the
+      client disconnects after one packet, so the read fails) and closes it
+    - new: the server keeps one ClientConnection per client and writes; the client reads
+      packets until the connection is closed
+    Usage: PipeConnectionBench [rounds]
+*/
+
+#include "Bench.h"
+#include "..\WordGame_server\WordGame_server\ClientConnection.h"
+
+#define ROUND_TIMEOUT 10000     // ms a round may take before the benchmark gives up
+
+struct BenchClient {
+    TCHAR name[2 * ARRAY_SIZE + 2];
+    HANDLE pipe;
+    HANDLE thread;
+    bool persistent;            // read until the server closes the connection
+};
+
+static volatile LONG received = 0;
+static volatile LONG expected = 0;
+static volatile LONG stopping = 0;
+static HANDLE all_received;
+
+void* clientThreadProc(void* param) {
+    BenchClient* c = (BenchClient*)param;
+
+    while (ConnectNamedPipe(c->pipe, NULL) || GetLastError() == ERROR_PIPE_CONNECTED) {
+        Packet p;
+        DWORD n = 0;
+
+        while (ReadFile(c->pipe, &p, sizeof(Packet), &n, NULL) && n == sizeof(Packet)) {
+            if (InterlockedIncrement(&received) == expected) {
+                SetEvent(all_received);
+            }
+
+            if (stopping) {
+                DisconnectNamedPipe(c->pipe);
+                return NULL;
+            }
+
+            if (!c->persistent) {
+                break;
+            }
+        }
+
+        DisconnectNamedPipe(c->pipe);
+    }
+
+    return NULL;
+}
+
+/**
+ * Broadcast as before the change: open, write, wait for the ack, close
+ */
+static void broadcastOld(std::vector<BenchClient>& clients, const Packet& p) {
+    for (BenchClient& c : clients) {
+        bool res;
+        HANDLE pipe = CreateFile(c.name, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, NULL);
+
+        if (pipe == INVALID_HANDLE_VALUE) {
+            continue;
+        }
+
+        if (WriteFile(pipe, &p, sizeof(Packet), NULL, NULL)) {
+            ReadFile(pipe, &res, sizeof(bool), NULL, NULL);
+        }
+
+        CloseHandle(pipe);
+    }
+}
+
+static void broadcastNew(std::vector<BenchClient>& clients, std::vector<ClientConnection>& connections, const Packet& p) {
+    for (size_t i = 0; i < clients.size(); ++i) {
+        connections[i].send(clients[i].name, &p);
+    }
+}
+
+static void run(uint32_t n, bool persistent, int rounds) {
+    std::vector<BenchClient> clients(n);
+    std::vector<ClientConnection> connections(persistent ? n : 0);
+    Samples call, delivery;
+    Packet p = { 0 };
+
+    p.code = GUESS;
+    stopping = 0;
+
+    for (uint32_t i = 0; i < n; ++i) {
+        BenchClient& c = clients[i];
+        _stprintf_s(c.name, TEXT("\\\\.\\pipe\\cb%u"), i);
+        c.persistent = persistent;
+        c.pipe = CreateNamedPipe(c.name, PIPE_ACCESS_DUPLEX, PIPE_TYPE_BYTE | PIPE_WAIT, 1,
+            CLIENT_PIPE_BUFFER, CLIENT_PIPE_BUFFER, 0, NULL);
+
+        if (c.pipe == INVALID_HANDLE_VALUE) {
+            _tprintf(TEXT("CreateNamedPipe %d\n"), GetLastError());
+            return;
+        }
+
+        c.thread = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)clientThreadProc, &c, 0, NULL);
+    }
+
+    // The first round connects (new) and wakes every thread once; it is not counted
+    for (int r = -1; r < rounds; ++r) {
+        bool last = r == rounds - 1;
+
+        received = 0;
+        expected = (LONG)n;
+        ResetEvent(all_received);
+
+        if (last) {
+            InterlockedExchange(&stopping, 1);  // the clients exit after this packet
+        }
+
+        double start = nowNs();
+
+        if (persistent) {
+            broadcastNew(clients, connections, p);
+        }
+        else {
+            broadcastOld(clients, p);
+        }
+
+        double returned = nowNs();
+
+        if (WaitForSingleObject(all_received, ROUND_TIMEOUT) != WAIT_OBJECT_0) {
+            printf("round %d: %ld of %u clients got the packet\n", r, received, n);
+        }
+
+        if (r >= 0) {
+            call.add(returned - start);
+            delivery.add(nowNs() - start);
+        }
+    }
+
+    printf("%4u clients, %s\n", n, persistent ? "persistent connection" : "pipe opened per packet");
+    call.print("  broadcast returns (us)");
+    delivery.print("  every client has it (us)");
+
+    for (ClientConnection& c : connections) {
+        c.close();
+    }
+
+    for (BenchClient& c : clients) {
+        WaitForSingleObject(c.thread, INFINITE);
+        CloseHandle(c.thread);
+        CloseHandle(c.pipe);
+    }
+}
+
+int _tmain(int argc, TCHAR* argv[]) {
+    int rounds = argc > 1 ? (int)_tcstoul(argv[1], NULL, 10) : 50;
+    const uint32_t clients[] = { 20, 1000 };
+
+    all_received = CreateEvent(NULL, TRUE, FALSE, NULL);
+
+    for (uint32_t n : clients) {
+        run(n, false, rounds);
+        run(n, true, rounds);
+    }
+
+    CloseHandle(all_received);
+    return 0;
+}
@@ -0,0 +1,175 @@
+/*
+    Player name table check
+    Not a timing: checks the shared name table the clients resolve broadcast IDs with.
+    - Lookups of players published before and after publishNames
+    - A player stays resolvable after leaving, until the slot is reused
+    - An ID whose slot was reused, ID 0 and an out of range ID are rejected
+    - Lock free lookups while players keep leaving and joining: a lookup either fails or
+      returns the name of the player that owned the ID, never a mix of two names. The churn
+      stops before a slot runs out of generations, when its IDs would start over
+    Usage: PlayerNameCheck [seconds of churn]
+*/
+
+#include "BenchPlayers.h"
+
+#define CAPACITY 64
+#define POOL (2 * CAPACITY)     // names taking turns in the table
+#define HISTORY 4000000         // IDs handed out during the churn
+
+static int failures = 0;
+
+static void check(bool ok, const char* what, size_t i) {
+    if (!ok && failures++ < 10) {
+        printf("failed: %s (%zu)\n", what, i);
+    }
+}
+
+/* Every ID handed out, with the pool index of its name; entries below count are written */
+struct Issued {
+    int32_t id;
+    uint32_t name;
+};
+
+static std::vector<Issued> issued(HISTORY);
+static volatile LONG count = 0;
+static volatile LONG stop = 0;
+static PlayerNameTable* table;
+
+struct LookupCounts {
+    uint64_t found;
+    uint64_t rejected;
+    uint64_t torn;
+};
+
+void* lookupThreadProc(void* param) {
+    LookupCounts* c = (LookupCounts*)param;
+    std::mt19937 rng(3);
+    TCHAR name[NAME_SIZE], expected[NAME_SIZE];
+
+    while (!stop) {
+        LONG n = count;
+        LONG i = (rng() & 1) ? n - 1 - (LONG)(rng() % (n < POOL ? n : POOL)) : (LONG)(rng() % n);    // recent or any
+        const Issued& e = issued[i];
+
+        if (!playerNameLookup(table, e.id, name)) {
+            ++c->rejected;
+            continue;
+        }
+
+        benchPlayerName(e.name, expected);
+
+        if (_tcscmp(name, expected) == 0) {
+            ++c->found;
+        }
+        else {
+            ++c->torn;
+        }
+    }
+
+    return NULL;
+}
+
+int _tmain(int argc, TCHAR* argv[]) {
+    DWORD seconds = argc > 1 ? _tcstoul(argv[1], NULL, 10) : 2;
+    BenchPipes pipes;
+    GameData data(CAPACITY);
+    std::vector<uint8_t> memory(playerNameTableSize(CAPACITY));
+    TCHAR name[NAME_SIZE], expected[NAME_SIZE];
+
+    table = (PlayerNameTable*)memory.data();
+
+    if (!pipes.create(POOL)) {
+        return 1;
+    }
+
+    // Players before and after the table is published
+    int32_t a = data.insert(TEXT("b0")).id;
+    data.publishNames(table);
+    int32_t b = data.insert(TEXT("b1")).id;
+
+    check(playerNameLookup(table, a, name) && _tcscmp(name, TEXT("b0")) == 0, "published before", 0);
+    check(playerNameLookup(table, b, name) && _tcscmp(name, TEXT("b1")) == 0, "published after", 0);
+    check(!data.setCapacity(CAPACITY / 2), "capacity fixed once players joined", 0);
+
+    // Leaving, then the slot reused
+    data.remove(b);
+    check(playerNameLookup(table, b, name) && _tcscmp(name, TEXT("b1")) == 0, "resolvable after leaving", 0);
+
+    int32_t c = data.insert(TEXT("b2")).id;
+    check((c & PLAYER_SLOT_MASK) == (b & PLAYER_SLOT_MASK) && c != b, "slot reused with a new ID", 0);
+    check(!playerNameLookup(table, b, name), "reject a reused slot", 0);
+    check(playerNameLookup(table, c, name) && _tcscmp(name, TEXT("b2")) == 0, "new owner", 0);
+    check(!playerNameLookup(table, 0, name), "reject ID 0", 0);
+    check(!playerNameLookup(table, (int32_t)(CAPACITY + 1), name), "reject a slot out of range", 0);
+
+    data.remove(a);
+    data.remove(c);
+
+    // Churn: fill the table, then replace random players while a thread looks IDs up
+    std::vector<uint32_t> live, idle;
+    std::vector<int32_t> live_ids;
+    std::mt19937 rng(5);
+
+    for (uint32_t i = 0; i < POOL; ++i) {
+        benchPlayerName(i, name);
+        Login_Return_Type r = data.insert(name);
+
+        if (r.flag == LOGIN && live.size() < CAPACITY) {
+            live.push_back(i);
+            live_ids.push_back(r.id);
+            issued[count] = { r.id, i };
+            InterlockedIncrement(&count);
+        }
+        else {
+            if (r.flag == LOGIN) {
+                data.remove(r.id);
+            }
+
+            idle.push_back(i);
+        }
+    }
+
+    LookupCounts counts = { 0 };
+    HANDLE reader = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)lookupThreadProc, &counts, 0, NULL);
+    double end = nowNs() + seconds * 1e9;
+    uint64_t churn = 0;
+
+    while (nowNs() < end && count < HISTORY) {
+        size_t out = rng() % live.size(), in = rng() % idle.size();
+
+        data.remove(live_ids[out]);
+        benchPlayerName(idle[in], name);
+        Login_Return_Type r = data.insert(name);
+
+        if (r.flag != LOGIN) {
+            check(false, "login during churn", churn);
+            break;
+        }
+
+        std::swap(live[out], idle[in]);
+        live_ids[out] = r.id;
+        issued[count] = { r.id, live[out] };
+        InterlockedIncrement(&count);
+        ++churn;
+
+        if (((uint32_t)r.id >> PLAYER_SLOT_BITS) == PLAYER_GENERATION_MASK) {
+            break;      // the next reuse of this slot would hand out its first ID again
+        }
+    }
+
+    InterlockedExchange(&stop, 1);
+    WaitForSingleObject(reader, INFINITE);
+    CloseHandle(reader);
+
+    // Every live player resolves to its own name
+    for (size_t i = 0; i < live.size(); ++i) {
+        benchPlayerName(live[i], expected);
+        check(playerNameLookup(table, live_ids[i], name) && _tcscmp(name, expected) == 0, "live player", i);
+    }
+
+    check(counts.torn == 0, "no torn names", 0);
+    printf("%llu players replaced; %llu lookups found, %llu rejected, %llu torn\n", (unsigned long long)churn,
+        (unsigned long long)counts.found, (unsigned long long)counts.rejected, (unsigned long long)counts.torn);
+    printf("%s\n", failures == 0 ? "ok" : "FAILED");
+    return failures != 0;
+}
@@ -0,0 +1,258 @@
+/*
+    Player table benchmark
+    GameData (slot array, flat name table, leaderboard tree) against the layout it replaced:
+    an ID map and a name map to the player, and a score multimap for the leaderboard. First
+    200k random logins, logouts and score changes run on both and must leave the same scores
+    and the same leaderboard order; then each operation is timed at 20, 1000 and 10000 players.
+*/
+
+#include "BenchPlayers.h"
+#include <map>
+
+#define CHECK_OPERATIONS 200000
+#define CHECK_PLAYERS 200
+#define TIMED_OPERATIONS 200000
+
+static volatile int64_t sink = 0;     // keeps the timed lookups
+
+/**
+ * The player maps GameData used before the slot array (scores only)
+ */
+class OldPlayerTable {
+    std::map<int32_t, std::wstring> id_map;
+    std::multimap<int32_t, std::wstring, std::greater<int32_t>> score_map;
+    std::map<std::wstring, std::pair<int32_t, int32_t>> name_map;   // name -> id, score
+    int32_t next_id = 0;
+
+public:
+    int32_t insert(const TCHAR* name) {
+        std::wstring n(name);
+
+        if (name_map.find(n) != name_map.end()) {
+            return -1;
+        }
+
+        name_map[n] = std::make_pair(++next_id, 0);
+        id_map[next_id] = n;
+        score_map.insert(std::make_pair(0, n));
+        return next_id;
+    }
+
+    bool remove(int32_t id) {
+        auto itr = id_map.find(id);
+
+        if (itr == id_map.end()) {
+            return false;
+        }
+
+        std::wstring name = itr->second;
+        id_map.erase(itr);
+
+        auto itr1 = name_map.find(name);
+        int32_t score = itr1->second.second;
+        name_map.erase(itr1);
+
+        auto range = score_map.equal_range(score);
+        for (auto i = range.first; i != range.second; ++i) {
+            if (i->second == name) {
+                score_map.erase(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool update(int32_t id, int32_t increment) {
+        auto itr = id_map.find(id);
+
+        if (itr == id_map.end()) {
+            return false;
+        }
+
+        std::wstring name = itr->second;
+        auto itr1 = name_map.find(name);
+        int32_t score = itr1->second.second;
+        int32_t new_score = (score + increment < 0) ? 0 : score + increment;
+        itr1->second.second = new_score;
+
+        auto range = score_map.equal_range(score);
+        for (auto i = range.first; i != range.second; ++i) {
+            if (i->second == name) {
+                score_map.erase(i);
+                score_map.insert(std::make_pair(new_score, name));
+                return true;
+            }
+        }
+        return false;
+    }
+
+    int32_t score(int32_t id) const {
+        auto itr = id_map.find(id);
+
+        if (itr == id_map.end()) {
+            return -1;
+        }
+
+        return name_map.find(itr->second)->second.second;
+    }
+
+    std::wstring str() const {
+        std::wstringstream ss;
+
+        for (auto& pr : score_map) {
+            ss << pr.second << L" " << pr.first << L"\n";
+        }
+
+        return ss.str();
+    }
+};
+
+static std::wstring leaderboard(const GameData& data) {
+    std::wstringstream ss;
+    std::vector<LeaderboardEntry> top;
+
+    data.leaders(-1, top);
+
+    for (const LeaderboardEntry& e : top) {
+        ss << e.name << L" " << e.score << L"\n";
+    }
+
+    return ss.str();
+}
+
+/**
+ * Random operations on both tables: same results, same leaderboard
+ */
+static bool check(std::mt19937& rng) {
+    GameData data(CHECK_PLAYERS);
+    OldPlayerTable old;
+    std::vector<std::pair<int32_t, int32_t>> in;    // new ID, old ID
+    std::vector<uint32_t> out;                      // benchmark players not logged in
+    TCHAR name[NAME_SIZE];
+    std::map<int32_t, uint32_t> player;             // new ID -> benchmark player
+
+    for (uint32_t i = 0; i < CHECK_PLAYERS; ++i) {
+        out.push_back(i);
+    }
+
+    for (int op = 0; op < CHECK_OPERATIONS; ++op) {
+        uint32_t r = rng() % 10;
+
+        if ((r == 0 || in.empty()) && !out.empty()) {
+            size_t j = rng() % out.size();
+            benchPlayerName(out[j], name);
+
+            Login_Return_Type l = data.insert(name);
+            int32_t o = old.insert(name);
+
+            if (l.flag != LOGIN || o < 0) {
+                printf("login %d differs\n", op);
+                return false;
+            }
+
+            player[l.id] = out[j];
+            in.push_back(std::make_pair(l.id, o));
+            out[j] = out.back();
+            out.pop_back();
+        }
+        else if (r == 1 && !in.empty()) {
+            size_t j = rng() % in.size();
+
+            if (!data.remove(in[j].first) || !old.remove(in[j].second) || data.remove(in[j].first)) {
+                printf("logout %d differs\n", op);
+                return false;
+            }
+
+            out.push_back(player[in[j].first]);
+            in[j] = in.back();
+            in.pop_back();
+        }
+        else if (!in.empty()) {
+            size_t j = rng() % in.size();
+            int32_t inc = (int32_t)(rng() % 7) - 2;
+
+            if (data.update(in[j].first, inc) != old.update(in[j].second, inc) ||
+                data.score(in[j].first) != old.score(in[j].second)) {
+                printf("score change %d differs\n", op);
+                return false;
+            }
+        }
+
+        if (op % 1000 == 0 && leaderboard(data) != old.str()) {
+            printf("leaderboards differ after %d operations\n", op);
+            return false;
+        }
+    }
+
+    return leaderboard(data) == old.str();
+}
+
+static void run(uint32_t n, std::mt19937& rng) {
+    GameData data(n);
+    OldPlayerTable old;
+    std::vector<int32_t> ids, oldIds;
+    std::vector<uint32_t> picks(TIMED_OPERATIONS);
+    TCHAR name[NAME_SIZE];
+
+    benchLogin(data, n, ids);
+
+    for (uint32_t i = 0; i < n; ++i) {
+        benchPlayerName(i, name);
+        oldIds.push_back(old.insert(name));
+    }
+
+    for (uint32_t& p : picks) {
+        p = rng() % n;
+    }
+
+    // Every score starts at 0: the old update scans all the players with the same score
+    double updateOld = nsPerOp(TIMED_OPERATIONS, [&] { for (uint32_t p : picks) old.update(oldIds[p], 1); });
+    double updateNew = nsPerOp(TIMED_OPERATIONS, [&] { for (uint32_t p : picks) data.update(ids[p], 1); });
+    double scoreOld = nsPerOp(TIMED_OPERATIONS, [&] { for (uint32_t p : picks) sink += old.score(oldIds[p]); });
+    double scoreNew = nsPerOp(TIMED_OPERATIONS, [&] { for (uint32_t p : picks) sink += data.score(ids[p]); });
+
+    // A player leaves and the same player logs in again
+    const int rejoins = TIMED_OPERATIONS / 10;
+    double rejoinOld = nsPerOp(rejoins, [&] {
+        for (int i = 0; i < rejoins; ++i) {
+            uint32_t p = picks[i];
+            benchPlayerName(p, name);
+            old.remove(oldIds[p]);
+            oldIds[p] = old.insert(name);
+        }
+    });
+    double rejoinNew = nsPerOp(rejoins, [&] {
+        for (int i = 0; i < rejoins; ++i) {
+            uint32_t p = picks[i];
+            benchPlayerName(p, name);
+            data.remove(ids[p]);
+            ids[p] = data.insert(name).id;
+        }
+    });
+
+    printf("%5u players   update %8.0f -> %5.0f   score %6.0f -> %3.0f   leave+join %8.0f -> %5.0f\n",
+        n, updateOld, updateNew, scoreOld, scoreNew, rejoinOld, rejoinNew);
+}
+
+int _tmain(int, TCHAR*[]) {
+    std::mt19937 rng(11);
+    BenchPipes pipes;
+    const uint32_t sizes[] = { 20, 1000, MAX_PLAYERS_LIMIT };
+
+    if (!pipes.create(MAX_PLAYERS_LIMIT)) {
+        return 1;
+    }
+
+    if (!check(rng)) {
+        return 1;
+    }
+
+    printf("%d random operations: same scores and leaderboard as the old maps\n", CHECK_OPERATIONS);
+    printf("ns per operation, old maps -> slot array\n");
+
+    for (uint32_t n : sizes) {
+        run(n, rng);
+    }
+
+    return 0;
+}
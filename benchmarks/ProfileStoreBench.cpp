@@ -0,0 +1,150 @@
+/*
+    Profile store benchmark
+    Creates a store of 1M profiles (file size, buckets and fill), reopens it, and looks the
+    profiles up in random order the way logins do; then looks up the profiles of a small
+    store, whose pages stay in cache. Lookups check the values written at creation.
+    The store files are created in the current directory and deleted at the end.
+    Usage: ProfileStoreBench [profiles]
+*/
+
+#include "Bench.h"
+#include "..\WordGame_server\WordGame_server\ProfileStore.h"
+
+#define SMALL 100
+
+static const TCHAR* largePath = TEXT("bench_profiles.dat");
+static const TCHAR* smallPath = TEXT("bench_profiles_small.dat");
+
+static volatile int64_t sink;
+static int failures = 0;
+
+static void check(bool ok, const char* what, size_t i) {
+    if (!ok && failures++ < 10) {
+        printf("failed: %s (%zu)\n", what, i);
+    }
+}
+
+/**
+ * Print the size of a closed store and how full its buckets are
+ */
+static void printFile(const TCHAR* path) {
+    ProfileStoreHeader h = { 0 };
+    LARGE_INTEGER size = { 0 };
+    DWORD read = 0;
+    HANDLE file = CreateFile(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if (file == INVALID_HANDLE_VALUE) {
+        return;
+    }
+
+    GetFileSizeEx(file, &size);
+    ReadFile(file, &h, sizeof(h), &read, NULL);
+    CloseHandle(file);
+
+    printf("file %.1f MB, %u buckets of %d, %.0f%% full\n", (double)size.QuadPart / (1 << 20), h.buckets,
+        PROFILE_BUCKET_SLOTS, 100.0 * (double)h.count / ((double)h.buckets * PROFILE_BUCKET_SLOTS));
+}
+
+int _tmain(int argc, TCHAR* argv[]) {
+    uint32_t n = argc > 1 ? _tcstoul(argv[1], NULL, 10) : 1000000;
+    std::vector<std::wstring> names(n);
+    TCHAR name[NAME_SIZE];
+
+    for (uint32_t i = 0; i < n; ++i) {
+        _stprintf_s(name, TEXT("p%u"), i);
+        names[i] = name;
+    }
+
+    DeleteFile(largePath);
+    DeleteFile(smallPath);
+
+    // Create
+    {
+        ProfileStore store;
+
+        if (!store.open(largePath)) {
+            return 1;
+        }
+
+        double start = nowNs();
+
+        for (uint32_t i = 0; i < n; ++i) {
+            PlayerProfile* p = store.create(names[i].c_str());
+
+            if (p == NULL) {
+                check(false, "create", i);
+                break;
+            }
+
+            p->sessions += 1;
+            p->total_score += i;
+        }
+
+        printf("create %u profiles: %.0f ns each\n", n, (nowNs() - start) / n);
+        check(store.count() == n, "count", 0);
+        store.close();
+    }
+
+    printFile(largePath);
+
+    // Reopen, then log everybody in again in random order
+    {
+        ProfileStore store;
+        std::vector<uint32_t> order(n);
+        std::mt19937 rng(17);
+
+        double start = nowNs();
+        check(store.open(largePath), "reopen", 0);
+        printf("reopen: %.1f ms\n", (nowNs() - start) / 1e6);
+
+        for (uint32_t i = 0; i < n; ++i) {
+            order[i] = i;
+        }
+
+        std::shuffle(order.begin(), order.end(), rng);
+        start = nowNs();
+
+        for (uint32_t i : order) {
+            PlayerProfile* p = store.create(names[i].c_str());
+            check(p != NULL && p->total_score == i && p->sessions == 1, "profile kept", i);
+
+            if (p != NULL) {
+                p->sessions += 1;
+                sink += p->total_score;
+            }
+        }
+
+        printf("login lookup, random order: %.0f ns each\n", (nowNs() - start) / n);
+        check(store.find(TEXT("ninguem")) == NULL, "unknown name", 0);
+        store.close();
+    }
+
+    // A small store for comparison
+    {
+        ProfileStore store;
+
+        if (!store.open(smallPath)) {
+            return 1;
+        }
+
+        for (uint32_t i = 0; i < SMALL && i < n; ++i) {
+            store.create(names[i].c_str());
+        }
+
+        double ns = nsPerOp(100 * SMALL, [&] {
+            for (int r = 0; r < 100; ++r) {
+                for (uint32_t i = 0; i < SMALL && i < n; ++i) {
+                    sink += store.find(names[i].c_str()) != NULL;
+                }
+            }
+        });
+
+        printf("lookup in a %d profile store: %.0f ns each\n", SMALL, ns);
+        store.close();
+    }
+
+    DeleteFile(largePath);
+    DeleteFile(smallPath);
+    printf("%s\n", failures == 0 ? "ok" : "FAILED");
+    return failures != 0;
+}
@@ -0,0 +1,93 @@
+/*
+    Rank change benchmark
+    Checks that the ranks GameData::update reports in a RankChange are the ranks
+    GameData::rank gives before and after, over random score changes among 50 players,
+    and counts the MVP and TOP_RANK announcements they would raise. Then times update at
+    20 and MAX_PLAYERS_LIMIT players without and with a RankChange.
+*/
+
+#include "BenchPlayers.h"
+
+#define CHECKED_PLAYERS 50
+#define CHECKED_UPDATES 20000
+#define UPDATES 200000
+
+static int failures = 0;
+
+static void check(bool ok, const char* what, size_t i) {
+    if (!ok && failures++ < 10) {
+        printf("failed: %s (%zu)\n", what, i);
+    }
+}
+
+static void checkRanks() {
+    GameData data(CHECKED_PLAYERS);
+    std::vector<int32_t> ids;
+    std::mt19937 rng(19);
+    int mvp = 0, top = 0;
+
+    if (!benchLogin(data, CHECKED_PLAYERS, ids)) {
+        check(false, "login", 0);
+        return;
+    }
+
+    for (int r = 0; r < CHECKED_UPDATES; ++r) {
+        int32_t id = ids[rng() % CHECKED_PLAYERS];
+        int32_t before = data.rank(id);
+        RankChange change;
+
+        data.update(id, 1, &change);
+        check((int32_t)change.before == before && (int32_t)change.after == data.rank(id), "ranks reported", r);
+
+        // as announceRankChange decides
+        if (change.after == 1 && change.before != 1) {
+            ++mvp;
+        }
+        else if (change.after <= LEADERBOARD_TOP && change.before > LEADERBOARD_TOP) {
+            ++top;
+        }
+    }
+
+    printf("%d updates among %d players: ranks match, %d MVP and %d TOP_RANK\n", CHECKED_UPDATES, CHECKED_PLAYERS, mvp, top);
+}
+
+static double updateCost(uint32_t players, bool ranks) {
+    GameData data(players);
+    std::vector<int32_t> ids;
+    RankChange change;
+
+    if (!benchLogin(data, players, ids)) {
+        check(false, "login", players);
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < players; ++i) {
+        data.update(ids[i], (int32_t)(i % 97));
+    }
+
+    return nsPerOp(UPDATES, [&] {
+        for (uint32_t r = 0; r < UPDATES; ++r) {
+            data.update(ids[(r * 7919u) % players], 1, ranks ? &change : NULL);
+        }
+    });
+}
+
+int _tmain(int, TCHAR*[]) {
+    BenchPipes pipes;
+    const uint32_t players[] = { 20, MAX_PLAYERS_LIMIT };
+
+    if (!pipes.create(MAX_PLAYERS_LIMIT)) {
+        return 1;
+    }
+
+    checkRanks();
+
+    for (uint32_t n : players) {
+        double without = updateCost(n, false);
+        double with = updateCost(n, true);
+        printf("%5u players: update %.0f ns, with the rank change %.0f ns\n", n, without, with);
+    }
+
+    printf("%s\n", failures == 0 ? "ok" : "FAILED");
+    return failures != 0;
+}
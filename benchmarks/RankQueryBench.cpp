@@ -0,0 +1,109 @@
+/*
+    Rank query benchmark
+    Checks rank, standing, ranked and scoreForRank against a full in-order walk of the
+    leaderboard through random score changes, logouts and logins, then times each query at
+    the largest player capacity against building the whole leaderboard string.
+*/
+
+#include "BenchPlayers.h"
+
+#define PLAYERS MAX_PLAYERS_LIMIT
+#define CHECK_ROUNDS 20000
+#define TIMED_QUERIES 100000
+
+static volatile int64_t sink = 0;
+
+/**
+ * Compare the queries of a few random players with the in-order walk
+ */
+static bool checkQueries(const GameData& data, const std::vector<int32_t>& ids, std::mt19937& rng) {
+    std::vector<LeaderboardEntry> top;
+    std::vector<uint32_t> order;      // benchmark players, highest score first
+    data.leaders(-1, top);
+
+    for (const LeaderboardEntry& e : top) {
+        order.push_back((uint32_t)_tcstoul(e.name + 1, NULL, 10));
+    }
+
+    for (int i = 0; i < 4; ++i) {
+        uint32_t pos = rng() % order.size();            // 0-based rank of the player
+        int32_t id = ids[order[pos]];
+        uint32_t want = 1 + rng() % order.size();       // rank to reach
+        PlayerStanding st;
+        int32_t need = want > pos ? top[pos].score : top[want - 1].score + 1;
+
+        if (data.rank(id) != (int32_t)pos + 1 || !data.standing(id, st) || st.rank != (int32_t)pos + 1 ||
+            st.players != (int32_t)order.size() || st.score != top[pos].score ||
+            st.next != (pos == 0 ? 0 : top[pos - 1].score + 1 - top[pos].score) ||
+            data.scoreForRank(id, want) != need) {
+            return false;
+        }
+
+        uint32_t first = 1 + rng() % order.size(), n = 0;
+        bool same = true;
+
+        data.ranked(first, first + 9, [&](const Player& p, uint32_t rank) {
+            same = same && rank == first + n && _tcscmp(p.name, top[rank - 1].name) == 0;
+            ++n;
+        });
+
+        if (!same || n != (std::min)(10u, (uint32_t)order.size() - first + 1)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int _tmain(int, TCHAR*[]) {
+    std::mt19937 rng(12);
+    BenchPipes pipes;
+    GameData data(PLAYERS);
+    std::vector<int32_t> ids;
+    TCHAR name[NAME_SIZE];
+
+    if (!pipes.create(PLAYERS) || !benchLogin(data, PLAYERS, ids)) {
+        return 1;
+    }
+
+    for (int round = 0; round < CHECK_ROUNDS; ++round) {
+        uint32_t p = rng() % PLAYERS;
+
+        if (rng() % 50 == 0) {      // leave and come back with score 0
+            benchPlayerName(p, name);
+            data.remove(ids[p]);
+            ids[p] = data.insert(name).id;
+        }
+        else {
+            data.update(ids[p], (int32_t)(rng() % 9) - 3);
+        }
+
+        if (round % 100 == 0 && !checkQueries(data, ids, rng)) {
+            printf("queries differ from the in-order walk after %d changes\n", round);
+            return 1;
+        }
+    }
+
+    printf("%d players, %d changes: queries match the in-order walk\n", PLAYERS, CHECK_ROUNDS);
+
+    std::vector<uint32_t> picks(TIMED_QUERIES);
+    for (uint32_t& p : picks) {
+        p = rng() % PLAYERS;
+    }
+
+    PlayerStanding st;
+    double rank = nsPerOp(TIMED_QUERIES, [&] { for (uint32_t p : picks) sink += data.rank(ids[p]); });
+    double standing = nsPerOp(TIMED_QUERIES, [&] { for (uint32_t p : picks) sink += data.standing(ids[p], st) + st.rank + st.next; });
+    double forRank = nsPerOp(TIMED_QUERIES, [&] { for (uint32_t p : picks) sink += data.scoreForRank(ids[p], 1 + p % 100); });
+    double range = nsPerOp(TIMED_QUERIES, [&] {
+        for (uint32_t p : picks) data.ranked(p + 1, p + 10, [](const Player& pl, uint32_t) { sink += pl.score; });
+    });
+    double full = nsPerOp(20, [&] { for (int i = 0; i < 20; ++i) sink += data.str().size(); });
+
+    printf("rank             %8.2f us\n", rank / 1000);
+    printf("standing         %8.2f us\n", standing / 1000);
+    printf("scoreForRank     %8.2f us\n", forRank / 1000);
+    printf("10 ranks         %8.2f us\n", range / 1000);
+    printf("whole str()      %8.2f us\n", full / 1000);
+    return 0;
+}
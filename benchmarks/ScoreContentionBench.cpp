@@ -0,0 +1,137 @@
+/*
+    Score request contention benchmark
+    Threads answer SCORE requests as fast as they can while a guess flood changes scores:
+    each guess takes data_handle, updates the score and holds the lock for a simulated
+    broadcast. The requests are answered first the old way (taking data_handle) and then
+    the way handleScoreRequest does now (lock free read). Reports requests per second and
+    request latency.
+    Usage: ScoreContentionBench [seconds per run] [broadcast us]
+*/
+
+#include "BenchPlayers.h"
+
+#define PLAYERS MAX_PLAYERS_LIMIT
+#define GUESS_GAP_NS 20000.0    // work outside the lock between two guesses
+#define SAMPLE_EVERY 64         // requests per latency sample
+
+static GameData data(PLAYERS);
+static HANDLE data_handle;
+static std::vector<int32_t> ids;
+static volatile LONG stop = 0;
+static bool locked;             // answer requests under data_handle
+static double hold_ns = 200000;
+static volatile LONG64 guesses = 0;
+
+struct ReaderState {
+    uint32_t seed;
+    uint64_t requests;
+    Samples latency;
+};
+
+void* guessFloodThreadProc(void*) {
+    std::mt19937 rng(1);
+
+    while (!stop) {
+        WaitForSingleObject(data_handle, INFINITE);
+        data.update(ids[rng() % PLAYERS], 1);
+        spinNs(hold_ns);    // broadcast under the lock
+        ReleaseMutex(data_handle);
+
+        InterlockedIncrement64(&guesses);
+        spinNs(GUESS_GAP_NS);
+    }
+
+    return NULL;
+}
+
+void* scoreRequestThreadProc(void* param) {
+    ReaderState* r = (ReaderState*)param;
+    std::mt19937 rng(r->seed);
+
+    while (!stop) {
+        int32_t id = ids[rng() % PLAYERS];
+        double start = nowNs();
+        int32_t score;
+
+        if (locked) {
+            WaitForSingleObject(data_handle, INFINITE);
+            score = data.score(id);
+            ReleaseMutex(data_handle);
+        }
+        else {
+            score = data.score(id);
+        }
+
+        if (++r->requests % SAMPLE_EVERY == 0) {
+            r->latency.add(nowNs() - start);
+        }
+
+        if (score < 0) {
+            printf("player %d not found\n", id);
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+static void run(int readers, bool underLock, DWORD seconds) {
+    std::vector<ReaderState> state(readers);
+    std::vector<HANDLE> threads;
+    Samples latency;
+    uint64_t requests = 0;
+
+    locked = underLock;
+    stop = 0;
+    guesses = 0;
+
+    threads.push_back(CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)guessFloodThreadProc, NULL, 0, NULL));
+
+    for (int i = 0; i < readers; ++i) {
+        state[i].seed = 7 + i;
+        state[i].requests = 0;
+        threads.push_back(CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)scoreRequestThreadProc, &state[i], 0, NULL));
+    }
+
+    Sleep(seconds * 1000);
+    InterlockedExchange(&stop, 1);
+    WaitForMultipleObjects((DWORD)threads.size(), threads.data(), TRUE, INFINITE);
+
+    for (HANDLE h : threads) {
+        CloseHandle(h);
+    }
+
+    for (ReaderState& r : state) {
+        requests += r.requests;
+        latency.merge(r.latency);
+    }
+
+    printf("%2d readers, %-9s %10.0f requests/s %7.0f guesses/s\n", readers, underLock ? "mutex" : "lock free",
+        (double)requests / seconds, (double)guesses / seconds);
+    latency.print("  request latency (us)");
+}
+
+int _tmain(int argc, TCHAR* argv[]) {
+    BenchPipes pipes;
+    DWORD seconds = argc > 1 ? _tcstoul(argv[1], NULL, 10) : 2;
+    const int readers[] = { 1, 4, 16 };
+
+    if (argc > 2) {
+        hold_ns = 1000.0 * _tcstoul(argv[2], NULL, 10);
+    }
+
+    data_handle = CreateMutex(NULL, FALSE, NULL);
+
+    if (data_handle == NULL || !pipes.create(PLAYERS) || !benchLogin(data, PLAYERS, ids)) {
+        return 1;
+    }
+
+    printf("%d players, guesses hold data_handle for %.0f us\n", PLAYERS, hold_ns / 1000);
+
+    for (int n : readers) {
+        run(n, true, seconds);
+        run(n, false, seconds);
+    }
+
+    return 0;
+}
@@ -0,0 +1,78 @@
+/*
+    Solution set benchmark
+    Rebuilds the set of formable words for random boards and checks every set against brute
+    force (each dictionary word tested against the board). Reports the average rebuild time
+    and number of solutions, for the server's word list with uniform 10-letter boards and for
+    a dense random list with 12-letter boards.
+*/
+
+#include "BenchWords.h"
+#include "..\WordGame_server\WordGame_server\SolutionSet.h"
+
+#define BOARDS 1000
+#define CHECKED_BOARDS 100
+
+/**
+ * Check the set against every word of the dictionary
+ */
+static bool checkSet(const DictionaryHeader* d, const SolutionSet& set, const LetterSignature& board) {
+    uint32_t count = 0;
+
+    for (uint32_t i = 0; i < d->words; ++i) {
+        LetterSignature sig;
+        bool fits = signatureFromLetters(dictionaryWord(d, i), sig) && signatureFits(sig, board);
+
+        if (fits != set.contains(i)) {
+            return false;
+        }
+
+        count += fits;
+    }
+
+    return count == set.count();
+}
+
+static bool run(const char* label, const std::vector<WordKey>& keys, int letters, bool dense, std::mt19937& rng) {
+    std::vector<uint8_t> image;
+    const DictionaryHeader* d = benchCompile(keys, image);
+    SolutionSet set;
+    Samples rebuild;
+    uint64_t solutions = 0;
+
+    if (d == NULL) {
+        return false;
+    }
+
+    set.reset(d);
+
+    for (int b = 0; b < BOARDS; ++b) {
+        LetterSignature board = randomBoard(rng, letters, dense);
+        double start = nowNs();
+
+        set.rebuild(d, board);
+        rebuild.add(nowNs() - start);
+        solutions += set.count();
+
+        if (b < CHECKED_BOARDS && !checkSet(d, set, board)) {
+            printf("%s: board %d differs from brute force\n", label, b);
+            return false;
+        }
+    }
+
+    printf("%s: %u words, %d-letter boards, %.0f solutions per board (first %d checked)\n",
+        label, d->words, letters, (double)solutions / BOARDS, CHECKED_BOARDS);
+    rebuild.print("  rebuild (us)");
+    return true;
+}
+
+int _tmain(int argc, TCHAR* argv[]) {
+    std::mt19937 rng(5);
+    std::vector<WordKey> keys;
+
+    if (!benchWordList(argc, argv, keys) || !run("word list", keys, 10, false, rng)) {
+        return 1;
+    }
+
+    denseWordList(rng, 200000, keys);
+    return run("dense list", keys, 12, true, rng) ? 0 : 1;
+}
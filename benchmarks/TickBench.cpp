@@ -0,0 +1,119 @@
+/*
+    Tick publication benchmark
+    Times what game() does to publish one tick, without the board update itself, for
+    20, 1000 and MAX_PLAYERS_LIMIT players:
+    - old: take all N + 2 permits of the state semaphore one wait at a time, set every
+      player's update event, release the N + 2 permits
+    - new: take the state mutex, write the board under the sequence counter, release the
+      mutex, set this tick's event and rearm the other one
+    The player events are reset between ticks, as a client waiting on them would, outside
+    the timed section.
+    Usage: TickBench [ticks per run]
+*/
+
+#include "Bench.h"
+
+static volatile int64_t sink;
+
+/**
+ * Publication cost with one semaphore permit per player and one event per player
+ */
+static void runOld(int players, int ticks) {
+    LONG permits = players + 2;
+    HANDLE semaphore = CreateSemaphore(NULL, permits, permits, NULL);
+    std::vector<HANDLE> events(players);
+    Samples cost;
+
+    for (HANDLE& e : events) {
+        e = CreateEvent(NULL, FALSE, FALSE, NULL);
+    }
+
+    for (int t = 0; t < ticks; ++t) {
+        double start = nowNs();
+
+        for (LONG i = 0; i < permits; ++i) {
+            WaitForSingleObject(semaphore, INFINITE);
+        }
+
+        for (HANDLE e : events) {
+            SetEvent(e);
+        }
+
+        ReleaseSemaphore(semaphore, permits, NULL);
+        cost.add(nowNs() - start);
+
+        for (HANDLE e : events) {
+            ResetEvent(e);      // consumed by the client
+        }
+    }
+
+    cost.print("  old, publication (us)");
+
+    for (HANDLE e : events) {
+        CloseHandle(e);
+    }
+
+    CloseHandle(semaphore);
+}
+
+/**
+ * Publication cost with the state mutex and the two tick events
+ */
+static void runNew(int ticks) {
+    HANDLE mutex = CreateMutex(NULL, FALSE, NULL);
+    HANDLE tick_events[2] = { CreateEvent(NULL, TRUE, FALSE, NULL), CreateEvent(NULL, TRUE, FALSE, NULL) };
+    GameState* state = new GameState();
+    Samples cost;
+
+    state->t = BOARD_SIZE;
+    state->epoch = 1;
+
+    for (int t = 0; t < ticks; ++t) {
+        double start = nowNs();
+
+        WaitForSingleObject(mutex, INFINITE);
+
+        uint32_t tick = state->tick + 1;
+        int i = tick % BOARD_SIZE;
+        ResetEvent(tick_events[(tick + 1) & 1]);
+        InterlockedIncrement(&state->sequence);
+        state->array[i] = (Letter)(tick % LETTER_COUNT);
+        state->tick = tick;
+
+        BoardDelta& change = state->log[tick % BOARD_LOG_SIZE];
+        change.tick = tick;
+        change.position = (uint8_t)i;
+        change.letter = state->array[i];
+        change.flags = 0;
+        InterlockedIncrement(&state->sequence);
+
+        ReleaseMutex(mutex);
+
+        SetEvent(tick_events[tick & 1]);
+        cost.add(nowNs() - start);
+    }
+
+    sink += state->tick;
+
+    cost.print("  new, publication (us)");
+
+    delete state;
+    CloseHandle(tick_events[0]);
+    CloseHandle(tick_events[1]);
+    CloseHandle(mutex);
+}
+
+int _tmain(int argc, TCHAR* argv[]) {
+    int ticks = argc > 1 ? (int)_tcstoul(argv[1], NULL, 10) : 500;
+    const int players[] = { 20, 1000, MAX_PLAYERS_LIMIT };
+
+    printf("%d ticks per run\n", ticks);
+
+    for (int n : players) {
+        printf("%d players\n", n);
+        runOld(n, ticks);
+        runNew(ticks);
+    }
+
+    return 0;
+}
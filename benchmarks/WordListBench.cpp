@@ -0,0 +1,131 @@
+/*
+    Word list loading benchmark
+    Writes a large word list (5M lines by default, or the count given on the command line)
+    with duplicates, uppercase words, CRLF line ends and lines that are not words, then loads
+    it with the old path (fgets, a wstring per word, sort, unique) and with readWordList.
+    Both must keep the same words.
+*/
+
+#include "BenchWords.h"
+
+#define BENCH_LIST_FILE TEXT("wordlist.bench.txt")
+
+/**
+ * The loader before the mapped, parallel one, kept here to compare against
+ */
+static bool readWordListOld(const TCHAR* path, std::vector<std::wstring>& words) {
+    FILE* inputFile;
+    TCHAR buffer[BUFFER_SIZE];
+    Letter letters[MAX_WORD_LENGTH + 1];
+
+    if (_tfopen_s(&inputFile, path, _T("r")) != 0) {
+        return false;
+    }
+
+    words.clear();
+
+    while (_fgetts(buffer, BUFFER_SIZE, inputFile) != NULL) {
+        int len = (int)_tcslen(buffer);
+
+        while (len > 0 && (buffer[len - 1] == _T('\n') || buffer[len - 1] == _T('\r'))) {
+            buffer[--len] = _T('\0');
+        }
+
+        for (int i = 0; i < len; ++i) {
+            if (buffer[i] >= _T('A') && buffer[i] <= _T('Z')) {
+                buffer[i] += _T('a') - _T('A');
+            }
+        }
+
+        if (!lettersFromText(buffer, letters, MAX_WORD_LENGTH + 1)) {
+            continue;
+        }
+
+        words.push_back(buffer);
+    }
+
+    fclose(inputFile);
+
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+    return true;
+}
+
+/**
+ * Write the list
+ *
+ * @return Size in bytes, 0 if it cannot be written
+ */
+static long long writeList(const TCHAR* path, uint64_t lines, std::mt19937& rng) {
+    FILE* f;
+    char word[MAX_WORD_LENGTH + 8];
+
+    if (_tfopen_s(&f, path, _T("wb")) != 0) {
+        return 0;
+    }
+
+    for (uint64_t i = 0; i < lines; ++i) {
+        int len = 1 + rng() % (MAX_WORD_LENGTH + 2);      // some are too long
+
+        for (int j = 0; j < len; ++j) {
+            word[j] = (char)('a' + rng() % 10 + (rng() % 4 == 0 ? rng() % 16 : 0));
+        }
+
+        switch (rng() % 50) {
+        case 0: word[0] = (char)toupper(word[0]); break;
+        case 1: word[len / 2] = '7'; break;        // not a word
+        case 2: len = 0; break;                     // empty line
+        }
+
+        word[len] = '\0';
+        fprintf(f, rng() % 8 == 0 ? "%s\r\n" : "%s\n", word);
+    }
+
+    long long size = ftell(f);
+    fclose(f);
+    return size;
+}
+
+int _tmain(int argc, TCHAR* argv[]) {
+    std::mt19937 rng(10);
+    uint64_t lines = argc > 1 ? _tcstoul(argv[1], NULL, 10) : 5000000;
+    std::vector<std::wstring> words;
+    std::vector<WordKey> keys, oldKeys;
+
+    long long size = writeList(BENCH_LIST_FILE, lines, rng);
+
+    if (size == 0) {
+        printf("cannot write the list\n");
+        return 1;
+    }
+
+    printf("%llu lines, %.1f MB\n", (unsigned long long)lines, size / 1048576.0);
+
+    double start = nowNs();
+    bool ok = readWordListOld(BENCH_LIST_FILE, words);
+    double old = (nowNs() - start) / 1e6;
+
+    start = nowNs();
+    ok = ok && readWordList(BENCH_LIST_FILE, keys);
+    double mapped = (nowNs() - start) / 1e6;
+
+    DeleteFile(BENCH_LIST_FILE);
+
+    for (const std::wstring& w : words) {
+        WordKey key;
+
+        if (wordKeyFromText(w.c_str(), w.size(), key)) {
+            oldKeys.push_back(key);
+        }
+    }
+
+    if (!ok || oldKeys != keys) {
+        printf("the loaders disagree\n");
+        return 1;
+    }
+
+    printf("%zu unique words, both loaders agree\n", keys.size());
+    printf("fgets, wstring, sort: %8.0f ms\n", old);
+    printf("readWordList:         %8.0f ms\n", mapped);
+    return 0;
+}
@@ -0,0 +1,13 @@
+@echo off
+rem Build the benchmarks from a Developer Command Prompt (x64)
+rem Usage: build.bat [name]    builds name.vcxproj, or every benchmark without a name
+rem The projects are also part of WordGame_server.sln; the settings are in Benchmark.props
+setlocal
+set FLAGS=/nologo /v:minimal /p:Configuration=Release /p:Platform=x64
+
+if not "%~1"=="" (
+    msbuild %FLAGS% %~1.vcxproj
+    goto :eof
+)
+
+for %%f in (*.vcxproj) do msbuild %FLAGS% %%f
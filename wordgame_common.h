@@ -19,13 +19,84 @@
 #define DEBUG
 #define ARRAY_SIZE 10
 #define BUFFER_SIZE 256
-#define MAX_PLAYERS 20
+#define MAX_PLAYERS 20              // default player capacity (registry JOGADORES overrides it)
+#define MAX_PLAYERS_LIMIT 10000     // highest player capacity a server accepts
 #define MAX_WORD_LENGTH 12
-#define MAX_WORDS 128
+#define NAME_SIZE (ARRAY_SIZE + 2)  // characters of a player name in a packet, terminator included
+#define BOARD_SIZE 16               // board positions in shared memory (at least MAX_WORD_LENGTH)
+#define GUESS_SIZE 16               // letters of a guess in a packet, terminator included
+#define LETTER_COUNT 26             // letter codes 0 (a) to 25 (z)
+#define LETTER_NONE 0xFF            // empty board position, end of a letter string
 #define _CRT_SECURE_NO_WARNINGS
 
 typedef std::function<void(const TCHAR*)> cmd;
 
+/*
+    Letters are one byte codes (a = 0 ... z = 25) on the board, in the dictionary and in
+    guesses; text only exists at the console. Strings of letters end with LETTER_NONE.
+*/
+typedef uint8_t Letter;
+
+/**
+ * Get the code of a character (either case), LETTER_NONE if it is not a letter a-z
+ */
+inline Letter letterFromChar(TCHAR c) {
+    if (c >= L'a' && c <= L'z') {
+        return (Letter)(c - L'a');
+    }
+
+    if (c >= L'A' && c <= L'Z') {
+        return (Letter)(c - L'A');
+    }
+
+    return LETTER_NONE;
+}
+
+/**
+ * Get the lowercase character of a letter code
+ */
+inline TCHAR letterToChar(Letter l) {
+    return (TCHAR)(L'a' + l);
+}
+
+/**
+ * Encode a word typed at the console
+ *
+ * @param text Null terminated word
+ * @param letters Receives the LETTER_NONE terminated letters
+ * @param size Room in letters, terminator included
+ * @return false if text is empty, too long or has a character outside a-z/A-Z
+ */
+inline bool lettersFromText(const TCHAR* text, Letter* letters, size_t size) {
+    size_t i = 0;
+
+    for (; text[i] != TEXT('\0'); ++i) {
+        if (i + 1 >= size || (letters[i] = letterFromChar(text[i])) == LETTER_NONE) {
+            return false;
+        }
+    }
+
+    letters[i] = LETTER_NONE;
+    return i > 0;
+}
+
+/**
+ * Decode letters for display
+ *
+ * @param letters LETTER_NONE terminated letters
+ * @param text Receives the null terminated word
+ * @param size Room in text, terminator included
+ */
+inline void lettersToText(const Letter* letters, TCHAR* text, size_t size) {
+    size_t i = 0;
+
+    for (; i + 1 < size && letters[i] < LETTER_COUNT; ++i) {
+        text[i] = letterToChar(letters[i]);
+    }
+
+    text[i] = TEXT('\0');
+}
+
 struct Login_Return_Type {
     int32_t flag;
     int32_t id;
@@ -43,28 +114,367 @@ enum MsgFlags {
     PLAYER_LOGIN,
     PLAYER_LOGOUT,
     SCORE,
-    LIST
+    LIST,
+    RANK,
+    TOP_RANK
 };
 
 struct Packet {
     uint32_t code;
-    int32_t id;
-    TCHAR buffer[BUFFER_SIZE];
+    int32_t id;                         // Player ID in PLAYER_LOGIN, PLAYER_LOGOUT, GUESS, MVP and TOP_RANK broadcasts
+    union {
+        TCHAR buffer[NAME_SIZE];        // Player name (LOGIN)
+        Letter letters[GUESS_SIZE];     // Guessed word (GUESS sent by a client)
+        struct {
+            Letter letters[GUESS_SIZE]; // Guessed word (same place as letters)
+            uint32_t epoch;             // Board epoch the guess was made against (0 if unknown)
+        } guess;                        // GUESS sent by a client
+        int32_t score;                  // New score of the player (GUESS and MVP broadcasts)
+        struct {
+            int32_t score;              // New score of the player (same place as score)
+            int32_t rank;               // New rank of the player
+        } standing;                     // MVP (took the lead) and TOP_RANK (entered the top LEADERBOARD_TOP) broadcasts
+        struct {
+            int32_t players;            // Players in the game
+            int32_t score;              // Score of the player
+            int32_t next;               // Points missing to climb one rank (0 if first)
+        } rank;                         // RANK reply (id holds the rank, 0 if unknown)
+        struct {
+            uint32_t version;           // Leaderboard version the client has (request, 0 if none) or that follows (reply)
+            uint32_t length;            // Characters of leaderboard text following the reply (0 if unchanged)
+        } list;                         // LIST request and reply
+    };
 };
 
-struct Dictionary {
-    TCHAR words[MAX_WORDS][MAX_WORD_LENGTH + 1];
+#define CLIENT_PIPE_BUFFER (16 * sizeof(Packet))    // client pipe buffer: events queued while the client is busy
+
+/*
+    The board is a seqlock: the server makes the sequence odd while it writes the board and
+    never waits for a client; a client copies the board and starts over if the sequence was
+    odd or moved meanwhile, so a slow or crashed client cannot hold up a tick.
+    Each tick writes one position, clearing the board first after a correct guess; the change
+    is also kept in a small log, so a client that has the board of a recent tick applies the
+    changes since instead of copying it whole. The epoch counts the solved boards: the guess
+    that solves a board moves it at once (the next tick clears the letters), a guess carries
+    the epoch of the board it was made against, and one made before the last solve is stale.
+*/
+#define BOARD_LOG_SIZE 16       // board changes kept for clients catching up
+#define BOARD_CLEARED 0x01      // BoardDelta flag: the board was cleared before the letter was placed
+
+struct BoardDelta {
+    uint32_t tick;              // Tick that made the change
+    uint8_t position;           // Position written
+    Letter letter;              // Letter placed there
+    uint8_t flags;              // BOARD_CLEARED
+    uint8_t reserved;
 };
 
 struct GameState {
-    uint32_t t;         // Number of characters
-    TCHAR array[BUFFER_SIZE];
+    volatile LONG sequence;     // odd while the server writes
+    uint32_t t;                 // Number of positions in play
+    Letter array[BOARD_SIZE];   // Letter codes, LETTER_NONE where empty
+    volatile uint32_t tick;     // Ticks published so far; tickEventNames[tick & 1] is set for the latest
+    uint32_t epoch;             // Boards solved so far, plus 1 once the game started
+    BoardDelta log[BOARD_LOG_SIZE];     // change of tick n in log[n % BOARD_LOG_SIZE]
+};
+
+/**
+ * Copy the board from shared memory
+ *
+ * @param state Shared game state
+ * @param board Receives a consistent copy (positions, letters and tick)
+ */
+inline void gameStateRead(const GameState* state, GameState& board) {
+    LONG s;
+
+    do {
+        while ((s = state->sequence) & 1) {
+            YieldProcessor();   // being written
+        }
+
+        MemoryBarrier();
+        memcpy(&board, (const void*)state, sizeof(GameState));
+        MemoryBarrier();        // the copy happens before the sequence is checked again
+    } while (state->sequence != s);
+
+    board.t = board.t > BOARD_SIZE ? BOARD_SIZE : board.t;
+}
+
+/**
+ * Bring a copy of the board up to date
+ * Applies the changes logged since the tick of the copy; the board is copied whole
+ * if there is no copy yet (epoch 0) or changes were missed (more than BOARD_LOG_SIZE ticks)
+ *
+ * @param state Shared game state
+ * @param board Copy to update (positions, letters, tick and epoch; the log is not kept)
+ * @return Changes applied, -1 if the board was copied whole
+ */
+inline int gameStateUpdate(const GameState* state, GameState& board) {
+    BoardDelta changes[BOARD_LOG_SIZE];
+    uint32_t tick, epoch, t, count;
+    LONG s;
+
+    do {
+        while ((s = state->sequence) & 1) {
+            YieldProcessor();   // being written
+        }
+
+        MemoryBarrier();
+        tick = state->tick;
+        epoch = state->epoch;
+        t = state->t;
+        count = tick - board.tick;
+
+        if (board.epoch == 0 || count > BOARD_LOG_SIZE) {
+            count = UINT32_MAX;
+        }
+        else {
+            for (uint32_t i = 0; i < count; ++i) {
+                changes[i] = state->log[(board.tick + 1 + i) % BOARD_LOG_SIZE];
+            }
+        }
+        MemoryBarrier();        // the copy happens before the sequence is checked again
+    } while (state->sequence != s);
+
+    if (count == UINT32_MAX) {
+        gameStateRead(state, board);    // missed changes: start over from the whole board
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+        if (changes[i].flags & BOARD_CLEARED) {
+            memset(board.array, LETTER_NONE, sizeof(board.array));
+        }
+
+        if (changes[i].position < BOARD_SIZE) {
+            board.array[changes[i].position] = changes[i].letter;
+        }
+    }
+
+    board.tick = tick;
+    board.epoch = epoch;
+    board.t = t > BOARD_SIZE ? BOARD_SIZE : t;
+    return (int)count;
+}
+
+/*
+    Player names are interned by the server in a shared table indexed by the slot of the
+    player ID, so broadcasts carry the 32 bit ID and clients resolve names locally.
+    An entry belongs to the ID stored in it; the server stores the ID after the name and
+    clears it before the slot is reused, so a copy framed by two equal reads of the ID is whole.
+    Entries outlive their player until the slot is reused, so PLAYER_LOGOUT can still be resolved.
+*/
+#define PLAYER_SLOT_BITS 18                             // low bits of a player ID: slot
+#define PLAYER_SLOT_MASK ((1u << PLAYER_SLOT_BITS) - 1)
+
+struct PlayerNameEntry {
+    volatile LONG id;           // Player ID owning the entry, 0 if none
+    TCHAR name[NAME_SIZE];      // Player name
+};
+
+struct PlayerNameTable {
+    uint32_t capacity;                  // Entries in the table (player capacity of the server)
+    PlayerNameEntry entries[1];         // capacity entries, one per player slot
+};
+
+/**
+ * Get the size of a name table
+ */
+inline size_t playerNameTableSize(uint32_t capacity) {
+    return sizeof(PlayerNameTable) + (capacity > 0 ? capacity - 1 : 0) * sizeof(PlayerNameEntry);
+}
+
+/**
+ * Look up a player name by ID in the shared name table
+ *
+ * @param table Name table
+ * @param id Player ID
+ * @param name Receives the name (NAME_SIZE characters)
+ * @return false if the ID does not own an entry (unknown, or its slot was reused)
+ */
+inline bool playerNameLookup(const PlayerNameTable* table, int32_t id, TCHAR* name) {
+    uint32_t slot = (uint32_t)id & PLAYER_SLOT_MASK;
+
+    if (id <= 0 || slot >= table->capacity) {
+        return false;
+    }
+
+    const PlayerNameEntry& e = table->entries[slot];
+
+    if (e.id != id) {
+        return false;
+    }
+
+    memcpy(name, e.name, NAME_SIZE * sizeof(TCHAR));
+    MemoryBarrier();            // the copy happens before the ID is checked again
+
+    if (e.id != id) {
+        return false;
+    }
+
+    name[NAME_SIZE - 1] = TEXT('\0');
+    return true;
+}
+
+/*
+    The server also publishes the top of the leaderboard and every player's score in a shared
+    page, so clients list and check scores without asking it. The page is a seqlock: the server
+    makes the sequence odd while it writes, and a reader copies what it needs and starts over
+    if the sequence was odd or moved meanwhile.
+*/
+#define LEADERBOARD_TOP 10      // players on the shared leaderboard page
+
+struct LeaderboardTopEntry {
+    int32_t id;                 // Player ID
+    int32_t score;              // Score
+    TCHAR name[NAME_SIZE];      // Player name
+};
+
+struct LeaderboardTop {
+    uint32_t version;           // Leaderboard version (as in LIST replies)
+    uint32_t players;           // Players in the game
+    uint32_t count;             // Entries in use (min(players, LEADERBOARD_TOP))
+    LeaderboardTopEntry entries[LEADERBOARD_TOP];   // highest score first
+};
+
+struct PlayerScoreEntry {
+    int32_t id;                 // Player ID in the slot, 0 if none
+    int32_t score;              // Score of the player
+};
+
+struct LeaderboardPage {
+    volatile LONG sequence;     // odd while the server writes
+    uint32_t capacity;          // Entries in scores (player capacity of the server)
+    LeaderboardTop top;
+    PlayerScoreEntry scores[1]; // capacity entries, one per player slot
+};
+
+/**
+ * Get the size of a leaderboard page
+ */
+inline size_t leaderboardPageSize(uint32_t capacity) {
+    return sizeof(LeaderboardPage) + (capacity > 0 ? capacity - 1 : 0) * sizeof(PlayerScoreEntry);
+}
+
+/**
+ * Copy the top of the leaderboard from the shared page
+ *
+ * @param page Leaderboard page
+ * @param top Receives the top players, their number and the version
+ */
+inline void leaderboardPageTop(const LeaderboardPage* page, LeaderboardTop& top) {
+    LONG s;
+
+    do {
+        while ((s = page->sequence) & 1) {
+            YieldProcessor();   // being written
+        }
+
+        MemoryBarrier();
+        memcpy(&top, &page->top, sizeof(LeaderboardTop));
+        MemoryBarrier();        // the copy happens before the sequence is checked again
+    } while (page->sequence != s);
+
+    top.count = top.count > LEADERBOARD_TOP ? LEADERBOARD_TOP : top.count;
+}
+
+/**
+ * Look up a player's score in the shared page
+ *
+ * @param page Leaderboard page
+ * @param id Player ID
+ * @return Score, -1 if the ID is not in the game
+ */
+inline int32_t leaderboardPageScore(const LeaderboardPage* page, int32_t id) {
+    uint32_t slot = (uint32_t)id & PLAYER_SLOT_MASK;
+    PlayerScoreEntry e;
+    LONG s;
+
+    if (id <= 0 || slot >= page->capacity) {
+        return -1;
+    }
+
+    do {
+        while ((s = page->sequence) & 1) {
+            YieldProcessor();
+        }
+
+        MemoryBarrier();
+        e.id = page->scores[slot].id;
+        e.score = page->scores[slot].score;
+        MemoryBarrier();
+    } while (page->sequence != s);
+
+    return e.id == id ? e.score : -1;
+}
+
+/*
+    Events for every player (PLAYER_LOGIN, PLAYER_LOGOUT, GUESS, MVP, TOP_RANK and the server's
+    LOGOUT at shutdown) are written once by the server into a ring in shared memory, and each
+    client reads them at its own cursor. Event n goes in slot n % EVENT_RING_SIZE, whose sequence
+    is odd (2n + 1) while the server writes it and 2n + 2 once written; a reader that finds a
+    higher sequence was lapped (more than EVENT_RING_SIZE events behind) and resyncs at the head.
+    Packets for one player (replies, exit orders) still go over its pipe.
+*/
+#define EVENT_RING_SIZE 1024    // events kept in the shared ring
+
+struct EventSlot {
+    volatile LONG64 sequence;   // 2n + 2 once event n is written, odd while it is written
+    int32_t except;             // Player the event is not for, 0 = none
+    Packet packet;
+};
+
+struct EventRing {
+    volatile LONG64 head;       // Events written so far; eventSignalNames[head & 1] is set for the latest
+    EventSlot slots[EVENT_RING_SIZE];
+};
+
+enum EventRingRead {
+    EVENT_PENDING,              // not written yet
+    EVENT_READY,                // copied
+    EVENT_OVERRUN               // overwritten: the reader fell too far behind
 };
 
+/**
+ * Copy an event from the shared ring
+ *
+ * @param ring Event ring
+ * @param n Number of the event (the reader's cursor)
+ * @param out Receives the event
+ */
+inline EventRingRead eventRingRead(const EventRing* ring, uint64_t n, EventSlot& out) {
+    const EventSlot& slot = ring->slots[n % EVENT_RING_SIZE];
+    LONG64 written = 2 * (LONG64)n + 2;
+    LONG64 s;
+
+    while ((s = slot.sequence) == written - 1) {
+        YieldProcessor();       // being written
+    }
+
+    if (s < written) {
+        return EVENT_PENDING;
+    }
+
+    if (s > written) {
+        return EVENT_OVERRUN;
+    }
+
+    MemoryBarrier();
+    out.except = slot.except;
+    out.packet = slot.packet;
+    MemoryBarrier();            // the copy happens before the sequence is checked again
+
+    return slot.sequence == written ? EVENT_READY : EVENT_OVERRUN;
+}
+
 const TCHAR* serverPipeName = TEXT("\\\\.\\pipe\\wordguess_pipe");
 const TCHAR* sharedMemoryName = TEXT("Local\\shm");	// shared memory file name
-const TCHAR* updatedSemaphoreName = TEXT("Local\\shm_semaphore");
+const TCHAR* tickEventNames[2] = { TEXT("Local\\shm_tick0"), TEXT("Local\\shm_tick1") };   // manual reset, one per tick parity
 const TCHAR* dictionaryName = TEXT("Local\\dictionary"); // path of word dictionary
+const TCHAR* playerNamesName = TEXT("Local\\player_names"); // shared player name table
+const TCHAR* leaderboardPageName = TEXT("Local\\leaderboard"); // shared leaderboard page
+const TCHAR* eventRingName = TEXT("Local\\events");  // shared event ring
+const TCHAR* eventSignalNames[2] = { TEXT("Local\\events0"), TEXT("Local\\events1") };  // manual reset, one per head parity
 LPTSTR botPath = _tcsdup(L"..\\..\\WordGame_client.cpp\\x64\\Release\\WordGame_client.cpp.exe");
 
 /**
@@ -0,0 +1,292 @@
+#ifndef _wordgame_dictionary_h_
+#define _wordgame_dictionary_h_
+
+#include "wordgame_common.h"
+
+/*
+    Compiled dictionary image
+    Same layout on disk (words.dict), in shared memory and when built from the
+    dictionary embedded in the server, so the server and the bots map it read-only
+    instead of parsing a word list.
+    Each loaded dictionary is published as its own mapping, dictionaryName.<generation>;
+    the dictionaryName mapping itself only holds a DictionaryDirectory telling the bots
+    which generation is current, so a reload never changes an image a bot has mapped.
+
+    +--------------------+  0
+    | DictionaryHeader   |
+    +--------------------+  header.offsets
+    | uint32_t[words]    |  offset of each word in the pool, in letters
+    +--------------------+  header.pool
+    | Letter pool        |  LETTER_NONE terminated letter codes of the words, sorted
+    +--------------------+  header.index
+    | DictionarySlot[]   |  open addressing table keyed by letter signature hash
+    +--------------------+  header.dawg
+    | uint32_t[edges]    |  DAWG edges (see below)
+    | uint32_t[edges]    |  words reachable through each edge
+    +--------------------+  header.size
+
+    DAWG: the words as a minimal automaton (trie sharing prefixes and suffixes).
+    A node is a run of edges sorted by letter, the last one flagged DAWG_LAST.
+    Edge 0 is unused so that child 0 means "no children"; the root starts at edge 1.
+    Because the words are sorted, adding up the reachable word counts of the edges
+    skipped on the way gives the number of the word reached.
+*/
+
+#define DICTIONARY_MAGIC 0x54434457    // "WDCT"
+#define DICTIONARY_VERSION 3
+#define DICTIONARY_FILE_NAME TEXT("words.dict")
+#define DICTIONARY_NAME_SIZE 64     // room for dictionaryName.<generation>
+
+#define DAWG_LETTER 0x1Fu           // letter of the edge (a = 0)
+#define DAWG_TERMINAL 0x20u         // a word ends after this edge
+#define DAWG_LAST 0x40u             // last edge of its node
+#define DAWG_CHILD_SHIFT 7          // first edge of the child node (0 = none)
+#define DAWG_MAX_EDGES (1u << (32 - DAWG_CHILD_SHIFT))
+
+struct DictionaryHeader {
+    uint32_t magic;         // DICTIONARY_MAGIC
+    uint32_t version;       // DICTIONARY_VERSION
+    uint32_t words;         // Number of words
+    uint32_t index_slots;   // Number of index slots (power of two)
+    uint32_t offsets;       // Byte offset of the offset table
+    uint32_t pool;          // Byte offset of the string pool
+    uint32_t index;         // Byte offset of the lookup index
+    uint32_t dawg;          // Byte offset of the DAWG edges (followed by their word counts)
+    uint32_t dawg_edges;    // Number of DAWG edges, including the unused edge 0
+    uint32_t size;          // Total image size in bytes
+};
+
+struct DictionarySlot {
+    uint32_t hash;          // Low 32 bits of the word's letter signature hash
+    uint32_t word;          // Word number + 1, 0 marks an empty slot
+};
+
+struct DictionaryDirectory {
+    volatile LONG generation;   // Generation of the current image, set after it is mapped
+};
+
+/**
+ * Get the name of the mapping holding the image of a dictionary generation
+ *
+ * @param name Receives the name
+ * @param size Size of name in characters (DICTIONARY_NAME_SIZE)
+ * @param generation Dictionary generation
+ */
+inline void dictionaryImageName(TCHAR* name, size_t size, uint32_t generation) {
+    _stprintf_s(name, size, TEXT("%s.%u"), dictionaryName, generation);
+}
+
+/**
+ * Check that every DAWG edge points inside the edge table, every node is terminated and
+ * the reachable word counts add up (sections must already be known to fit)
+ * An edge counts 1 if a word ends there plus the counts of its child node, and the root
+ * node's counts add up to the number of words, so a walk only yields numbers below it
+ */
+inline bool dawgValid(const DictionaryHeader* d) {
+    const uint32_t* edges = (const uint32_t*)((const uint8_t*)d + d->dawg);
+    const uint32_t* reach = edges + d->dawg_edges;
+    uint64_t root = 0;
+
+    for (uint32_t i = 1; i < d->dawg_edges; ++i) {
+        if ((edges[i] >> DAWG_CHILD_SHIFT) >= d->dawg_edges || (edges[i] & DAWG_LETTER) >= 26) {
+            return false;
+        }
+    }
+
+    if (d->dawg_edges == 1) {
+        return d->words == 0;
+    }
+
+    if ((edges[d->dawg_edges - 1] & DAWG_LAST) == 0) {
+        return false;   // a node would run off the table
+    }
+
+    for (uint32_t i = 1; i < d->dawg_edges; ++i) {
+        uint64_t expected = (edges[i] & DAWG_TERMINAL) ? 1 : 0;
+        uint32_t child = edges[i] >> DAWG_CHILD_SHIFT;
+
+        for (uint32_t at = child; child != 0; ++at) {
+            expected += reach[at];
+
+            if (edges[at] & DAWG_LAST) {
+                break;
+            }
+        }
+
+        if (reach[i] != expected) {
+            return false;
+        }
+    }
+
+    for (uint32_t at = 1; ; ++at) {
+        root += reach[at];
+
+        if (edges[at] & DAWG_LAST) {
+            break;
+        }
+    }
+
+    return root == d->words;
+}
+
+/**
+ * Check the words and the index of an image (sections must already be known to fit)
+ * The pool holds words of 1 to MAX_WORD_LENGTH letter codes, each LETTER_NONE terminated
+ * (then the alignment padding of the index), every offset is the start of one of them and
+ * every index slot is empty or holds a word number below words, with an empty slot left so
+ * that a probe always ends
+ */
+inline bool dictionaryWordsValid(const DictionaryHeader* d) {
+    const uint32_t* offsets = (const uint32_t*)((const uint8_t*)d + d->offsets);
+    const Letter* pool = (const Letter*)((const uint8_t*)d + d->pool);
+    const DictionarySlot* slots = (const DictionarySlot*)((const uint8_t*)d + d->index);
+    uint32_t letters = d->index - d->pool;
+    uint32_t length = 0;
+    uint32_t used = 0;
+
+    // The pool ends with the last terminator; the index alignment pads it with at most 7 bytes
+    while (letters > 0 && pool[letters - 1] != LETTER_NONE && d->index - d->pool - letters < 7) {
+        letters -= 1;
+    }
+
+    if (letters > 0 && pool[letters - 1] != LETTER_NONE) {
+        return false;   // the last word would run off the pool
+    }
+
+    for (uint32_t i = 0; i < letters; ++i) {
+        if (pool[i] == LETTER_NONE) {
+            if (length == 0) {
+                return false;   // empty word
+            }
+
+            length = 0;
+        }
+        else if (pool[i] >= LETTER_COUNT || ++length > MAX_WORD_LENGTH) {
+            return false;
+        }
+    }
+
+    for (uint32_t i = 0; i < d->words; ++i) {
+        if (offsets[i] >= letters || (offsets[i] != 0 && pool[offsets[i] - 1] != LETTER_NONE)) {
+            return false;
+        }
+    }
+
+    for (uint32_t i = 0; i < d->index_slots; ++i) {
+        if (slots[i].word > d->words) {
+            return false;
+        }
+
+        used += slots[i].word != 0;
+    }
+
+    return used <= d->words;    // index_slots > words: one slot at least is empty
+}
+
+/**
+ * Check that an image is a dictionary this build understands, that its sections fit and
+ * that nothing they hold leads a reader outside the image (one pass over it, once per load)
+ *
+ * @param d Mapped image
+ * @param size Number of bytes mapped
+ * @return true if the image can be used
+ */
+inline bool dictionaryValid(const DictionaryHeader* d, uint64_t size) {
+    if (d == NULL || size < sizeof(DictionaryHeader)) {
+        return false;
+    }
+
+    if (d->magic != DICTIONARY_MAGIC || d->version != DICTIONARY_VERSION || d->size > size) {
+        return false;
+    }
+
+    if (d->index_slots == 0 || (d->index_slots & (d->index_slots - 1)) != 0 || d->index_slots <= d->words) {
+        return false;
+    }
+
+    return d->offsets >= sizeof(DictionaryHeader) &&
+           (uint64_t)d->offsets + (uint64_t)d->words * sizeof(uint32_t) <= d->pool &&
+           d->pool <= d->index &&
+           (uint64_t)d->index + (uint64_t)d->index_slots * sizeof(DictionarySlot) <= d->dawg &&
+           d->dawg_edges >= 1 && d->dawg_edges <= DAWG_MAX_EDGES &&
+           (uint64_t)d->dawg + 2 * (uint64_t)d->dawg_edges * sizeof(uint32_t) <= d->size &&
+           dictionaryWordsValid(d) &&
+           dawgValid(d);
+}
+
+/**
+ * Get a word of the dictionary
+ *
+ * @param d Dictionary image
+ * @param i Word number (0 <= i < d->words)
+ * @return LETTER_NONE terminated letters
+ */
+inline const Letter* dictionaryWord(const DictionaryHeader* d, uint32_t i) {
+    const uint32_t* offsets = (const uint32_t*)((const uint8_t*)d + d->offsets);
+    const Letter* pool = (const Letter*)((const uint8_t*)d + d->pool);
+    return pool + offsets[i];
+}
+
+/**
+ * Get the lookup index of the dictionary
+ *
+ * @param d Dictionary image
+ * @return First of d->index_slots slots
+ */
+inline const DictionarySlot* dictionaryIndex(const DictionaryHeader* d) {
+    return (const DictionarySlot*)((const uint8_t*)d + d->index);
+}
+
+/**
+ * Walk the DAWG from one node, only along letters still available
+ */
+template <typename F>
+void dawgWalkFrom(const uint32_t* edges, const uint32_t* reach, uint32_t at, uint32_t base, uint8_t* counts, F& f) {
+    for (;; ++at) {
+        uint32_t e = edges[at];
+        uint32_t letter = e & DAWG_LETTER;
+
+        if (counts[letter] != 0) {
+            uint32_t child = e >> DAWG_CHILD_SHIFT;
+            uint32_t terminal = (e & DAWG_TERMINAL) ? 1 : 0;
+
+            counts[letter] -= 1;
+
+            if (terminal) {
+                f(base);    // the word spelled so far
+            }
+
+            if (child != 0) {
+                dawgWalkFrom(edges, reach, child, base + terminal, counts, f);
+            }
+
+            counts[letter] += 1;
+        }
+
+        base += reach[at];  // words through this edge come before the next one
+
+        if (e & DAWG_LAST) {
+            return;
+        }
+    }
+}
+
+/**
+ * Call f(word number) for every word that can be spelled with the given letters
+ * Depth first walk of the DAWG that never follows a letter whose count is used up,
+ * so only prefixes the letters can form are ever visited
+ *
+ * @param d Dictionary image
+ * @param counts Available count of each letter (a = 0), restored on return
+ * @param f Callback
+ */
+template <typename F>
+void dawgWalk(const DictionaryHeader* d, uint8_t counts[26], F f) {
+    const uint32_t* edges = (const uint32_t*)((const uint8_t*)d + d->dawg);
+
+    if (d->dawg_edges > 1) {
+        dawgWalkFrom(edges, edges + d->dawg_edges, 1, 0, counts, f);
+    }
+}
+
+#endif